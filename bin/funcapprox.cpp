@@ -2,20 +2,161 @@
 // Created by Dean Calver on 11/04/2016.
 //
 #include "core/core.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <boost/log/trivial.hpp>
 #include <boost/range/irange.hpp>
 #include <array>
 #include "core/vectoralu.h"
 #include "realfunc.h"
+#include "inferenceserver.h"
 #include "machinelearning/machinelearning.h"
 #include "machinelearning/ANNetwork.h"
-#include "machinelearning/InputLayer.h"
+#include "machinelearning/inputlayer.h"
+#include "machinelearning/hiddenlayer.h"
+#include "machinelearning/outputlayer.h"
+#include "machinelearning/connections.h"
+#include "machinelearning/modelpublisher.h"
+#include "machinelearning/adaptivesampler.h"
 
-int main() {
+namespace {
+    InferenceServer *sServer = nullptr;
+
+    void stopServer( int ) {
+        if( sServer != nullptr ) { sServer->stop( ); }
+    }
+
+    void usage() {
+        std::cerr << "usage: funcapprox\n"
+                  << "       funcapprox train <model file>\n"
+                  << "       funcapprox serve <model file> <socket path> [max batch size] [max delay us]\n";
+    }
+
+    // fits the sine RealFunc over [-pi, pi], the sigmoid output layer means the target is scaled into (0, 1)
+    int train( const std::string &modelFile ) {
+        using namespace Core;
+        using namespace MachineLearning;
+
+        auto inLayer  = std::make_shared<InputLayer>( 1 );
+        auto hidLayer = std::make_shared<HiddenLayer>( 16 );
+        auto outLayer = std::make_shared<OutputLayer>( 1 );
+
+        ANNetwork nn;
+        nn.addLayer( inLayer );
+        nn.addLayer( hidLayer );
+        nn.addLayer( outLayer );
+        nn.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        nn.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        nn.finalise( true, 32 );
+        nn.setRandomWeights( );
+
+        // half the samples spread evenly over the domain, the rest where that first fit is worst
+        RealFunc          f;
+        const size_t      samples = 1024, validation = 256;
+        AdaptiveSampler   sampler( { real( -M_PI ) }, { real( M_PI ) }, AdaptiveSampler::Config( ) );
+        std::vector<real> xs( samples ), ys( samples );
+        std::vector<ANNetwork::MatchingPair> trainingSet;
+        const auto addSamples = [ & ]( const size_t first, const size_t last ) {
+            for( size_t i = first; i < last; ++i ) {
+                ys[ i ] = real( 0.5 ) + (real( 0.4 ) * f( xs[ i ] ));
+                trainingSet.emplace_back( &xs[ i ], &ys[ i ] );
+            }
+        };
+        sampler.sampleSobol( samples / 2, xs.data( ) );
+        addSamples( 0, samples / 2 );
+
+        // the reported test error is over a held out set, a differently seeded Sobol sequence shares no points
+        AdaptiveSampler::Config heldOutConfig;
+        heldOutConfig.seed = ~heldOutConfig.seed;
+        AdaptiveSampler   heldOut( { real( -M_PI ) }, { real( M_PI ) }, heldOutConfig );
+        std::vector<real> testXs( validation ), testYs( validation );
+        std::vector<ANNetwork::MatchingPair> testSet;
+        heldOut.sampleSobol( validation, testXs.data( ) );
+        for( size_t i = 0; i < validation; ++i ) {
+            testYs[ i ] = real( 0.5 ) + (real( 0.4 ) * f( testXs[ i ] ));
+            testSet.emplace_back( &testXs[ i ], &testYs[ i ] );
+        }
+
+        nn.supervisedTrain( trainingSet, testSet );
+
+        std::vector<real> checkXs( validation ), checkYs( validation ), errors( validation );
+        sampler.sampleSobol( validation, checkXs.data( ) );
+        InferenceSession session( validation );
+        session.evaluate( *nn.createModel( ), validation, checkXs.data( ), checkYs.data( ) );
+        for( size_t i = 0; i < validation; ++i ) {
+            errors[ i ] = std::fabs( checkYs[ i ] - (real( 0.5 ) + (real( 0.4 ) * f( checkXs[ i ] ))) );
+        }
+        sampler.recordResiduals( validation, checkXs.data( ), errors.data( ) );
+
+        sampler.sample( samples - (samples / 2), xs.data( ) + (samples / 2) );
+        addSamples( samples / 2, samples );
+        nn.supervisedTrain( trainingSet, testSet );
+
+        if( !nn.createModel( )->save( modelFile ) ) {
+            std::cerr << "failed to write " << modelFile << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    int serve( const std::string &modelFile, const InferenceServer::Config &config ) {
+        using namespace MachineLearning;
+
+        auto model = Model::load( modelFile );
+        if( !model ) {
+            std::cerr << "failed to load " << modelFile << "\n";
+            return 1;
+        }
+
+        ModelPublisher  publisher( model );
+        InferenceServer server( publisher, config );
+        if( !server.open( ) ) {
+            std::cerr << "failed to listen on " << config.socketPath << ": " << std::strerror( errno ) << "\n";
+            return 1;
+        }
+
+        sServer = &server;
+        std::signal( SIGINT, stopServer );
+        std::signal( SIGTERM, stopServer );
+        BOOST_LOG_TRIVIAL(info) << "serving " << modelFile << " on " << config.socketPath;
+        server.run( );
+        sServer = nullptr;
+
+        server.report( std::cout );
+        return 0;
+    }
+}
+
+int main( int argc, char *argv[] ) {
     using namespace Core;
     BOOST_LOG_TRIVIAL(trace) << "funcapprox main starting...";
 
+    if( argc >= 3 && std::string( argv[ 1 ] ) == "train" ) {
+        return train( argv[ 2 ] );
+    }
+    if( argc >= 4 && std::string( argv[ 1 ] ) == "serve" ) {
+        InferenceServer::Config config;
+        config.socketPath = argv[ 3 ];
+        try {
+            if( argc >= 5 ) { config.maxBatchSize = std::max( 1ul, std::stoul( argv[ 4 ] ) ); }
+            if( argc >= 6 ) { config.maxDelayMicroseconds = uint32_t( std::stoul( argv[ 5 ] ) ); }
+        } catch( const std::logic_error & ) { // not a number or out of range
+            usage( );
+            return 1;
+        }
+        return serve( argv[ 2 ], config );
+    }
+    if( argc > 1 ) {
+        usage( );
+        return 1;
+    }
+
     std::shared_ptr<VectorALU> alu = VectorALUFactory();
     RealFunc f;
     for (auto x : boost::irange(-5000, 5000, 1)) {
@@ -29,4 +170,4 @@ int main() {
 
     BOOST_LOG_TRIVIAL(trace) << "funcapprox main ending";
     return 0;
-}
\ No newline at end of file
+}
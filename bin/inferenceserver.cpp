@@ -0,0 +1,476 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "core/core.h"
+#include "core/trace.h"
+#include "inferenceserver.h"
+
+namespace {
+    // epoll keys below firstConnectionKey are the servers own descriptors
+    const uint64_t listenKey          = 0;
+    const uint64_t stopKey            = 1;
+    const uint64_t timerKey           = 2;
+    const uint64_t firstConnectionKey = 3;
+
+    // anything bigger is a corrupt stream rather than a real model
+    const uint32_t maxFrameCount = 1u << 20;
+
+    uint64_t nanoseconds( const std::chrono::steady_clock::duration d ) {
+        return uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>( d ).count( ) );
+    }
+
+    void closeIfOpen( int &fd ) {
+        if( fd >= 0 ) {
+            ::close( fd );
+            fd = -1;
+        }
+    }
+}
+
+InferenceServer::InferenceServer( MachineLearning::ModelPublisher &_publisher, const Config &_config ) :
+        publisher( _publisher ),
+        config( _config ),
+        reader( _publisher.createReader( ) ),
+        session( _config.maxBatchSize ),
+        listenFd( -1 ),
+        epollFd( -1 ),
+        stopFd( -1 ),
+        timerFd( -1 ),
+        timerArmed( false ),
+        stopping( false ),
+        nextConnection( firstConnectionKey ),
+        queuedInputCount( 0 ) {
+    assert( config.maxBatchSize > 0 );
+}
+
+InferenceServer::~InferenceServer() {
+    for( auto &&connection : connections ) {
+        ::close( connection.second.fd );
+    }
+    if( listenFd >= 0 ) {
+        ::unlink( config.socketPath.c_str( ) );
+    }
+    closeIfOpen( listenFd );
+    closeIfOpen( timerFd );
+    closeIfOpen( stopFd );
+    closeIfOpen( epollFd );
+}
+
+bool InferenceServer::open() {
+    sockaddr_un addr{ };
+    if( config.socketPath.size( ) >= sizeof( addr.sun_path ) ) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy( addr.sun_path, config.socketPath.c_str( ), sizeof( addr.sun_path ) - 1 );
+
+    listenFd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if( listenFd < 0 ) { return false; }
+
+    ::unlink( config.socketPath.c_str( ) );
+    if( ::bind( listenFd, reinterpret_cast<sockaddr *>( &addr ), sizeof( addr ) ) != 0 ||
+        ::listen( listenFd, SOMAXCONN ) != 0 ) {
+        return false;
+    }
+
+    epollFd = ::epoll_create1( EPOLL_CLOEXEC );
+    stopFd  = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    timerFd = ::timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+    if( epollFd < 0 || stopFd < 0 || timerFd < 0 ) { return false; }
+
+    const std::pair<int, uint64_t> watched[] = { { listenFd, listenKey }, { stopFd, stopKey }, { timerFd, timerKey } };
+    for( auto &&w : watched ) {
+        epoll_event ev{ };
+        ev.events   = EPOLLIN;
+        ev.data.u64 = w.second;
+        if( ::epoll_ctl( epollFd, EPOLL_CTL_ADD, w.first, &ev ) != 0 ) { return false; }
+    }
+    return true;
+}
+
+void InferenceServer::run() {
+    assert( epollFd >= 0 );
+    CORE_TRACE_THREAD_NAME( "InferenceServer" );
+
+    epoll_event events[64];
+    while( !stopping.load( ) ) {
+        const int count = ::epoll_wait( epollFd, events, 64, -1 );
+        if( count < 0 ) {
+            if( errno == EINTR ) { continue; }
+            break;
+        }
+
+        for( int i = 0; i < count; ++i ) {
+            const uint64_t key = events[ i ].data.u64;
+            if( key == listenKey ) {
+                acceptConnections( );
+            } else if( key == stopKey ) {
+                uint64_t value;
+                (void) ::read( stopFd, &value, sizeof( value ) );
+            } else if( key == timerKey ) {
+                uint64_t expirations;
+                (void) ::read( timerFd, &expirations, sizeof( expirations ) );
+                timerArmed = false;
+                flushBatch( );
+            } else {
+                if( events[ i ].events & EPOLLIN ) { readConnection( key ); }
+                if( (events[ i ].events & EPOLLOUT) && connections.count( key ) != 0 ) { writeConnection( key ); }
+                if( (events[ i ].events & (EPOLLHUP | EPOLLERR)) && connections.count( key ) != 0 ) {
+                    closeConnection( key );
+                }
+            }
+        }
+
+        // everything that arrived in this wakeup is queued, full batches go now and the rest waits for the timer
+        while( queue.size( ) >= config.maxBatchSize ) {
+            flushBatch( );
+        }
+        if( !queue.empty( ) && !timerArmed ) {
+            armTimer( );
+        }
+
+        for( auto &&key : unsent ) {
+            if( connections.count( key ) != 0 ) { writeConnection( key ); }
+        }
+        unsent.clear( );
+    }
+}
+
+void InferenceServer::stop() {
+    stopping.store( true );
+    const uint64_t one = 1;
+    (void) ::write( stopFd, &one, sizeof( one ) );
+}
+
+InferenceServer::Stats InferenceServer::getStats() const {
+    std::lock_guard<std::mutex> lock( statsMutex );
+    return stats;
+}
+
+void InferenceServer::report( std::ostream &out ) const {
+    const auto s       = getStats( );
+    const auto average = []( const uint64_t total, const uint64_t n ) { return (n > 0) ? double( total ) / n : 0.0; };
+
+    out << "requests " << s.requests << " rejected " << s.rejected << " batches " << s.batches
+        << " mean batch " << average( s.requests - s.rejected, s.batches ) << " largest " << s.largestBatch << "\n";
+    out << "queue latency mean " << average( s.queueNsTotal, s.requests - s.rejected ) / 1000.0 << "us max "
+        << s.queueNsMax / 1000.0 << "us\n";
+    out << "compute latency per batch mean " << average( s.computeNsTotal, s.batches ) / 1000.0 << "us max "
+        << s.computeNsMax / 1000.0 << "us\n";
+}
+
+void InferenceServer::acceptConnections() {
+    for( ;; ) {
+        const int fd = ::accept4( listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+        if( fd < 0 ) { return; }
+
+        const uint64_t key = nextConnection++;
+        epoll_event    ev{ };
+        ev.events   = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = key;
+        if( ::epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &ev ) != 0 ) {
+            ::close( fd );
+            continue;
+        }
+        connections.emplace( key, Connection{ fd, { }, { }, 0, false, false, 0 } );
+    }
+}
+
+void InferenceServer::readConnection( const uint64_t key ) {
+    auto it = connections.find( key );
+    if( it == connections.end( ) ) { return; }
+    auto &connection = it->second;
+
+    // an error closes straight away, an EOF only once the requests already sent are answered
+    bool    closed = false, eof = false;
+    uint8_t chunk[16384];
+    for( ;; ) {
+        const ssize_t n = ::read( connection.fd, chunk, sizeof( chunk ) );
+        if( n > 0 ) {
+            connection.in.insert( connection.in.end( ), chunk, chunk + n );
+        } else if( n == 0 ) {
+            eof = true;
+            break;
+        } else {
+            closed = (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+            if( errno != EINTR ) { break; }
+        }
+    }
+
+    const auto now      = Clock::now( );
+    size_t     consumed = 0;
+    while( connection.in.size( ) - consumed >= sizeof( FrameHeader ) ) {
+        FrameHeader header;
+        std::memcpy( &header, connection.in.data( ) + consumed, sizeof( header ) );
+        if( header.count > maxFrameCount ) {
+            closed = true;
+            break;
+        }
+        const size_t frameSize = sizeof( header ) + (header.count * sizeof( Core::real ));
+        if( connection.in.size( ) - consumed < frameSize ) { break; }
+
+        const auto inputs = connection.in.data( ) + consumed + sizeof( header );
+        consumed += frameSize;
+
+        size_t inputCount;
+        {
+            MachineLearning::ModelPublisher::ReadGuard model( *reader );
+            inputCount = model ? model->getInputCount( ) : 0;
+        }
+        // a newly published model may have a different shape, finish everything queued for the old one first,
+        // a flush only takes one batch
+        while( !queue.empty( ) && inputCount != queuedInputCount ) {
+            flushBatch( );
+        }
+
+        std::lock_guard<std::mutex> lock( statsMutex );
+        stats.requests++;
+        if( inputCount == 0 || header.count != inputCount ) {
+            stats.rejected++;
+            respond( key, header.id, nullptr, 0 );
+            continue;
+        }
+        queuedInputCount = inputCount;
+        connection.queued++;
+        queue.push_back( Pending{ key, header.id, now } );
+        queuedInputs.resize( queuedInputs.size( ) + inputCount );
+        std::memcpy( queuedInputs.data( ) + queuedInputs.size( ) - inputCount, inputs,
+                     inputCount * sizeof( Core::real ) );
+    }
+    connection.in.erase( connection.in.begin( ), connection.in.begin( ) + consumed );
+
+    if( closed ) {
+        closeConnection( key );
+    } else if( eof ) {
+        // a partial frame left over can never complete
+        connection.in.clear( );
+        connection.readClosed = true;
+        if( !closeIfFinished( key, connection ) ) {
+            watch( key, connection, connection.wantWrite );
+        }
+    }
+}
+
+void InferenceServer::writeConnection( const uint64_t key ) {
+    auto &connection = connections.at( key );
+    while( connection.outOffset < connection.out.size( ) ) {
+        const ssize_t n = ::send( connection.fd, connection.out.data( ) + connection.outOffset,
+                                  connection.out.size( ) - connection.outOffset, MSG_NOSIGNAL );
+        if( n < 0 ) {
+            if( errno == EINTR ) { continue; }
+            if( errno != EAGAIN && errno != EWOULDBLOCK ) {
+                closeConnection( key );
+                return;
+            }
+            break;
+        }
+        connection.outOffset += size_t( n );
+    }
+
+    const bool pending = connection.outOffset < connection.out.size( );
+    if( !pending ) {
+        connection.out.clear( );
+        connection.outOffset = 0;
+        if( closeIfFinished( key, connection ) ) { return; }
+    }
+
+    // only ask for EPOLLOUT while the socket is backed up
+    if( pending != connection.wantWrite ) {
+        watch( key, connection, pending );
+    }
+}
+
+void InferenceServer::watch( const uint64_t key, Connection &connection, const bool write ) {
+    epoll_event ev{ };
+    ev.events   = (connection.readClosed ? 0u : uint32_t( EPOLLIN | EPOLLRDHUP )) | (write ? uint32_t( EPOLLOUT ) : 0u);
+    ev.data.u64 = key;
+    ::epoll_ctl( epollFd, EPOLL_CTL_MOD, connection.fd, &ev );
+    connection.wantWrite = write;
+}
+
+bool InferenceServer::closeIfFinished( const uint64_t key, Connection &connection ) {
+    if( !connection.readClosed || connection.queued > 0 || !connection.out.empty( ) ) {
+        return false;
+    }
+    closeConnection( key );
+    return true;
+}
+
+void InferenceServer::closeConnection( const uint64_t key ) {
+    auto it = connections.find( key );
+    if( it == connections.end( ) ) { return; }
+    ::epoll_ctl( epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr );
+    ::close( it->second.fd );
+    connections.erase( it );
+    // any of its requests still queued are evaluated and their responses dropped
+}
+
+void InferenceServer::respond( const uint64_t key, const uint32_t id, const Core::real *results,
+                               const uint32_t count ) {
+    auto it = connections.find( key );
+    if( it == connections.end( ) ) { return; }
+    auto &out = it->second.out;
+    // an empty buffer isn't on the unsent list yet, a non empty one already is or is waiting on EPOLLOUT
+    if( out.empty( ) ) {
+        unsent.push_back( key );
+    }
+
+    const FrameHeader header{ id, count };
+    const auto        h = reinterpret_cast<const uint8_t *>( &header );
+    const auto        r = reinterpret_cast<const uint8_t *>( results );
+    out.insert( out.end( ), h, h + sizeof( header ) );
+    if( count > 0 ) {
+        out.insert( out.end( ), r, r + (count * sizeof( Core::real )) );
+    }
+}
+
+void InferenceServer::armTimer() {
+    const auto deadline = queue.front( ).arrival + std::chrono::microseconds( config.maxDelayMicroseconds );
+    const auto wait     = std::max<int64_t>( 1, int64_t( nanoseconds( deadline - Clock::now( ) ) ) );
+
+    itimerspec spec{ };
+    spec.it_value.tv_sec  = time_t( wait / 1000000000 );
+    spec.it_value.tv_nsec = long( wait % 1000000000 );
+    ::timerfd_settime( timerFd, 0, &spec, nullptr );
+    timerArmed = true;
+}
+
+void InferenceServer::flushBatch() {
+    if( queue.empty( ) ) { return; }
+    CORE_TRACE_SCOPE_ARG( "InferenceServer::flushBatch", queue.size( ) );
+
+    const size_t batchSize = std::min( queue.size( ), config.maxBatchSize );
+    const auto   start     = Clock::now( );
+
+    size_t outputCount = 0;
+    {
+        MachineLearning::ModelPublisher::ReadGuard model( *reader );
+        if( model && model->getInputCount( ) == queuedInputCount ) {
+            outputCount = model->getOutputCount( );
+            batchResults.resize( batchSize * outputCount );
+            session.evaluate( *model, batchSize, queuedInputs.data( ), batchResults.data( ) );
+        }
+    }
+    const auto end = Clock::now( );
+
+    {
+        std::lock_guard<std::mutex> lock( statsMutex );
+        if( outputCount > 0 ) {
+            const auto compute = nanoseconds( end - start );
+            stats.batches++;
+            stats.largestBatch   = std::max<uint64_t>( stats.largestBatch, batchSize );
+            stats.computeNsTotal += compute;
+            stats.computeNsMax   = std::max( stats.computeNsMax, compute );
+            for( size_t i = 0; i < batchSize; ++i ) {
+                const auto wait = nanoseconds( start - queue[ i ].arrival );
+                stats.queueNsTotal += wait;
+                stats.queueNsMax   = std::max( stats.queueNsMax, wait );
+            }
+        } else {
+            stats.rejected += batchSize;
+        }
+    }
+
+    for( size_t i = 0; i < batchSize; ++i ) {
+        auto it = connections.find( queue[ i ].connection );
+        if( it != connections.end( ) ) { it->second.queued--; }
+        respond( queue[ i ].connection, queue[ i ].id, batchResults.data( ) + (i * outputCount),
+                 uint32_t( outputCount ) );
+    }
+
+    queue.erase( queue.begin( ), queue.begin( ) + batchSize );
+    queuedInputs.erase( queuedInputs.begin( ), queuedInputs.begin( ) + (batchSize * queuedInputCount) );
+
+    // the remainder are due relative to their own arrival
+    if( !queue.empty( ) ) {
+        armTimer( );
+    } else if( timerArmed ) {
+        const itimerspec disarm{ };
+        ::timerfd_settime( timerFd, 0, &disarm, nullptr );
+        timerArmed = false;
+    }
+}
+
+InferenceClient::InferenceClient() : fd( -1 ), nextId( 0 ) {
+}
+
+InferenceClient::~InferenceClient() {
+    closeIfOpen( fd );
+}
+
+bool InferenceClient::connect( const std::string &socketPath ) {
+    sockaddr_un addr{ };
+    if( socketPath.size( ) >= sizeof( addr.sun_path ) ) { return false; }
+    addr.sun_family = AF_UNIX;
+    std::strncpy( addr.sun_path, socketPath.c_str( ), sizeof( addr.sun_path ) - 1 );
+
+    closeIfOpen( fd );
+    fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if( fd < 0 ) { return false; }
+    if( ::connect( fd, reinterpret_cast<sockaddr *>( &addr ), sizeof( addr ) ) != 0 ) {
+        closeIfOpen( fd );
+        return false;
+    }
+    return true;
+}
+
+bool InferenceClient::send( const uint32_t id, const std::vector<Core::real> &inputs ) {
+    const FrameHeader    header{ id, uint32_t( inputs.size( ) ) };
+    const auto           h       = reinterpret_cast<const uint8_t *>( &header );
+    const auto           payload = reinterpret_cast<const uint8_t *>( inputs.data( ) );
+    std::vector<uint8_t> frame( h, h + sizeof( header ) );
+    frame.insert( frame.end( ), payload, payload + (inputs.size( ) * sizeof( Core::real )) );
+
+    size_t sent = 0;
+    while( sent < frame.size( ) ) {
+        const ssize_t n = ::send( fd, frame.data( ) + sent, frame.size( ) - sent, MSG_NOSIGNAL );
+        if( n < 0 && errno == EINTR ) { continue; }
+        if( n <= 0 ) { return false; }
+        sent += size_t( n );
+    }
+    return true;
+}
+
+bool InferenceClient::finishSending() {
+    return ::shutdown( fd, SHUT_WR ) == 0;
+}
+
+bool InferenceClient::receive( uint32_t &id, std::vector<Core::real> &outputs ) {
+    const auto readAll = [ this ]( void *data, const size_t size ) {
+        auto   bytes = static_cast<uint8_t *>( data );
+        size_t got   = 0;
+        while( got < size ) {
+            const ssize_t n = ::read( fd, bytes + got, size - got );
+            if( n < 0 && errno == EINTR ) { continue; }
+            if( n <= 0 ) { return false; }
+            got += size_t( n );
+        }
+        return true;
+    };
+
+    FrameHeader header;
+    if( !readAll( &header, sizeof( header ) ) || header.count > maxFrameCount ) { return false; }
+    id = header.id;
+    outputs.resize( header.count );
+    return readAll( outputs.data( ), header.count * sizeof( Core::real ) );
+}
+
+bool InferenceClient::evaluate( const std::vector<Core::real> &inputs, std::vector<Core::real> &outputs ) {
+    const uint32_t id = nextId++;
+    uint32_t       replyId;
+    return send( id, inputs ) && receive( replyId, outputs ) && replyId == id;
+}
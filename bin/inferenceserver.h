@@ -0,0 +1,172 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/model.h"
+#include "machinelearning/modelpublisher.h"
+
+/*
+ * Local inference server over a Unix domain socket.
+ * Every frame is a FrameHeader followed by count reals, native byte order as both ends are on the same machine.
+ * A request carries one sample of inputs, the response echoes the id with the outputs or a count of 0 if the
+ * request didn't match the model. Requests from all connections are queued and evaluated together once maxBatchSize
+ * are waiting or the oldest has waited maxDelayMicroseconds, so concurrent callers share one batched evaluate.
+ */
+struct FrameHeader {
+    uint32_t id;
+    uint32_t count;
+};
+
+class InferenceServer {
+public:
+    struct Config {
+        std::string socketPath;
+        size_t      maxBatchSize         = 32;
+        uint32_t    maxDelayMicroseconds = 500;
+    };
+
+    // latencies in nanoseconds, queue is arrival to the start of its batch, compute is the batch evaluate
+    struct Stats {
+        uint64_t requests       = 0;
+        uint64_t rejected       = 0;
+        uint64_t batches        = 0;
+        uint64_t largestBatch   = 0;
+        uint64_t queueNsTotal   = 0;
+        uint64_t queueNsMax     = 0;
+        uint64_t computeNsTotal = 0;
+        uint64_t computeNsMax   = 0;
+    };
+
+    InferenceServer( MachineLearning::ModelPublisher &_publisher, const Config &_config );
+
+    ~InferenceServer();
+
+    InferenceServer( const InferenceServer & ) = delete;
+
+    InferenceServer &operator=( const InferenceServer & ) = delete;
+
+    // creates and binds the socket, false (with errno set) on failure
+    bool open();
+
+    // the event loop, returns once stop is called
+    void run();
+
+    // safe from any thread or a signal handler
+    void stop();
+
+    Stats getStats() const;
+
+    void report( std::ostream &out ) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // a client that half closes after pipelining keeps the connection until every answer has gone out
+    struct Connection {
+        int                  fd;
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        size_t               outOffset;
+        bool                 wantWrite;
+        bool                 readClosed; // the client sent EOF, nothing more will be read
+        size_t               queued;     // requests waiting in a batch
+    };
+
+    struct Pending {
+        uint64_t          connection;
+        uint32_t          id;
+        Clock::time_point arrival;
+    };
+
+    void acceptConnections();
+
+    void readConnection( const uint64_t key );
+
+    void writeConnection( const uint64_t key );
+
+    void closeConnection( const uint64_t key );
+
+    // the epoll interest for the connection, reads unless read closed and writes while asked
+    void watch( const uint64_t key, Connection &connection, const bool write );
+
+    // closes a read closed connection once nothing is queued or unsent for it, true if it did
+    bool closeIfFinished( const uint64_t key, Connection &connection );
+
+    // appends the response, writes happen at the end of the loop pass so a failed write never closes a connection
+    // that's still being read
+    void respond( const uint64_t key, const uint32_t id, const Core::real *results, const uint32_t count );
+
+    void armTimer();
+
+    void flushBatch();
+
+    MachineLearning::ModelPublisher                         &publisher;
+    const Config                                            config;
+    std::unique_ptr<MachineLearning::ModelPublisher::Reader> reader;
+    MachineLearning::InferenceSession                       session;
+
+    int  listenFd;
+    int  epollFd;
+    int  stopFd;
+    int  timerFd;
+    bool timerArmed;
+
+    std::atomic<bool> stopping;
+
+    uint64_t                                 nextConnection;
+    std::unordered_map<uint64_t, Connection> connections;
+
+    // queued requests, their inputs packed one sample after another ready for the batched evaluate
+    size_t                  queuedInputCount;
+    std::vector<Pending>    queue;
+    std::vector<Core::real> queuedInputs;
+    std::vector<Core::real> batchResults;
+
+    // connections with responses appended since the last write, sent once per event loop pass
+    std::vector<uint64_t> unsent;
+
+    mutable std::mutex statsMutex;
+    Stats              stats;
+};
+
+/*
+ * Blocking client for the InferenceServer, requests may be pipelined by several sends before the receives
+ */
+class InferenceClient {
+public:
+    InferenceClient();
+
+    ~InferenceClient();
+
+    InferenceClient( const InferenceClient & ) = delete;
+
+    InferenceClient &operator=( const InferenceClient & ) = delete;
+
+    bool connect( const std::string &socketPath );
+
+    bool send( const uint32_t id, const std::vector<Core::real> &inputs );
+
+    // no more requests, the responses to those already sent can still be received
+    bool finishSending();
+
+    // false if the connection failed, an empty outputs means the server rejected the request
+    bool receive( uint32_t &id, std::vector<Core::real> &outputs );
+
+    bool evaluate( const std::vector<Core::real> &inputs, std::vector<Core::real> &outputs );
+
+private:
+    int      fd;
+    uint32_t nextId;
+};
@@ -4,6 +4,9 @@
 
 #include "core/core.h"
 #include "basiccppvectoralu.h"
+#include "core/reduction.h"
+#include <algorithm>
+#include <cstring>
 #include <boost/numeric/ublas/storage.hpp>
 
 namespace Core {
@@ -68,6 +71,10 @@ namespace Core {
     }
 
     void BasicCPPVectorALU::horizSum( const size_t numItems, const_real_array_ptr a, real &out ) const {
+        if( getReductionMode( ) == ReductionMode::Reproducible ) {
+            out = Reduction::sum( numItems, a );
+            return;
+        }
         out = Core::real(0);
         for (int i = 0; i < numItems; ++i) {
             out = out + a[i];
@@ -152,6 +159,9 @@ namespace Core {
     }
 
     real BasicCPPVectorALU::norm1( const size_t numItems, const_real_array_ptr a ) const {
+        if( getReductionMode( ) == ReductionMode::Reproducible ) {
+            return Reduction::sumAbs( numItems, a );
+        }
         // todo remove allocation
         real_array_ptr res = newRealVector(numItems);
         abs(numItems, a, res);
@@ -161,6 +171,9 @@ namespace Core {
     }
 
     real BasicCPPVectorALU::norm2( const size_t numItems, const_real_array_ptr a ) const {
+        if( getReductionMode( ) == ReductionMode::Reproducible ) {
+            return std::sqrt( Reduction::sumSquares( numItems, a ) );
+        }
         // todo remove allocation
         real_array_ptr res = newRealVector(numItems);
         mul(numItems, a, a, res);
@@ -170,14 +183,14 @@ namespace Core {
     }
 
     real BasicCPPVectorALU::norm3( const size_t numItems, const_real_array_ptr a ) const {
+        if( getReductionMode( ) == ReductionMode::Reproducible ) {
+            return std::cbrt( Reduction::sumAbsCubes( numItems, a ) );
+        }
         // todo remove allocation
         real_array_ptr res = newRealVector(numItems);
-        real_array_ptr res2 = newRealVector(numItems);
-        mul(numItems, a, a, res);
-        mul(numItems, res, res, res2);
-        auto r = std::cbrt(horizSum(numItems, res2));
+        UnOp(numItems, a, res, [](const real av) -> real { return std::abs(av) * av * av; });
+        auto r = std::cbrt(horizSum(numItems, res));
         deleteRealVector(res);
-        deleteRealVector(res2);
         return r;
     }
 
@@ -253,6 +266,543 @@ namespace Core {
         }
     }
 
+    void BasicCPPVectorALU::gemm( const bool transA, const bool transB, const size_t m, const size_t n,
+                                  const size_t k, const real alpha, const_real_array_ptr a, const size_t lda,
+                                  const_real_array_ptr b, const size_t ldb, const real beta, real_array_ptr o,
+                                  const size_t ldo ) const {
+        for( size_t i = 0; i < m; ++i ) {
+            real *orow = o + (i * ldo);
+            if( beta == real( 0 ) ) {
+                std::fill( orow, orow + n, real( 0 ) );
+            } else if( beta != real( 1 ) ) {
+                for( size_t j = 0; j < n; ++j ) { orow[ j ] *= beta; }
+            }
+
+            if( !transB ) {
+                // rows of b are contiguous so stream them into the output row (i-k-j order)
+                for( size_t p = 0; p < k; ++p ) {
+                    const real aip  = alpha * (transA ? a[ (p * lda) + i ] : a[ (i * lda) + p ]);
+                    const real *brow = b + (p * ldb);
+                    for( size_t j = 0; j < n; ++j ) {
+                        orow[ j ] += aip * brow[ j ];
+                    }
+                }
+            } else {
+                // op( b ) columns are rows of b, so each output is a contiguous dot product
+                for( size_t j = 0; j < n; ++j ) {
+                    const real *brow = b + (j * ldb);
+                    real       sum   = real( 0 );
+                    if( transA ) {
+                        for( size_t p = 0; p < k; ++p ) { sum += a[ (p * lda) + i ] * brow[ p ]; }
+                    } else {
+                        const real *arow = a + (i * lda);
+                        for( size_t p = 0; p < k; ++p ) { sum += arow[ p ] * brow[ p ]; }
+                    }
+                    orow[ j ] += alpha * sum;
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::gemv( const bool transA, const size_t m, const size_t n, const real alpha,
+                                  const_real_array_ptr a, const size_t lda, const_real_array_ptr x, const real beta,
+                                  real_array_ptr o ) const {
+        // a gemv is a gemm with a single column, x and o are contiguous so the column stride is 1
+        gemm( transA, false, m, 1, n, alpha, a, lda, x, 1, beta, o, 1 );
+    }
+
+    namespace {
+        // where element ( r, c ) of a rows x cols panel packed matrix lives
+        inline size_t panelOffset( const size_t rows, const size_t cols, const size_t panelWidth, const size_t r,
+                                   const size_t c ) {
+            const size_t c0 = (c / panelWidth) * panelWidth;
+            const size_t w  = std::min( panelWidth, cols - c0 );
+            return (c0 * rows) + (r * w) + (c - c0);
+        }
+
+        // acc[ 0..W ) += sum over p of a[ p * aStride ] * b[ p * ldb + 0..W ), W known at compile time so this vectorises
+        template<size_t W>
+        inline void panelAccumulate( const size_t k, const real *a, const size_t aStride, const real *b,
+                                     const size_t ldb, real *acc ) {
+            for( size_t p = 0; p < k; ++p ) {
+                const real ap   = a[ p * aStride ];
+                const real *row = b + (p * ldb);
+                for( size_t j = 0; j < W; ++j ) {
+                    acc[ j ] += ap * row[ j ];
+                }
+            }
+        }
+
+        inline void panelAccumulate( const size_t w, const size_t k, const real *a, const size_t aStride,
+                                     const real *b, const size_t ldb, real *acc ) {
+            switch( w ) {
+                case 8: panelAccumulate<8>( k, a, aStride, b, ldb, acc );
+                    break;
+                case 16: panelAccumulate<16>( k, a, aStride, b, ldb, acc );
+                    break;
+                default:
+                    for( size_t p = 0; p < k; ++p ) {
+                        const real ap   = a[ p * aStride ];
+                        const real *row = b + (p * ldb);
+                        for( size_t j = 0; j < w; ++j ) {
+                            acc[ j ] += ap * row[ j ];
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::packPanels( const size_t rows, const size_t cols, const_real_array_ptr src,
+                                        const size_t ld, const bool transposed, const size_t panelWidth,
+                                        real_array_ptr o ) const {
+        real *out = o;
+        for( size_t c0 = 0; c0 < cols; c0 += panelWidth ) {
+            const size_t w = std::min( panelWidth, cols - c0 );
+            for( size_t r = 0; r < rows; ++r ) {
+                for( size_t j = 0; j < w; ++j ) {
+                    *out++ = transposed ? src[ ((c0 + j) * ld) + r ] : src[ (r * ld) + c0 + j ];
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::unpackPanels( const size_t rows, const size_t cols, const_real_array_ptr packed,
+                                          const size_t panelWidth, real_array_ptr o, const size_t ldo ) const {
+        const real *in = packed;
+        for( size_t c0 = 0; c0 < cols; c0 += panelWidth ) {
+            const size_t w = std::min( panelWidth, cols - c0 );
+            for( size_t r = 0; r < rows; ++r ) {
+                for( size_t j = 0; j < w; ++j ) {
+                    o[ (r * ldo) + c0 + j ] = *in++;
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::transposePanels( const size_t rows, const size_t cols, const_real_array_ptr packed,
+                                             const size_t panelWidth, const size_t oCols, real_array_ptr o ) const {
+        assert( oCols <= rows );
+        // output is cols x oCols, written linearly
+        real *out = o;
+        for( size_t c0 = 0; c0 < oCols; c0 += panelWidth ) {
+            const size_t w = std::min( panelWidth, oCols - c0 );
+            for( size_t r = 0; r < cols; ++r ) {
+                for( size_t j = 0; j < w; ++j ) {
+                    *out++ = packed[ panelOffset( rows, cols, panelWidth, c0 + j, r ) ];
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::packedGemm( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                        const size_t lda, const_real_array_ptr b, const size_t panelWidth,
+                                        const real beta, real_array_ptr o, const size_t ldo ) const {
+        assert( panelWidth <= maxPanelWidth );
+        // k is blocked so a panel block stays in L1 while every row of a streams past it
+        constexpr size_t kBlock = 256;
+
+        for( size_t c0 = 0; c0 < n; c0 += panelWidth ) {
+            const size_t w     = std::min( panelWidth, n - c0 );
+            const real   *panel = b + (c0 * k);
+
+            // always at least one block so beta is applied when k is 0
+            for( size_t k0 = 0; (k0 == 0) || (k0 < k); k0 += kBlock ) {
+                const size_t kn = std::min( kBlock, k - k0 );
+
+                for( size_t i = 0; i < m; ++i ) {
+                    real *orow = o + (i * ldo) + c0;
+                    real acc[maxPanelWidth];
+                    for( size_t j = 0; j < w; ++j ) {
+                        acc[ j ] = (k0 != 0) ? orow[ j ] : ((beta == real( 0 )) ? real( 0 ) : beta * orow[ j ]);
+                    }
+                    panelAccumulate( w, kn, a + (i * lda) + k0, 1, panel + (k0 * w), w, acc );
+                    for( size_t j = 0; j < w; ++j ) {
+                        orow[ j ] = acc[ j ];
+                    }
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::packedGemmTransposed( const size_t m, const size_t n, const size_t k,
+                                                  const_real_array_ptr a, const size_t lda, const_real_array_ptr b,
+                                                  const size_t bRows, const size_t panelWidth, const real beta,
+                                                  real_array_ptr o, const size_t ldo ) const {
+        assert( n <= bRows );
+        for( size_t i = 0; i < m; ++i ) {
+            real *orow = o + (i * ldo);
+            for( size_t r = 0; r < n; ++r ) {
+                orow[ r ] = (beta == real( 0 )) ? real( 0 ) : beta * orow[ r ];
+            }
+        }
+
+        // each panel is walked linearly, its rows dotted with the matching slice of a
+        for( size_t c0 = 0; c0 < k; c0 += panelWidth ) {
+            const size_t w     = std::min( panelWidth, k - c0 );
+            const real   *panel = b + (c0 * bRows);
+            for( size_t i = 0; i < m; ++i ) {
+                const real *arow = a + (i * lda) + c0;
+                real       *orow = o + (i * ldo);
+                for( size_t r = 0; r < n; ++r ) {
+                    const real *prow = panel + (r * w);
+                    real       sum   = real( 0 );
+                    for( size_t j = 0; j < w; ++j ) {
+                        sum += arow[ j ] * prow[ j ];
+                    }
+                    orow[ r ] += sum;
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::packedOuterAccumulate( const size_t m, const size_t k, const size_t n,
+                                                   const_real_array_ptr a, const size_t lda, const_real_array_ptr b,
+                                                   const size_t ldb, const size_t panelWidth,
+                                                   real_array_ptr o ) const {
+        assert( panelWidth <= maxPanelWidth );
+        for( size_t c0 = 0; c0 < n; c0 += panelWidth ) {
+            const size_t w     = std::min( panelWidth, n - c0 );
+            real         *panel = o + (c0 * k);
+            for( size_t r = 0; r < k; ++r ) {
+                // this panel row lives in registers while the batch streams through
+                real *prow = panel + (r * w);
+                real acc[maxPanelWidth];
+                for( size_t j = 0; j < w; ++j ) { acc[ j ] = prow[ j ]; }
+                panelAccumulate( w, m, a + r, lda, b + c0, ldb, acc );
+                for( size_t j = 0; j < w; ++j ) { prow[ j ] = acc[ j ]; }
+            }
+        }
+    }
+
+    namespace {
+        inline void activatePanel( const ActivationKernel act, const real param0, const real param1,
+                                   const size_t w, real *acc ) {
+            switch( act ) {
+                case ActivationKernel::Identity:
+                    break;
+                case ActivationKernel::Step:
+                    for( size_t j = 0; j < w; ++j ) { acc[ j ] = (acc[ j ] > param0) ? real( 1 ) : real( 0 ); }
+                    break;
+                case ActivationKernel::Sigmoid:
+                    for( size_t j = 0; j < w; ++j ) { acc[ j ] = real( 1 ) / (real( 1 ) + std::exp( -acc[ j ] )); }
+                    break;
+                case ActivationKernel::HyperbolicTangent:
+                    for( size_t j = 0; j < w; ++j ) { acc[ j ] = std::tanh( acc[ j ] ); }
+                    break;
+                case ActivationKernel::ReLU:
+                    for( size_t j = 0; j < w; ++j ) { acc[ j ] = (acc[ j ] >= param0) ? acc[ j ] : param1; }
+                    break;
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::packedDenseActivate( const size_t m, const size_t n, const size_t k,
+                                                 const_real_array_ptr a, const size_t lda, const_real_array_ptr b,
+                                                 const size_t panelWidth, const ActivationKernel act,
+                                                 const real param0, const real param1, real_array_ptr sums,
+                                                 const size_t lds, real_array_ptr o, const size_t ldo ) const {
+        assert( panelWidth <= maxPanelWidth );
+        assert( k > 0 );
+        constexpr size_t kBlock = 256;
+        const size_t     srcCount = k - 1;
+
+        for( size_t c0 = 0; c0 < n; c0 += panelWidth ) {
+            const size_t w     = std::min( panelWidth, n - c0 );
+            const real   *panel = b + (c0 * k);
+            const real   *bias  = panel + (srcCount * w);
+
+            // large fan-ins are k blocked (partial sums parked in o), the activation runs on the last block while the
+            // sums are still in registers
+            for( size_t k0 = 0; (k0 == 0) || (k0 < srcCount); k0 += kBlock ) {
+                const size_t kn   = std::min( kBlock, srcCount - k0 );
+                const bool   last = (k0 + kn) >= srcCount;
+
+                for( size_t i = 0; i < m; ++i ) {
+                    real *orow = o + (i * ldo) + c0;
+                    real acc[maxPanelWidth];
+                    for( size_t j = 0; j < w; ++j ) {
+                        acc[ j ] = (k0 == 0) ? bias[ j ] : orow[ j ];
+                    }
+                    panelAccumulate( w, kn, a + (i * lda) + k0, 1, panel + (k0 * w), w, acc );
+                    if( last ) {
+                        if( sums != nullptr ) {
+                            real *srow = sums + (i * lds) + c0;
+                            for( size_t j = 0; j < w; ++j ) { srow[ j ] = acc[ j ]; }
+                        }
+                        activatePanel( act, param0, param1, w, acc );
+                    }
+                    for( size_t j = 0; j < w; ++j ) {
+                        orow[ j ] = acc[ j ];
+                    }
+                }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::packedDenseAccumulate( const size_t m, const size_t n, const size_t k,
+                                                   const_real_array_ptr a, const size_t lda, const_real_array_ptr b,
+                                                   const size_t panelWidth, real_array_ptr o,
+                                                   const size_t ldo ) const {
+        assert( panelWidth <= maxPanelWidth );
+        assert( k > 0 );
+        const size_t srcCount = k - 1;
+
+        for( size_t c0 = 0; c0 < n; c0 += panelWidth ) {
+            const size_t w     = std::min( panelWidth, n - c0 );
+            const real   *panel = b + (c0 * k);
+            const real   *bias  = panel + (srcCount * w);
+
+            for( size_t i = 0; i < m; ++i ) {
+                real *orow = o + (i * ldo) + c0;
+                real acc[maxPanelWidth];
+                for( size_t j = 0; j < w; ++j ) { acc[ j ] = orow[ j ] + bias[ j ]; }
+                panelAccumulate( w, srcCount, a + (i * lda), 1, panel, w, acc );
+                for( size_t j = 0; j < w; ++j ) { orow[ j ] = acc[ j ]; }
+            }
+        }
+    }
+
+    // the optimiser steps are plain loops rather than the lambda helpers so the compiler can vectorise them,
+    // every array is read and written exactly once
+    void BasicCPPVectorALU::momentumStep( const size_t numItems, const real learningRate, const real momentum,
+                                          const bool nesterov, const real gradScale, real_array_ptr weights,
+                                          real_array_ptr gradients, real_array_ptr velocity ) const {
+        if( nesterov ) {
+            for( size_t i = 0; i < numItems; ++i ) {
+                const real g = gradients[ i ] * gradScale;
+                const real v = (momentum * velocity[ i ]) - (learningRate * g);
+                velocity[ i ] = v;
+                weights[ i ] += (momentum * v) - (learningRate * g);
+                gradients[ i ] = real( 0 );
+            }
+        } else {
+            for( size_t i = 0; i < numItems; ++i ) {
+                const real v = (momentum * velocity[ i ]) - (learningRate * gradScale * gradients[ i ]);
+                velocity[ i ] = v;
+                weights[ i ] += v;
+                gradients[ i ] = real( 0 );
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::rmsPropStep( const size_t numItems, const real learningRate, const real decay,
+                                         const real epsilon, const real gradScale, real_array_ptr weights,
+                                         real_array_ptr gradients, real_array_ptr meanSquare ) const {
+        for( size_t i = 0; i < numItems; ++i ) {
+            const real g  = gradients[ i ] * gradScale;
+            const real ms = (decay * meanSquare[ i ]) + ((real( 1 ) - decay) * g * g);
+            meanSquare[ i ] = ms;
+            weights[ i ] -= learningRate * g / (std::sqrt( ms ) + epsilon);
+            gradients[ i ] = real( 0 );
+        }
+    }
+
+    void BasicCPPVectorALU::adamStep( const size_t numItems, const real learningRate, const real beta1,
+                                      const real beta2, const real epsilon, const real gradScale,
+                                      real_array_ptr weights, real_array_ptr gradients, real_array_ptr firstMoment,
+                                      real_array_ptr secondMoment ) const {
+        for( size_t i = 0; i < numItems; ++i ) {
+            const real g = gradients[ i ] * gradScale;
+            const real m = (beta1 * firstMoment[ i ]) + ((real( 1 ) - beta1) * g);
+            const real v = (beta2 * secondMoment[ i ]) + ((real( 1 ) - beta2) * g * g);
+            firstMoment[ i ]  = m;
+            secondMoment[ i ] = v;
+            weights[ i ] -= learningRate * m / (std::sqrt( v ) + epsilon);
+            gradients[ i ] = real( 0 );
+        }
+    }
+
+    void BasicCPPVectorALU::laneDenseActivate( const size_t lanes, const size_t n, const size_t k,
+                                               const_real_array_ptr a, const_real_array_ptr b,
+                                               const ActivationKernel act, const real param0, const real param1,
+                                               real_array_ptr sums, real_array_ptr o ) const {
+        assert( k > 0 );
+        const size_t srcCount = k - 1;
+        const real   *bias    = b + (srcCount * n * lanes);
+
+        // the output row is the accumulator, each lane is a different network so there is no horizontal work
+        for( size_t d = 0; d < n; ++d ) {
+            real *acc = o + (d * lanes);
+            for( size_t l = 0; l < lanes; ++l ) { acc[ l ] = bias[ (d * lanes) + l ]; }
+            for( size_t s = 0; s < srcCount; ++s ) {
+                const real *in = a + (s * lanes);
+                const real *w  = b + (((s * n) + d) * lanes);
+                for( size_t l = 0; l < lanes; ++l ) { acc[ l ] += in[ l ] * w[ l ]; }
+            }
+            if( sums != nullptr ) {
+                std::memcpy( sums + (d * lanes), acc, lanes * sizeof( real ) );
+            }
+            activatePanel( act, param0, param1, lanes, acc );
+        }
+    }
+
+    void BasicCPPVectorALU::laneOuterAccumulate( const size_t lanes, const size_t k, const size_t n,
+                                                 const_real_array_ptr a, const_real_array_ptr delta,
+                                                 real_array_ptr o ) const {
+        assert( k > 0 );
+        const size_t srcCount = k - 1;
+        for( size_t s = 0; s < srcCount; ++s ) {
+            const real *in = a + (s * lanes);
+            for( size_t d = 0; d < n; ++d ) {
+                const real *dd = delta + (d * lanes);
+                real       *g  = o + (((s * n) + d) * lanes);
+                for( size_t l = 0; l < lanes; ++l ) { g[ l ] += in[ l ] * dd[ l ]; }
+            }
+        }
+        real *bias = o + (srcCount * n * lanes);
+        for( size_t i = 0; i < n * lanes; ++i ) { bias[ i ] += delta[ i ]; }
+    }
+
+    void BasicCPPVectorALU::laneTransposedProduct( const size_t lanes, const size_t k, const size_t n,
+                                                   const_real_array_ptr b, const_real_array_ptr delta,
+                                                   real_array_ptr o ) const {
+        assert( k > 0 );
+        const size_t srcCount = k - 1;
+        for( size_t s = 0; s < srcCount; ++s ) {
+            real *acc = o + (s * lanes);
+            for( size_t l = 0; l < lanes; ++l ) { acc[ l ] = real( 0 ); }
+            for( size_t d = 0; d < n; ++d ) {
+                const real *dd = delta + (d * lanes);
+                const real *w  = b + (((s * n) + d) * lanes);
+                for( size_t l = 0; l < lanes; ++l ) { acc[ l ] += w[ l ] * dd[ l ]; }
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::laneMomentumStep( const size_t lanes, const size_t numItems,
+                                              const_real_array_ptr learningRate, const_real_array_ptr momentum,
+                                              const real gradScale, real_array_ptr weights, real_array_ptr gradients,
+                                              real_array_ptr velocity ) const {
+        for( size_t i = 0; i < numItems; ++i ) {
+            const size_t row = i * lanes;
+            for( size_t l = 0; l < lanes; ++l ) {
+                const real v = (momentum[ l ] * velocity[ row + l ]) -
+                               (learningRate[ l ] * gradScale * gradients[ row + l ]);
+                velocity[ row + l ] = v;
+                weights[ row + l ] += v;
+                gradients[ row + l ] = real( 0 );
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::activate( const size_t numItems, const ActivationKernel act, const real param0,
+                                      const real param1, const_real_array_ptr a, real_array_ptr o ) const {
+        if( a != o ) {
+            std::memcpy( o, a, numItems * sizeof( real ) );
+        }
+        activatePanel( act, param0, param1, numItems, o );
+    }
+
+    void BasicCPPVectorALU::mulActivationDerivative( const size_t numItems, const ActivationKernel act,
+                                                     const real param0, const_real_array_ptr sums,
+                                                     real_array_ptr o ) const {
+        switch( act ) {
+            case ActivationKernel::Identity:
+                break;
+            case ActivationKernel::Step:
+                for( size_t i = 0; i < numItems; ++i ) { o[ i ] = real( 0 ); }
+                break;
+            case ActivationKernel::Sigmoid:
+                for( size_t i = 0; i < numItems; ++i ) {
+                    const real s = real( 1 ) / (real( 1 ) + std::exp( -sums[ i ] ));
+                    o[ i ] *= s * (real( 1 ) - s);
+                }
+                break;
+            case ActivationKernel::HyperbolicTangent:
+                for( size_t i = 0; i < numItems; ++i ) {
+                    const real t = std::tanh( sums[ i ] );
+                    o[ i ] *= real( 1 ) - (t * t);
+                }
+                break;
+            case ActivationKernel::ReLU:
+                for( size_t i = 0; i < numItems; ++i ) { o[ i ] = (sums[ i ] >= param0) ? o[ i ] : real( 0 ); }
+                break;
+        }
+    }
+
+    void BasicCPPVectorALU::chebyshevSeries( const size_t numItems, const_real_array_ptr coefficients,
+                                             const size_t coefficientCount, const_real_array_ptr a,
+                                             real_array_ptr o ) const {
+        assert( coefficientCount > 0 );
+        constexpr size_t chunk = 64;
+
+        // coefficients outer and samples inner, so each step of the recurrence is a straight vector op
+        for( size_t first = 0; first < numItems; first += chunk ) {
+            const size_t count = std::min( chunk, numItems - first );
+            const real   *x    = a + first;
+            real         b1[chunk], b2[chunk], twoX[chunk];
+            for( size_t i = 0; i < count; ++i ) {
+                b1[ i ]   = real( 0 );
+                b2[ i ]   = real( 0 );
+                twoX[ i ] = real( 2 ) * x[ i ];
+            }
+            for( size_t k = coefficientCount - 1; k > 0; --k ) {
+                const real c = coefficients[ k ];
+                for( size_t i = 0; i < count; ++i ) {
+                    const real b0 = (twoX[ i ] * b1[ i ]) - b2[ i ] + c;
+                    b2[ i ] = b1[ i ];
+                    b1[ i ] = b0;
+                }
+            }
+            for( size_t i = 0; i < count; ++i ) {
+                o[ first + i ] = (x[ i ] * b1[ i ]) - b2[ i ] + coefficients[ 0 ];
+            }
+        }
+    }
+
+    void BasicCPPVectorALU::accumulate( const size_t numItems, const_real_array_ptr a, const real scale,
+                                        real_array_ptr o ) const {
+        assert( a != o );
+        for( size_t i = 0; i < numItems; ++i ) { o[ i ] += scale * a[ i ]; }
+    }
+
+    void BasicCPPVectorALU::accumulateProduct( const size_t numItems, const_real_array_ptr a, const_real_array_ptr b,
+                                               real_array_ptr o ) const {
+        assert( a != o );
+        assert( b != o );
+        for( size_t i = 0; i < numItems; ++i ) { o[ i ] += a[ i ] * b[ i ]; }
+    }
+
+    real BasicCPPVectorALU::dot( const size_t numItems, const_real_array_ptr a, const_real_array_ptr b ) const {
+        if( getReductionMode( ) == ReductionMode::Reproducible ) {
+            return Reduction::dot( numItems, a, b );
+        }
+        // independent partial sums so the loop isn't one long add chain
+        real s0 = real( 0 ), s1 = real( 0 ), s2 = real( 0 ), s3 = real( 0 );
+        size_t i = 0;
+        for( ; i + 4 <= numItems; i += 4 ) {
+            s0 += a[ i + 0 ] * b[ i + 0 ];
+            s1 += a[ i + 1 ] * b[ i + 1 ];
+            s2 += a[ i + 2 ] * b[ i + 2 ];
+            s3 += a[ i + 3 ] * b[ i + 3 ];
+        }
+        for( ; i < numItems; ++i ) { s0 += a[ i ] * b[ i ]; }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    real BasicCPPVectorALU::sumSquaredDifference( const size_t numItems, const_real_array_ptr a,
+                                                  const_real_array_ptr b ) const {
+        if( getReductionMode( ) == ReductionMode::Reproducible ) {
+            return Reduction::sumSquaredDifference( numItems, a, b );
+        }
+        real s0 = real( 0 ), s1 = real( 0 ), s2 = real( 0 ), s3 = real( 0 );
+        size_t i = 0;
+        for( ; i + 4 <= numItems; i += 4 ) {
+            const real d0 = a[ i + 0 ] - b[ i + 0 ], d1 = a[ i + 1 ] - b[ i + 1 ];
+            const real d2 = a[ i + 2 ] - b[ i + 2 ], d3 = a[ i + 3 ] - b[ i + 3 ];
+            s0 += d0 * d0;
+            s1 += d1 * d1;
+            s2 += d2 * d2;
+            s3 += d3 * d3;
+        }
+        for( ; i < numItems; ++i ) {
+            const real d = a[ i ] - b[ i ];
+            s0 += d * d;
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
     BasicCPPVectorALU::real_array_ptr BasicCPPVectorALU::newRealVector(const size_t size) const {
         return new real[size];
     }
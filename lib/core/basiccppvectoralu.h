@@ -120,6 +120,99 @@ namespace Core {
         virtual void scatter( const size_t numItems, const_real_array_ptr a, const size_t stride,
                               real *o ) const override;
 
+        virtual void gemm( const bool transA, const bool transB, const size_t m, const size_t n, const size_t k,
+                           const real alpha, const_real_array_ptr a, const size_t lda, const_real_array_ptr b,
+                           const size_t ldb, const real beta, real_array_ptr o, const size_t ldo ) const override;
+
+        virtual void gemv( const bool transA, const size_t m, const size_t n, const real alpha, const_real_array_ptr a,
+                           const size_t lda, const_real_array_ptr x, const real beta,
+                           real_array_ptr o ) const override;
+
+        // 8 floats is an AVX register, the panel kernels keep a panel row of accumulators live
+        virtual size_t preferredPanelWidth() const override { return maxPanelWidth / 2; }
+
+        virtual void packPanels( const size_t rows, const size_t cols, const_real_array_ptr src, const size_t ld,
+                                 const bool transposed, const size_t panelWidth, real_array_ptr o ) const override;
+
+        virtual void unpackPanels( const size_t rows, const size_t cols, const_real_array_ptr packed,
+                                   const size_t panelWidth, real_array_ptr o, const size_t ldo ) const override;
+
+        virtual void transposePanels( const size_t rows, const size_t cols, const_real_array_ptr packed,
+                                      const size_t panelWidth, const size_t oCols, real_array_ptr o ) const override;
+
+        virtual void packedGemm( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                 const size_t lda, const_real_array_ptr b, const size_t panelWidth, const real beta,
+                                 real_array_ptr o, const size_t ldo ) const override;
+
+        virtual void packedGemmTransposed( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                           const size_t lda, const_real_array_ptr b, const size_t bRows,
+                                           const size_t panelWidth, const real beta, real_array_ptr o,
+                                           const size_t ldo ) const override;
+
+        virtual void packedOuterAccumulate( const size_t m, const size_t k, const size_t n, const_real_array_ptr a,
+                                            const size_t lda, const_real_array_ptr b, const size_t ldb,
+                                            const size_t panelWidth, real_array_ptr o ) const override;
+
+        virtual void packedDenseActivate( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                          const size_t lda, const_real_array_ptr b, const size_t panelWidth,
+                                          const ActivationKernel act, const real param0, const real param1,
+                                          real_array_ptr sums, const size_t lds, real_array_ptr o,
+                                          const size_t ldo ) const override;
+
+        virtual void packedDenseAccumulate( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                            const size_t lda, const_real_array_ptr b, const size_t panelWidth,
+                                            real_array_ptr o, const size_t ldo ) const override;
+
+        virtual void momentumStep( const size_t numItems, const real learningRate, const real momentum,
+                                   const bool nesterov, const real gradScale, real_array_ptr weights,
+                                   real_array_ptr gradients, real_array_ptr velocity ) const override;
+
+        virtual void rmsPropStep( const size_t numItems, const real learningRate, const real decay,
+                                  const real epsilon, const real gradScale, real_array_ptr weights,
+                                  real_array_ptr gradients, real_array_ptr meanSquare ) const override;
+
+        virtual void adamStep( const size_t numItems, const real learningRate, const real beta1, const real beta2,
+                               const real epsilon, const real gradScale, real_array_ptr weights,
+                               real_array_ptr gradients, real_array_ptr firstMoment,
+                               real_array_ptr secondMoment ) const override;
+
+        virtual void laneDenseActivate( const size_t lanes, const size_t n, const size_t k, const_real_array_ptr a,
+                                        const_real_array_ptr b, const ActivationKernel act, const real param0,
+                                        const real param1, real_array_ptr sums, real_array_ptr o ) const override;
+
+        virtual void laneOuterAccumulate( const size_t lanes, const size_t k, const size_t n, const_real_array_ptr a,
+                                          const_real_array_ptr delta, real_array_ptr o ) const override;
+
+        virtual void laneTransposedProduct( const size_t lanes, const size_t k, const size_t n, const_real_array_ptr b,
+                                            const_real_array_ptr delta, real_array_ptr o ) const override;
+
+        virtual void laneMomentumStep( const size_t lanes, const size_t numItems, const_real_array_ptr learningRate,
+                                       const_real_array_ptr momentum, const real gradScale, real_array_ptr weights,
+                                       real_array_ptr gradients, real_array_ptr velocity ) const override;
+
+        virtual void activate( const size_t numItems, const ActivationKernel act, const real param0,
+                               const real param1, const_real_array_ptr a, real_array_ptr o ) const override;
+
+        virtual void mulActivationDerivative( const size_t numItems, const ActivationKernel act, const real param0,
+                                              const_real_array_ptr sums, real_array_ptr o ) const override;
+
+        virtual void chebyshevSeries( const size_t numItems, const_real_array_ptr coefficients,
+                                      const size_t coefficientCount, const_real_array_ptr a,
+                                      real_array_ptr o ) const override;
+
+        virtual void accumulate( const size_t numItems, const_real_array_ptr a, const real scale,
+                                 real_array_ptr o ) const override;
+
+        virtual void accumulateProduct( const size_t numItems, const_real_array_ptr a, const_real_array_ptr b,
+                                        real_array_ptr o ) const override;
+
+        virtual real dot( const size_t numItems, const_real_array_ptr a, const_real_array_ptr b ) const override;
+
+        virtual real sumSquaredDifference( const size_t numItems, const_real_array_ptr a,
+                                           const_real_array_ptr b ) const override;
+
+        static constexpr size_t maxPanelWidth = 16;
+
     protected:
         void UnOp( const size_t numItems, const_real_array_ptr a, real_array_ptr o,
                    const std::function<real( const real )> lambda ) const {
@@ -6,5 +6,7 @@
 #include "core/random.h"
 
 namespace Core {
-    Random::generator_type Random::generator;
+    Random::generator_type        Random::generator;
+    std::atomic<uint64_t>         Random::streamSeed( 5489u ); // boost mt19937's default seed
+    std::atomic<uint64_t>         Random::nextStreamId( 0 );
 }
\ No newline at end of file
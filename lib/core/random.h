@@ -5,13 +5,16 @@
 #pragma once
 
 #include "core/core.h"
+#include <atomic>
 #include <ctime>
 #include <boost/random.hpp>
+#include "core/randomstream.h"
 
 namespace Core {
 
     // thin wrapper around boost random, just a singleton
     // with a easy place to change and seed
+    // the shared generator isn't thread safe, anything parallel or bulk should take its own RandomStream
     struct Random {
         typedef boost::random::mt19937                                                           generator_type;
         typedef boost::random::uniform_real_distribution<>                                       ur_distribution_type;
@@ -21,8 +24,23 @@ namespace Core {
 
         static void seed( unsigned int seed = static_cast<unsigned int>(std::time( 0 )) ) {
             generator.seed( seed );
+            streamSeed.store( seed );
+            nextStreamId.store( 0 );
         }
 
-        static generator_type generator;
+        // the next unused stream of the seed, safe from any thread. re-seeding restarts the numbering so a
+        // single threaded program gets the same streams every run
+        static RandomStream newStream() {
+            return RandomStream( streamSeed.load( ), nextStreamId.fetch_add( 1 ) );
+        }
+
+        // a specific stream of the seed, e.g. one per worker thread or per network
+        static RandomStream stream( const uint64_t streamId ) {
+            return RandomStream( streamSeed.load( ), streamId );
+        }
+
+        static generator_type        generator;
+        static std::atomic<uint64_t> streamSeed;
+        static std::atomic<uint64_t> nextStreamId;
     };
 }
\ No newline at end of file
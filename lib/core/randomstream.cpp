@@ -0,0 +1,142 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "core/randomstream.h"
+
+namespace Core {
+
+    namespace {
+        constexpr uint32_t philoxM0     = 0xD2511F53;
+        constexpr uint32_t philoxM1     = 0xCD9E8D57;
+        constexpr uint32_t philoxW0     = 0x9E3779B9;
+        constexpr uint32_t philoxW1     = 0xBB67AE85;
+        constexpr int      philoxRounds = 10;
+
+        // blocks generated side by side, the round function is then straight line code across lanes
+        constexpr size_t laneCount = 8;
+
+        // top 24 bits to a float in [0, 1)
+        inline real toUnit( const uint32_t x ) {
+            return real( x >> 8 ) * real( 1.0 / 16777216.0 );
+        }
+
+        // (0, 1], safe for log
+        inline real toUnitOpen( const uint32_t x ) {
+            return real( (x >> 8) + 1 ) * real( 1.0 / 16777216.0 );
+        }
+    }
+
+    Philox4x32::Counter Philox4x32::generate( Counter counter, Key key ) {
+        for( int r = 0; r < philoxRounds; ++r ) {
+            const uint64_t p0 = uint64_t( philoxM0 ) * counter[ 0 ];
+            const uint64_t p1 = uint64_t( philoxM1 ) * counter[ 2 ];
+            counter = { uint32_t( p1 >> 32 ) ^ counter[ 1 ] ^ key[ 0 ], uint32_t( p1 ),
+                        uint32_t( p0 >> 32 ) ^ counter[ 3 ] ^ key[ 1 ], uint32_t( p0 ) };
+            key[ 0 ] += philoxW0;
+            key[ 1 ] += philoxW1;
+        }
+        return counter;
+    }
+
+    RandomStream::RandomStream( const uint64_t seed, const uint64_t _streamId ) :
+            key{ { uint32_t( seed ), uint32_t( seed >> 32 ) } },
+            streamId( _streamId ),
+            block( 0 ),
+            buffered{ },
+            bufferedCount( 0 ) {
+    }
+
+    template<typename Emit>
+    void RandomStream::generateBlocks( const size_t numBlocks, Emit emit ) {
+        const uint32_t s0 = uint32_t( streamId );
+        const uint32_t s1 = uint32_t( streamId >> 32 );
+
+        for( size_t first = 0; first < numBlocks; first += laneCount ) {
+            const size_t lanes = std::min( laneCount, numBlocks - first );
+
+            uint32_t c0[laneCount], c1[laneCount], c2[laneCount], c3[laneCount];
+            for( size_t l = 0; l < laneCount; ++l ) {
+                const uint64_t b = block + first + l;
+                c0[ l ] = uint32_t( b );
+                c1[ l ] = uint32_t( b >> 32 );
+                c2[ l ] = s0;
+                c3[ l ] = s1;
+            }
+
+            uint32_t k0 = key[ 0 ], k1 = key[ 1 ];
+            for( int r = 0; r < philoxRounds; ++r ) {
+                for( size_t l = 0; l < laneCount; ++l ) {
+                    const uint64_t p0 = uint64_t( philoxM0 ) * c0[ l ];
+                    const uint64_t p1 = uint64_t( philoxM1 ) * c2[ l ];
+                    const uint32_t n0 = uint32_t( p1 >> 32 ) ^ c1[ l ] ^ k0;
+                    const uint32_t n2 = uint32_t( p0 >> 32 ) ^ c3[ l ] ^ k1;
+                    c1[ l ] = uint32_t( p1 );
+                    c3[ l ] = uint32_t( p0 );
+                    c0[ l ] = n0;
+                    c2[ l ] = n2;
+                }
+                k0 += philoxW0;
+                k1 += philoxW1;
+            }
+
+            for( size_t l = 0; l < lanes; ++l ) {
+                emit( first + l, c0[ l ], c1[ l ], c2[ l ], c3[ l ] );
+            }
+        }
+        block += numBlocks;
+    }
+
+    uint32_t RandomStream::next() {
+        if( bufferedCount == 0 ) {
+            buffered = Philox4x32::generate( { uint32_t( block ), uint32_t( block >> 32 ),
+                                               uint32_t( streamId ), uint32_t( streamId >> 32 ) }, key );
+            block++;
+            bufferedCount = 4;
+        }
+        return buffered[ 4 - bufferedCount-- ];
+    }
+
+    real RandomStream::nextUniform() {
+        return toUnit( next( ) );
+    }
+
+    void RandomStream::fillUniform( const size_t numItems, const real lo, const real hi, real *o ) {
+        bufferedCount = 0;
+        const real scale = hi - lo;
+        generateBlocks( (numItems + 3) / 4, [ = ]( const size_t b, const uint32_t x0, const uint32_t x1,
+                                                    const uint32_t x2, const uint32_t x3 ) {
+            const uint32_t x[4] = { x0, x1, x2, x3 };
+            const size_t   base = b * 4;
+            for( size_t j = 0; j < 4 && (base + j) < numItems; ++j ) {
+                o[ base + j ] = lo + (scale * toUnit( x[ j ] ));
+            }
+        } );
+    }
+
+    void RandomStream::fillNormal( const size_t numItems, const real mean, const real stddev, real *o ) {
+        bufferedCount = 0;
+        constexpr real twoPi = real( 6.283185307179586 );
+        generateBlocks( (numItems + 3) / 4, [ = ]( const size_t b, const uint32_t x0, const uint32_t x1,
+                                                    const uint32_t x2, const uint32_t x3 ) {
+            // each block is two Box-Muller pairs
+            const real r0 = std::sqrt( real( -2 ) * std::log( toUnitOpen( x0 ) ) );
+            const real r1 = std::sqrt( real( -2 ) * std::log( toUnitOpen( x2 ) ) );
+            const real z[4] = { r0 * std::cos( twoPi * toUnit( x1 ) ), r0 * std::sin( twoPi * toUnit( x1 ) ),
+                                r1 * std::cos( twoPi * toUnit( x3 ) ), r1 * std::sin( twoPi * toUnit( x3 ) ) };
+            const size_t base = b * 4;
+            for( size_t j = 0; j < 4 && (base + j) < numItems; ++j ) {
+                o[ base + j ] = mean + (stddev * z[ j ]);
+            }
+        } );
+    }
+
+    void RandomStream::discard( const uint64_t numBlocks ) {
+        bufferedCount = 0;
+        block += numBlocks;
+    }
+}
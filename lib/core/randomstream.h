@@ -0,0 +1,63 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "core/core.h"
+
+namespace Core {
+
+    /*
+     * Philox4x32-10 counter based generator (Salmon et al, Random123). Output is a pure function of a 128 bit counter
+     * and a 64 bit key, so there is no state to share or lock and any block can be computed independently
+     */
+    struct Philox4x32 {
+        using Counter = std::array<uint32_t, 4>;
+        using Key     = std::array<uint32_t, 2>;
+
+        static Counter generate( Counter counter, Key key );
+    };
+
+    /*
+     * An independent reproducible random stream, the key is the seed and the top half of the counter is the stream
+     * id so every ( seed, stream ) pair is its own sequence. Give each thread or network its own stream id and they
+     * never contend or overlap.
+     * Fills consume whole 4 value blocks and element i of a fill always comes from block i / 4, so the same seed,
+     * stream and fill sizes produce the same numbers however the work is split.
+     */
+    class RandomStream {
+    public:
+        RandomStream( const uint64_t seed, const uint64_t streamId );
+
+        uint32_t next();
+
+        // [0, 1)
+        real nextUniform();
+
+        // bulk fills, blocks of counters are generated together so the loops vectorise
+        void fillUniform( const size_t numItems, const real lo, const real hi, real *o );
+
+        // Box-Muller
+        void fillNormal( const size_t numItems, const real mean, const real stddev, real *o );
+
+        // skip ahead numBlocks 4 value blocks without generating them
+        void discard( const uint64_t numBlocks );
+
+        uint64_t getBlockPosition() const { return block; }
+
+    private:
+        template<typename Emit>
+        void generateBlocks( const size_t numBlocks, Emit emit );
+
+        Philox4x32::Key key;
+        uint64_t        streamId;
+        uint64_t        block;
+
+        // leftovers of the last block for next(), fills always start on a fresh block
+        Philox4x32::Counter buffered;
+        unsigned            bufferedCount;
+    };
+}
@@ -0,0 +1,102 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "core/core.h"
+#include "core/reduction.h"
+#include "core/threadpool.h"
+
+namespace Core {
+
+    namespace {
+        std::atomic<ReductionMode> sReductionMode( ReductionMode::Fast );
+
+        template<typename Term>
+        real TreeReduce( const size_t numItems, ThreadPool *pool, Term term ) {
+            const size_t leafCount = (numItems + Reduction::leafSize - 1) / Reduction::leafSize;
+            if( leafCount == 0 ) {
+                return real( 0 );
+            }
+
+            std::vector<NeumaierSum> leaves( leafCount );
+            const auto               sumLeaves = [ &leaves, &term, numItems ]( const size_t first, const size_t last ) {
+                for( size_t l = first; l < last; ++l ) {
+                    const size_t begin = l * Reduction::leafSize;
+                    const size_t end   = std::min( begin + Reduction::leafSize, numItems );
+                    NeumaierSum  acc;
+                    for( size_t i = begin; i < end; ++i ) { acc.add( term( i ) ); }
+                    leaves[ l ] = acc;
+                }
+            };
+
+            // which thread sums a leaf makes no difference, the leaves are only combined below
+            const size_t threads = (pool != nullptr) ? std::min( pool->getThreadCount( ), leafCount ) : 1;
+            if( threads <= 1 ) {
+                sumLeaves( 0, leafCount );
+            } else {
+                const size_t perThread = (leafCount + threads - 1) / threads;
+                for( size_t first = 0; first < leafCount; first += perThread ) {
+                    const size_t last = std::min( first + perThread, leafCount );
+                    pool->submit( [ &sumLeaves, first, last ]() { sumLeaves( first, last ); } );
+                }
+                pool->wait( );
+            }
+
+            // balanced pairwise tree, an odd leaf out is carried up unchanged
+            for( size_t count = leafCount; count > 1; count = (count + 1) / 2 ) {
+                for( size_t i = 0; i < count / 2; ++i ) {
+                    NeumaierSum combined = leaves[ 2 * i ];
+                    combined.add( leaves[ (2 * i) + 1 ] );
+                    leaves[ i ] = combined;
+                }
+                if( count & 1 ) {
+                    leaves[ count / 2 ] = leaves[ count - 1 ];
+                }
+            }
+            return leaves[ 0 ].result( );
+        }
+    }
+
+    void setReductionMode( const ReductionMode mode ) {
+        sReductionMode.store( mode );
+    }
+
+    ReductionMode getReductionMode() {
+        return sReductionMode.load( std::memory_order_relaxed );
+    }
+
+    namespace Reduction {
+        real sum( const size_t numItems, const real *a, ThreadPool *pool ) {
+            return TreeReduce( numItems, pool, [ a ]( const size_t i ) { return a[ i ]; } );
+        }
+
+        real sumAbs( const size_t numItems, const real *a, ThreadPool *pool ) {
+            return TreeReduce( numItems, pool, [ a ]( const size_t i ) { return std::fabs( a[ i ] ); } );
+        }
+
+        real sumSquares( const size_t numItems, const real *a, ThreadPool *pool ) {
+            return TreeReduce( numItems, pool, [ a ]( const size_t i ) { return a[ i ] * a[ i ]; } );
+        }
+
+        real sumAbsCubes( const size_t numItems, const real *a, ThreadPool *pool ) {
+            return TreeReduce( numItems, pool, [ a ]( const size_t i ) {
+                const real x = std::fabs( a[ i ] );
+                return x * x * x;
+            } );
+        }
+
+        real dot( const size_t numItems, const real *a, const real *b, ThreadPool *pool ) {
+            return TreeReduce( numItems, pool, [ a, b ]( const size_t i ) { return a[ i ] * b[ i ]; } );
+        }
+
+        real sumSquaredDifference( const size_t numItems, const real *a, const real *b, ThreadPool *pool ) {
+            return TreeReduce( numItems, pool, [ a, b ]( const size_t i ) {
+                const real d = a[ i ] - b[ i ];
+                return d * d;
+            } );
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "core/core.h"
+
+namespace Core {
+
+    class ThreadPool;
+
+    // Fast sums in whatever order the backend likes, Reproducible gives the same bits for the same input whatever
+    // the thread count or backend, at the cost of compensation and a fixed reduction tree. Process wide, as the
+    // ALU singleton can come and go
+    enum class ReductionMode : uint8_t {
+        Fast,
+        Reproducible
+    };
+
+    void setReductionMode( const ReductionMode mode );
+
+    ReductionMode getReductionMode();
+
+    // Neumaier's improved Kahan summation, the running error is carried separately and added back at the end
+    struct NeumaierSum {
+        real sum          = real( 0 );
+        real compensation = real( 0 );
+
+        void add( const real x ) {
+            const real t = sum + x;
+            if( std::fabs( sum ) >= std::fabs( x ) ) {
+                compensation += (sum - t) + x;
+            } else {
+                compensation += (x - t) + sum;
+            }
+            sum = t;
+        }
+
+        void add( const NeumaierSum &other ) {
+            add( other.sum );
+            compensation += other.compensation;
+        }
+
+        real result() const { return sum + compensation; }
+    };
+
+    /*
+     * Fixed shape reductions: the input is cut into leaves of leafSize, each leaf is summed in order with
+     * compensation and the leaf results are combined pairwise in a balanced tree over the leaf index. The shape only
+     * depends on numItems so leaves can be spread over any number of threads without changing a bit of the result.
+     * With a pool the leaves are split across its workers, this waits on the pool so don't call it from a pool task.
+     */
+    namespace Reduction {
+        constexpr size_t leafSize = 256;
+
+        real sum( const size_t numItems, const real *a, ThreadPool *pool = nullptr );
+
+        real sumAbs( const size_t numItems, const real *a, ThreadPool *pool = nullptr );
+
+        real sumSquares( const size_t numItems, const real *a, ThreadPool *pool = nullptr );
+
+        real sumAbsCubes( const size_t numItems, const real *a, ThreadPool *pool = nullptr );
+
+        real dot( const size_t numItems, const real *a, const real *b, ThreadPool *pool = nullptr );
+
+        // sum of ( a - b )^2, the error metrics
+        real sumSquaredDifference( const size_t numItems, const real *a, const real *b, ThreadPool *pool = nullptr );
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include "core/core.h"
+#include "core/trace.h"
+#include "core/ringallreduce.h"
+
+namespace Core {
+
+    RingAllreduce::RingAllreduce( RingTransport &_transport ) :
+            transport( _transport ) {
+    }
+
+    bool RingAllreduce::sum( const size_t count, real *data ) {
+        CORE_TRACE_SCOPE_ARG( "RingAllreduce::sum", count );
+        const size_t size = transport.getSize( );
+        const size_t rank = transport.getRank( );
+        if( size == 1 || count == 0 ) {
+            return true;
+        }
+
+        // chunk c is [ c * count / size, ( c + 1 ) * count / size ), sizes differ by at most one
+        const auto begin = [ count, size ]( const size_t chunk ) { return (chunk * count) / size; };
+        const auto bytes = [ &begin ]( const size_t chunk ) {
+            return (begin( chunk + 1 ) - begin( chunk )) * sizeof( real );
+        };
+        incoming.resize( (count + size - 1) / size );
+
+        // reduce scatter, after step s the chunk received holds the sum of s + 2 ranks
+        for( size_t step = 0; step < size - 1; ++step ) {
+            const size_t out = (rank + size - step) % size;
+            const size_t in  = (rank + size - step - 1) % size;
+            if( !transport.exchange( data + begin( out ), bytes( out ), incoming.data( ), bytes( in ) ) ) {
+                return false;
+            }
+            real *target = data + begin( in );
+            for( size_t i = 0, n = begin( in + 1 ) - begin( in ); i < n; ++i ) { target[ i ] += incoming[ i ]; }
+        }
+
+        // all gather, rank r starts owning the finished chunk r + 1
+        for( size_t step = 0; step < size - 1; ++step ) {
+            const size_t out = (rank + 1 + size - step) % size;
+            const size_t in  = (rank + size - step) % size;
+            if( !transport.exchange( data + begin( out ), bytes( out ), data + begin( in ), bytes( in ) ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool RingAllreduce::barrier() {
+        // round k can't finish until rank - k has arrived, so after size - 1 rounds everyone has
+        uint8_t token = 0, received = 0;
+        for( size_t i = 0; i + 1 < transport.getSize( ); ++i ) {
+            if( !transport.exchange( &token, 1, &received, 1 ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
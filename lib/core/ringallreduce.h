@@ -0,0 +1,36 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <vector>
+#include "core/core.h"
+#include "core/ringtransport.h"
+
+namespace Core {
+
+    /*
+     * Bandwidth optimal allreduce over a RingTransport. The array is cut into one chunk per rank, a reduce scatter
+     * passes partial sums round the ring until each rank holds one fully reduced chunk, then an all gather passes
+     * those round so everyone has all of them. Each rank sends and receives 2 (size - 1) / size of the array
+     * whatever the rank count. The gather copies the finished chunks, so every rank ends with bit identical values
+     * and replicas that apply them stay in lock step.
+     */
+    class RingAllreduce {
+    public:
+        explicit RingAllreduce( RingTransport &_transport );
+
+        RingTransport &getTransport() { return transport; }
+
+        // element wise sum across every rank in place. false if the transport failed, data is then undefined
+        bool sum( const size_t count, real *data );
+
+        // returns once every rank has called it
+        bool barrier();
+
+    private:
+        RingTransport     &transport;
+        std::vector<real> incoming;
+    };
+}
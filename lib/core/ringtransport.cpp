@@ -0,0 +1,365 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "core/core.h"
+#include "core/trace.h"
+#include "core/ringtransport.h"
+
+namespace Core {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // spins this many times without progress before yielding the core
+        constexpr int spinsBeforeYield = 64;
+
+        void closeIfOpen( int &fd ) {
+            if( fd >= 0 ) {
+                ::close( fd );
+                fd = -1;
+            }
+        }
+
+        // tracks time since the last progress, so a slow but moving peer never times out
+        class Deadline {
+        public:
+            explicit Deadline( const uint32_t milliseconds ) :
+                    limit( std::chrono::milliseconds( milliseconds ) ),
+                    last( Clock::now( ) ),
+                    idle( 0 ) {}
+
+            void progressed() {
+                last = Clock::now( );
+                idle = 0;
+            }
+
+            // back off a little, false once the limit has passed
+            bool wait() {
+                if( ++idle < spinsBeforeYield ) { return true; }
+                std::this_thread::yield( );
+                return Clock::now( ) - last < limit;
+            }
+
+            int remainingMilliseconds() const {
+                using namespace std::chrono;
+                const auto left = duration_cast<milliseconds>( limit - (Clock::now( ) - last) ).count( );
+                return int( std::max( long( left ), long( 0 ) ) );
+            }
+
+        private:
+            const Clock::duration limit;
+            Clock::time_point     last;
+            int                   idle;
+        };
+    }
+
+    // counters only ever grow, position in the ring is counter % capacity. each on its own line as the two ends
+    // write one each
+    struct SharedMemoryTransport::Inbox {
+        alignas( 64 ) std::atomic<uint64_t> written;
+        alignas( 64 ) std::atomic<uint64_t> read;
+        alignas( 64 ) std::atomic<uint32_t> ready; // set once the owner has initialised the segment
+
+        uint8_t *data() { return reinterpret_cast<uint8_t *>( this + 1 ); }
+    };
+
+    SharedMemoryTransport::SharedMemoryTransport( const Config &_config ) :
+            RingTransport( _config ),
+            name( _config.name ),
+            capacity( _config.capacity ),
+            inbox( nullptr ),
+            outbox( nullptr ),
+            unlinked( false ) {
+        assert( config.size > 0 && config.rank < config.size );
+        assert( !name.empty( ) && name.find( '/' ) == std::string::npos );
+        assert( capacity > 0 );
+        static_assert( std::atomic<uint64_t>::is_always_lock_free, "shared memory counters must be lock free" );
+    }
+
+    SharedMemoryTransport::~SharedMemoryTransport() {
+        const size_t bytes = sizeof( Inbox ) + capacity;
+        if( inbox != nullptr ) {
+            ::munmap( inbox, bytes );
+            if( !unlinked ) { ::shm_unlink( segmentName( config.rank ).c_str( ) ); }
+        }
+        if( outbox != nullptr ) { ::munmap( outbox, bytes ); }
+    }
+
+    std::string SharedMemoryTransport::segmentName( const size_t rank ) const {
+        return "/" + name + "." + std::to_string( rank );
+    }
+
+    bool SharedMemoryTransport::open() {
+        CORE_TRACE_SCOPE( "SharedMemoryTransport::open" );
+        assert( inbox == nullptr );
+        const size_t bytes = sizeof( Inbox ) + capacity;
+
+        // our inbox, anything of the same name is left over from a dead job
+        const std::string ownName = segmentName( config.rank );
+        ::shm_unlink( ownName.c_str( ) );
+        int fd = ::shm_open( ownName.c_str( ), O_CREAT | O_EXCL | O_RDWR, 0600 );
+        if( fd < 0 ) { return false; }
+        if( ::ftruncate( fd, off_t( bytes ) ) != 0 ) {
+            ::close( fd );
+            return false;
+        }
+        void *mapped = ::mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        ::close( fd );
+        if( mapped == MAP_FAILED ) { return false; }
+        inbox = new( mapped ) Inbox( );
+        inbox->written.store( 0, std::memory_order_relaxed );
+        inbox->read.store( 0, std::memory_order_relaxed );
+        inbox->ready.store( 1, std::memory_order_release );
+
+        // the next ranks inbox, which may not exist yet
+        const std::string nextName = segmentName( (config.rank + 1) % config.size );
+        Deadline          deadline( config.timeoutMilliseconds );
+        for( ;; ) {
+            fd = ::shm_open( nextName.c_str( ), O_RDWR, 0600 );
+            if( fd >= 0 ) {
+                struct stat st{ };
+                if( ::fstat( fd, &st ) == 0 && size_t( st.st_size ) == bytes ) {
+                    mapped = ::mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+                    ::close( fd );
+                    if( mapped == MAP_FAILED ) { return false; }
+                    auto *next = static_cast<Inbox *>( mapped );
+                    if( next->ready.load( std::memory_order_acquire ) == 1 ) {
+                        outbox = next;
+                        break;
+                    }
+                    ::munmap( mapped, bytes );
+                } else {
+                    // created but not sized yet
+                    ::close( fd );
+                }
+            }
+            if( !deadline.wait( ) ) {
+                errno = ETIMEDOUT;
+                return false;
+            }
+        }
+
+        // once the previous rank has written to us it has our inbox mapped, so the name can go
+        uint8_t token = 0, received = 0;
+        if( !exchange( &token, 1, &received, 1 ) ) { return false; }
+        ::shm_unlink( ownName.c_str( ) );
+        unlinked = true;
+        return true;
+    }
+
+    bool SharedMemoryTransport::exchange( const void *send, const size_t sendBytes, void *receive,
+                                          const size_t receiveBytes ) {
+        CORE_TRACE_SCOPE_ARG( "SharedMemoryTransport::exchange", sendBytes );
+        assert( inbox != nullptr && outbox != nullptr );
+
+        auto     *src = static_cast<const uint8_t *>( send );
+        auto     *dst = static_cast<uint8_t *>( receive );
+        size_t   sent = 0, got = 0;
+        Deadline deadline( config.timeoutMilliseconds );
+
+        // only we write outbox->written and inbox->read, so those are plain loads of our own last stores
+        while( sent < sendBytes || got < receiveBytes ) {
+            bool progress = false;
+
+            if( sent < sendBytes ) {
+                const uint64_t head  = outbox->written.load( std::memory_order_relaxed );
+                const uint64_t tail  = outbox->read.load( std::memory_order_acquire );
+                const size_t   space = capacity - size_t( head - tail );
+                const size_t   count = std::min( space, sendBytes - sent );
+                if( count > 0 ) {
+                    const size_t at    = size_t( head % capacity );
+                    const size_t first = std::min( count, capacity - at );
+                    std::memcpy( outbox->data( ) + at, src + sent, first );
+                    std::memcpy( outbox->data( ), src + sent + first, count - first );
+                    outbox->written.store( head + count, std::memory_order_release );
+                    sent += count;
+                    progress = true;
+                }
+            }
+
+            if( got < receiveBytes ) {
+                const uint64_t tail      = inbox->read.load( std::memory_order_relaxed );
+                const uint64_t head      = inbox->written.load( std::memory_order_acquire );
+                const size_t   available = size_t( head - tail );
+                const size_t   count     = std::min( available, receiveBytes - got );
+                if( count > 0 ) {
+                    const size_t at    = size_t( tail % capacity );
+                    const size_t first = std::min( count, capacity - at );
+                    std::memcpy( dst + got, inbox->data( ) + at, first );
+                    std::memcpy( dst + got + first, inbox->data( ), count - first );
+                    inbox->read.store( tail + count, std::memory_order_release );
+                    got += count;
+                    progress = true;
+                }
+            }
+
+            if( progress ) {
+                deadline.progressed( );
+            } else if( !deadline.wait( ) ) {
+                errno = ETIMEDOUT;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    TcpTransport::TcpTransport( const Config &_config ) :
+            RingTransport( _config ),
+            host( _config.host ),
+            listenHost( _config.listenHost.empty( ) ? _config.host : _config.listenHost ),
+            basePort( _config.basePort ),
+            listenFd( -1 ),
+            sendFd( -1 ),
+            receiveFd( -1 ) {
+        assert( config.size > 0 && config.rank < config.size );
+        assert( size_t( basePort ) + config.size <= 65536 );
+    }
+
+    TcpTransport::~TcpTransport() {
+        closeIfOpen( receiveFd );
+        closeIfOpen( sendFd );
+        closeIfOpen( listenFd );
+    }
+
+    bool TcpTransport::open() {
+        CORE_TRACE_SCOPE( "TcpTransport::open" );
+        assert( listenFd < 0 );
+
+        const int one = 1;
+
+        sockaddr_in own{ };
+        own.sin_family = AF_INET;
+        own.sin_port   = htons( uint16_t( basePort + config.rank ) );
+        if( ::inet_pton( AF_INET, listenHost.c_str( ), &own.sin_addr ) != 1 ) {
+            errno = EINVAL;
+            return false;
+        }
+        listenFd = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        if( listenFd < 0 ) { return false; }
+        ::setsockopt( listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ) );
+        if( ::bind( listenFd, reinterpret_cast<sockaddr *>( &own ), sizeof( own ) ) != 0 ||
+            ::listen( listenFd, 1 ) != 0 ) {
+            return false;
+        }
+
+        // the next rank may not be listening yet, the connection completes from its backlog without an accept
+        sockaddr_in next{ };
+        next.sin_family = AF_INET;
+        next.sin_port   = htons( uint16_t( basePort + ((config.rank + 1) % config.size) ) );
+        if( ::inet_pton( AF_INET, host.c_str( ), &next.sin_addr ) != 1 ) {
+            errno = EINVAL;
+            return false;
+        }
+        Deadline deadline( config.timeoutMilliseconds );
+        for( ;; ) {
+            sendFd = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+            if( sendFd < 0 ) { return false; }
+            if( ::connect( sendFd, reinterpret_cast<sockaddr *>( &next ), sizeof( next ) ) == 0 ) { break; }
+            closeIfOpen( sendFd );
+            if( errno != ECONNREFUSED || deadline.remainingMilliseconds( ) == 0 ) { return false; }
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+
+        pollfd pending{ listenFd, POLLIN, 0 };
+        if( ::poll( &pending, 1, int( config.timeoutMilliseconds ) ) != 1 ) {
+            errno = ETIMEDOUT;
+            return false;
+        }
+        receiveFd = ::accept4( listenFd, nullptr, nullptr, SOCK_CLOEXEC );
+        if( receiveFd < 0 ) { return false; }
+        closeIfOpen( listenFd );
+
+        // small messages can't wait for Nagle, and exchange polls both ends
+        for( const int fd : { sendFd, receiveFd } ) {
+            ::setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+            if( ::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL ) | O_NONBLOCK ) != 0 ) { return false; }
+        }
+        return true;
+    }
+
+    bool TcpTransport::exchange( const void *send, const size_t sendBytes, void *receive, const size_t receiveBytes ) {
+        CORE_TRACE_SCOPE_ARG( "TcpTransport::exchange", sendBytes );
+        assert( sendFd >= 0 && receiveFd >= 0 );
+
+        auto   *src = static_cast<const uint8_t *>( send );
+        auto   *dst = static_cast<uint8_t *>( receive );
+        size_t sent = 0, got = 0;
+
+        while( sent < sendBytes || got < receiveBytes ) {
+            pollfd fds[2];
+            nfds_t count = 0;
+            if( sent < sendBytes ) { fds[ count++ ] = pollfd{ sendFd, POLLOUT, 0 }; }
+            if( got < receiveBytes ) { fds[ count++ ] = pollfd{ receiveFd, POLLIN, 0 }; }
+
+            const int ready = ::poll( fds, count, int( config.timeoutMilliseconds ) );
+            if( ready < 0 && errno == EINTR ) { continue; }
+            if( ready <= 0 ) {
+                if( ready == 0 ) { errno = ETIMEDOUT; }
+                return false;
+            }
+
+            for( nfds_t i = 0; i < count; ++i ) {
+                if( fds[ i ].revents == 0 ) { continue; }
+                if( fds[ i ].fd == sendFd ) {
+                    const ssize_t n = ::send( sendFd, src + sent, sendBytes - sent, MSG_NOSIGNAL );
+                    if( n < 0 && errno != EAGAIN && errno != EWOULDBLOCK ) { return false; }
+                    sent += size_t( std::max( n, ssize_t( 0 ) ) );
+                } else {
+                    const ssize_t n = ::recv( receiveFd, dst + got, receiveBytes - got, 0 );
+                    if( n == 0 ) {
+                        errno = ECONNRESET; // the previous rank hung up mid message
+                        return false;
+                    }
+                    if( n < 0 && errno != EAGAIN && errno != EWOULDBLOCK ) { return false; }
+                    got += size_t( std::max( n, ssize_t( 0 ) ) );
+                }
+            }
+        }
+        return true;
+    }
+
+    bool runRanks( const size_t size, const std::function<int( const size_t rank )> &rankMain ) {
+        assert( size > 0 );
+
+        std::vector<pid_t> children;
+        for( size_t rank = 1; rank < size; ++rank ) {
+            const pid_t pid = ::fork( );
+            if( pid == 0 ) {
+                // skip the parents exit handlers and buffered output, the child owns neither
+                ::_exit( rankMain( rank ) );
+            }
+            if( pid < 0 ) { break; }
+            children.push_back( pid );
+        }
+
+        // if a fork failed the ranks that did start time out waiting for the missing one
+        bool ok = children.size( ) == size - 1;
+        ok = (rankMain( 0 ) == 0) && ok;
+        for( auto &&pid : children ) {
+            int status = 0;
+            while( ::waitpid( pid, &status, 0 ) < 0 && errno == EINTR ) {}
+            ok = ok && WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+        }
+        return ok;
+    }
+}
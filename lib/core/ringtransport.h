@@ -0,0 +1,121 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "core/core.h"
+
+namespace Core {
+
+    /*
+     * Byte stream between the ranks of a job arranged in a ring, each rank only ever sends to rank + 1 and
+     * receives from rank - 1 (wrapping). That is all a ring allreduce needs and it keeps every link single
+     * producer single consumer. Sending and receiving happen together in exchange, interleaved as space and data
+     * allow, so a ring where every rank sends at once never deadlocks however big the messages are.
+     * A transport belongs to one thread at a time.
+     */
+    class RingTransport {
+    public:
+        struct Config {
+            size_t   rank                = 0;
+            size_t   size                = 1;
+            uint32_t timeoutMilliseconds = 30000; // open and exchange give up after this long without progress
+        };
+
+        explicit RingTransport( const Config &_config ) : config( _config ) {}
+
+        virtual ~RingTransport() = default;
+
+        RingTransport( const RingTransport & ) = delete;
+
+        RingTransport &operator=( const RingTransport & ) = delete;
+
+        size_t getRank() const { return config.rank; }
+
+        size_t getSize() const { return config.size; }
+
+        // connect to the neighbours, blocks until they are there too. false on failure or timeout
+        virtual bool open() = 0;
+
+        // sendBytes to the next rank while receiving receiveBytes from the previous one. false on failure or timeout
+        virtual bool exchange( const void *send, const size_t sendBytes, void *receive, const size_t receiveBytes ) = 0;
+
+    protected:
+        const Config config;
+    };
+
+    /*
+     * Ring over POSIX shared memory for ranks on one machine. Every rank creates an inbox segment named
+     * "/<name>.<rank>" holding a byte ring, and maps the inbox of the next rank to write into. Counters are
+     * lock free atomics in the segment so a send is a memcpy and a release store, waits spin then yield.
+     * The segments are unlinked as soon as the ring is connected so nothing is left behind however a rank exits.
+     * name must be unique to the job, a crashed earlier job with the same name can leave a stale inbox behind.
+     */
+    class SharedMemoryTransport : public RingTransport {
+    public:
+        struct Config : RingTransport::Config {
+            std::string name;
+            size_t      capacity = size_t( 1 ) << 20; // bytes in each inbox
+        };
+
+        explicit SharedMemoryTransport( const Config &_config );
+
+        ~SharedMemoryTransport() override;
+
+        bool open() override;
+
+        bool exchange( const void *send, const size_t sendBytes, void *receive, const size_t receiveBytes ) override;
+
+    private:
+        struct Inbox;
+
+        std::string segmentName( const size_t rank ) const;
+
+        const std::string name;
+        const size_t      capacity;
+
+        Inbox *inbox;  // ours, the previous rank writes it
+        Inbox *outbox; // the next ranks
+        bool   unlinked;
+    };
+
+    /*
+     * Ring over TCP, rank r listens on basePort + r and connects to the next ranks port. Loopback by default, the
+     * hosts are all multi node needs. The listener binds one address rather than all of them so a ring isn't open
+     * to the network unless asked. Non blocking sockets polled together so exchange interleaves like the
+     * shared memory ring does.
+     */
+    class TcpTransport : public RingTransport {
+    public:
+        struct Config : RingTransport::Config {
+            std::string host       = "127.0.0.1"; // of the next rank
+            std::string listenHost;               // ours to bind, empty is host as on a single machine
+            uint16_t    basePort   = 29500;
+        };
+
+        explicit TcpTransport( const Config &_config );
+
+        ~TcpTransport() override;
+
+        bool open() override;
+
+        bool exchange( const void *send, const size_t sendBytes, void *receive, const size_t receiveBytes ) override;
+
+    private:
+        const std::string host;
+        const std::string listenHost;
+        const uint16_t    basePort;
+
+        int listenFd;
+        int sendFd;    // to the next rank
+        int receiveFd; // from the previous rank
+    };
+
+    // forks size - 1 children to run rankMain as ranks 1 and up, the caller runs rank 0. children exit with what
+    // rankMain returned, true when every rank returned 0. fork before starting threads, children only get this one
+    bool runRanks( const size_t size, const std::function<int( const size_t rank )> &rankMain );
+}
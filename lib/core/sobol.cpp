@@ -0,0 +1,107 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <cassert>
+#include "core/core.h"
+#include "core/randomstream.h"
+#include "core/sobol.h"
+
+namespace Core {
+
+    namespace {
+        // degree s and coefficients a of each dimensions primitive polynomial and its initial direction numbers m,
+        // from Joe and Kuo's new-joe-kuo-6.21201 table. The first dimension is the van der Corput sequence.
+        struct PrimitivePolynomial {
+            uint32_t degree;
+            uint32_t coefficients;
+            uint32_t initial[7];
+        };
+
+        const PrimitivePolynomial sPolynomials[ SobolSequence::maxDimensions - 1 ] = {
+                { 1, 0,  { 1 } },
+                { 2, 1,  { 1, 3 } },
+                { 3, 1,  { 1, 3, 1 } },
+                { 3, 2,  { 1, 1, 1 } },
+                { 4, 1,  { 1, 1, 3, 3 } },
+                { 4, 4,  { 1, 3, 5, 13 } },
+                { 5, 2,  { 1, 1, 5, 5, 17 } },
+                { 5, 4,  { 1, 1, 5, 5, 5 } },
+                { 5, 7,  { 1, 1, 7, 11, 19 } },
+                { 5, 11, { 1, 1, 5, 1, 1 } },
+                { 5, 13, { 1, 1, 1, 3, 11 } },
+                { 5, 14, { 1, 3, 5, 5, 31 } },
+                { 6, 1,  { 1, 3, 3, 9, 7, 49 } },
+                { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+                { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+                { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+                { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+                { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+                { 7, 1,  { 1, 3, 7, 11, 23, 15, 103 } },
+                { 7, 4,  { 1, 3, 7, 13, 13, 15, 69 } },
+        };
+
+        // top 24 bits to a float in [0, 1), as RandomStream does
+        inline real toUnit( const uint32_t x ) {
+            return real( x >> 8 ) * real( 1.0 / 16777216.0 );
+        }
+    }
+
+    SobolSequence::SobolSequence( const size_t _dimensions, const uint64_t seed ) :
+            dimensions( _dimensions ),
+            index( 0 ),
+            directions( _dimensions * bits ),
+            shift( _dimensions, 0 ),
+            state( _dimensions, 0 ) {
+        assert( dimensions > 0 && dimensions <= maxDimensions );
+
+        for( size_t j = 0; j < bits; ++j ) { directions[ j ] = uint32_t( 1 ) << (bits - 1 - j); }
+        for( size_t d = 1; d < dimensions; ++d ) {
+            const auto &p = sPolynomials[ d - 1 ];
+            uint32_t   *v = directions.data( ) + (d * bits);
+            for( size_t j = 0; j < p.degree; ++j ) { v[ j ] = p.initial[ j ] << (bits - 1 - j); }
+            for( size_t j = p.degree; j < bits; ++j ) {
+                v[ j ] = v[ j - p.degree ] ^ (v[ j - p.degree ] >> p.degree);
+                for( size_t k = 1; k < p.degree; ++k ) {
+                    if( (p.coefficients >> (p.degree - 1 - k)) & 1 ) {
+                        v[ j ] ^= v[ j - k ];
+                    }
+                }
+            }
+        }
+
+        if( seed != 0 ) {
+            RandomStream stream( seed, 0 );
+            for( auto &&s : shift ) { s = stream.next( ); }
+        }
+    }
+
+    void SobolSequence::next( real *point ) {
+        for( size_t d = 0; d < dimensions; ++d ) { point[ d ] = toUnit( state[ d ] ^ shift[ d ] ); }
+
+        // the next Gray code differs in the lowest zero bit of the index
+        uint64_t c = 0;
+        for( uint64_t i = index; i & 1; i >>= 1 ) { ++c; }
+        assert( c < bits );
+        for( size_t d = 0; d < dimensions; ++d ) { state[ d ] ^= directions[ (d * bits) + c ]; }
+        ++index;
+    }
+
+    void SobolSequence::fill( const size_t count, real *points ) {
+        for( size_t i = 0; i < count; ++i ) { next( points + (i * dimensions) ); }
+    }
+
+    void SobolSequence::seek( const uint64_t _index ) {
+        assert( _index < (uint64_t( 1 ) << bits) );
+        index = _index;
+
+        const uint64_t gray = index ^ (index >> 1);
+        for( size_t d = 0; d < dimensions; ++d ) {
+            uint32_t x = 0;
+            for( size_t j = 0; j < bits; ++j ) {
+                if( (gray >> j) & 1 ) { x ^= directions[ (d * bits) + j ]; }
+            }
+            state[ d ] = x;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "core/core.h"
+
+namespace Core {
+
+    /*
+     * Sobol low discrepancy sequence (Joe and Kuo direction numbers) in Gray code order, each point is the last one
+     * xor one direction number per dimension. Any 2^k aligned run of points puts exactly one point in each of the
+     * 2^k equal slices of every dimension, so a sample set covers the domain far more evenly than random points.
+     * The first point is the origin. A non zero seed applies a random digital shift per dimension, which keeps the
+     * stratification but decorrelates sequences built with different seeds.
+     */
+    class SobolSequence {
+    public:
+        static constexpr size_t maxDimensions = 21;
+
+        explicit SobolSequence( const size_t dimensions, const uint64_t seed = 0 );
+
+        size_t getDimensions() const { return dimensions; }
+
+        // index of the next point
+        uint64_t getIndex() const { return index; }
+
+        // the next point, dimensions values in [0, 1)
+        void next( real *point );
+
+        // count points one after another
+        void fill( const size_t count, real *points );
+
+        // jump to any point of the sequence without generating the ones before it
+        void seek( const uint64_t _index );
+
+    private:
+        static constexpr size_t bits = 32;
+
+        size_t                dimensions;
+        uint64_t              index;
+        std::vector<uint32_t> directions; // bits per dimension
+        std::vector<uint32_t> shift;
+        std::vector<uint32_t> state;      // the unshifted current point
+    };
+}
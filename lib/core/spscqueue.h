@@ -0,0 +1,94 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include "core/core.h"
+
+namespace Core {
+
+    /*
+     * Bounded single producer single consumer queue over a ring of preallocated elements. The producer fills an
+     * element in place between beginPush and endPush and the consumer reads it in place between beginPop and
+     * endPop, so big payloads (a micro batch of activations) move without copies or allocation. One atomic index
+     * each way, on their own cache lines. The blocking calls spin a little then yield, they're for threads that
+     * have nothing better to do until the other side moves.
+     */
+    template<typename T>
+    class SpscQueue {
+    public:
+        explicit SpscQueue( const size_t capacity ) :
+                elements( capacity ),
+                head( 0 ),
+                tail( 0 ) {
+            assert( capacity > 0 );
+        }
+
+        SpscQueue( const SpscQueue & ) = delete;
+
+        SpscQueue &operator=( const SpscQueue & ) = delete;
+
+        size_t getCapacity() const { return elements.size( ); }
+
+        // every element before use, e.g. to size their buffers. not while either side is running
+        template<typename F>
+        void forEachElement( F &&f ) {
+            for( auto &&element : elements ) { f( element ); }
+        }
+
+        // producer side. nullptr if full
+        T *tryBeginPush() {
+            const size_t t = tail.load( std::memory_order_relaxed );
+            if( t - head.load( std::memory_order_acquire ) == elements.size( ) ) {
+                return nullptr;
+            }
+            return &elements[ t % elements.size( ) ];
+        }
+
+        T *beginPush() {
+            return waitFor( [ this ]() { return tryBeginPush( ); } );
+        }
+
+        void endPush() {
+            tail.store( tail.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+        }
+
+        // consumer side. nullptr if empty
+        T *tryBeginPop() {
+            const size_t h = head.load( std::memory_order_relaxed );
+            if( tail.load( std::memory_order_acquire ) == h ) {
+                return nullptr;
+            }
+            return &elements[ h % elements.size( ) ];
+        }
+
+        T *beginPop() {
+            return waitFor( [ this ]() { return tryBeginPop( ); } );
+        }
+
+        void endPop() {
+            head.store( head.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+        }
+
+    private:
+        static constexpr size_t spinsBeforeYield = 64;
+
+        template<typename F>
+        static T *waitFor( F &&attempt ) {
+            for( size_t spins = 0;; ++spins ) {
+                if( T *element = attempt( ) ) { return element; }
+                if( spins >= spinsBeforeYield ) { std::this_thread::yield( ); }
+            }
+        }
+
+        std::vector<T> elements;
+
+        alignas( 64 ) std::atomic<size_t> head; // next to pop, only the consumer writes it
+        alignas( 64 ) std::atomic<size_t> tail; // next to push, only the producer writes it
+    };
+}
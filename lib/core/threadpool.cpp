@@ -0,0 +1,126 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include "core/core.h"
+#include "core/threadpool.h"
+#include "core/trace.h"
+
+namespace Core {
+
+    namespace {
+        // which pool and worker the current thread is, so nested submits stay local
+        thread_local const ThreadPool *tCurrentPool = nullptr;
+        thread_local size_t            tWorkerIndex = 0;
+    }
+
+    ThreadPool::ThreadPool( const size_t threadCount ) :
+            queued( 0 ),
+            pending( 0 ),
+            stopping( false ),
+            nextWorker( 0 ),
+            steals( 0 ) {
+        size_t count = threadCount;
+        if( count == 0 ) {
+            count = std::max( 1u, std::thread::hardware_concurrency( ) );
+        }
+
+        for( size_t i = 0; i < count; ++i ) {
+            workers.push_back( std::unique_ptr<Worker>( new Worker( ) ) );
+        }
+        for( size_t i = 0; i < count; ++i ) {
+            threads.emplace_back( [ this, i ]() { workerLoop( i ); } );
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        wait( );
+        {
+            std::lock_guard<std::mutex> lock( sleepMutex );
+            stopping = true;
+        }
+        wake.notify_all( );
+        for( auto &&thread : threads ) {
+            thread.join( );
+        }
+    }
+
+    void ThreadPool::submit( Task task ) {
+        pending.fetch_add( 1 );
+
+        const size_t index = (tCurrentPool == this) ? tWorkerIndex : (nextWorker.fetch_add( 1 ) % workers.size( ));
+        {
+            std::lock_guard<std::mutex> lock( workers[ index ]->mutex );
+            workers[ index ]->tasks.push_back( std::move( task ) );
+        }
+        {
+            std::lock_guard<std::mutex> lock( sleepMutex );
+            queued++;
+        }
+        wake.notify_one( );
+    }
+
+    void ThreadPool::wait() {
+        assert( tCurrentPool != this );
+        std::unique_lock<std::mutex> lock( sleepMutex );
+        idle.wait( lock, [ this ]() { return pending.load( ) == 0; } );
+    }
+
+    bool ThreadPool::popLocal( const size_t index, Task &task ) {
+        auto                        &worker = *workers[ index ];
+        std::lock_guard<std::mutex> lock( worker.mutex );
+        if( worker.tasks.empty( ) ) {
+            return false;
+        }
+        task = std::move( worker.tasks.back( ) );
+        worker.tasks.pop_back( );
+        return true;
+    }
+
+    bool ThreadPool::steal( const size_t thief, Task &task ) {
+        for( size_t i = 1; i < workers.size( ); ++i ) {
+            auto                        &victim = *workers[ (thief + i) % workers.size( ) ];
+            std::lock_guard<std::mutex> lock( victim.mutex );
+            if( !victim.tasks.empty( ) ) {
+                task = std::move( victim.tasks.front( ) );
+                victim.tasks.pop_front( );
+                steals.fetch_add( 1, std::memory_order_relaxed );
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop( const size_t index ) {
+        tCurrentPool = this;
+        tWorkerIndex = index;
+        CORE_TRACE_THREAD_NAME( "ThreadPool worker" );
+
+        for( ;; ) {
+            Task task;
+            if( popLocal( index, task ) || steal( index, task ) ) {
+                {
+                    std::lock_guard<std::mutex> lock( sleepMutex );
+                    queued--;
+                }
+                task( );
+
+                if( pending.fetch_sub( 1 ) == 1 ) {
+                    std::lock_guard<std::mutex> lock( sleepMutex );
+                    idle.notify_all( );
+                }
+                continue;
+            }
+
+            // queued is only raised under the lock after the push, so a task arriving after the failed search above
+            // either shows up here or its notify comes after we're waiting
+            std::unique_lock<std::mutex> lock( sleepMutex );
+            wake.wait( lock, [ this ]() { return stopping || queued > 0; } );
+            if( stopping && queued == 0 ) {
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/core.h"
+
+namespace Core {
+
+    /*
+     * Work stealing thread pool. Each worker owns a deque, it pushes and pops its own tasks at the back (newest
+     * first, cache warm) and when empty steals the oldest task from the front of another workers deque. Outside
+     * submits are spread round robin, tasks submitted from a worker go to its own deque. Suited to uneven jobs like
+     * training runs of different sizes, nothing idles while anything is queued.
+     */
+    class ThreadPool {
+    public:
+        using Task = std::function<void()>;
+
+        // 0 threads means one per hardware thread
+        explicit ThreadPool( const size_t threadCount = 0 );
+
+        // finishes everything queued first
+        ~ThreadPool();
+
+        ThreadPool( const ThreadPool & ) = delete;
+
+        ThreadPool &operator=( const ThreadPool & ) = delete;
+
+        void submit( Task task );
+
+        // blocks until every submitted task, including ones tasks submitted, has finished. not from a worker
+        void wait();
+
+        size_t getThreadCount() const { return threads.size( ); }
+
+        uint64_t getStealCount() const { return steals.load( std::memory_order_relaxed ); }
+
+    private:
+        struct alignas( 64 ) Worker {
+            std::mutex       mutex;
+            std::deque<Task> tasks;
+        };
+
+        bool popLocal( const size_t index, Task &task );
+
+        bool steal( const size_t thief, Task &task );
+
+        void workerLoop( const size_t index );
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread>             threads;
+
+        std::mutex              sleepMutex;
+        std::condition_variable wake;     // tasks are queued or we're stopping
+        std::condition_variable idle;     // pending reached 0
+        size_t                  queued;   // under sleepMutex, tasks sitting in any deque
+        std::atomic<size_t>     pending;  // queued + running
+        bool                    stopping; // under sleepMutex
+
+        std::atomic<size_t>   nextWorker;
+        std::atomic<uint64_t> steals;
+    };
+}
@@ -0,0 +1,194 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "core/core.h"
+#include "core/trace.h"
+
+namespace Core {
+
+    namespace {
+        // the mutex is only ever contended by clear, counting and dumping
+        struct ThreadBuffer {
+            std::mutex                mutex;
+            uint32_t                  tid;
+            std::string               name;
+            std::vector<Trace::Event> events;   // a ring once it reaches eventsPerThread
+            size_t                    recorded; // since the last clear, the next write is at recorded % capacity
+
+            void push( const Trace::Event &ev ) {
+                if( events.size( ) < Trace::eventsPerThread ) {
+                    events.push_back( ev );
+                } else {
+                    events[ recorded % Trace::eventsPerThread ] = ev;
+                }
+                ++recorded;
+            }
+
+            // oldest first
+            std::vector<Trace::Event> snapshot() const {
+                std::vector<Trace::Event> ordered;
+                ordered.reserve( events.size( ) );
+                const size_t start = (recorded > events.size( )) ? recorded % events.size( ) : 0;
+                ordered.insert( ordered.end( ), events.begin( ) + start, events.end( ) );
+                ordered.insert( ordered.end( ), events.begin( ), events.begin( ) + start );
+                return ordered;
+            }
+        };
+
+        struct Registry {
+            std::mutex                                 mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        };
+
+        // leaked on purpose so threads that outlive static destruction can still record safely
+        Registry &registry() {
+            static Registry *reg = new Registry( );
+            return *reg;
+        }
+
+        const std::chrono::steady_clock::time_point &epoch() {
+            static const auto start = std::chrono::steady_clock::now( );
+            return start;
+        }
+
+        // the registry lock is only taken the first time a thread records, after that its buffer is thread local
+        ThreadBuffer &threadBuffer() {
+            thread_local ThreadBuffer *buffer = nullptr;
+            if( buffer == nullptr ) {
+                auto        sptr = std::make_shared<ThreadBuffer>( );
+                auto        &reg = registry( );
+                std::lock_guard<std::mutex> lock( reg.mutex );
+                sptr->tid      = static_cast<uint32_t>(reg.buffers.size( ) + 1);
+                sptr->recorded = 0;
+                sptr->events.reserve( 4096 );
+                reg.buffers.push_back( sptr );
+                buffer = sptr.get( );
+            }
+            return *buffer;
+        }
+
+        void writeEscaped( std::ostream &out, const char *str ) {
+            for( ; *str != 0; ++str ) {
+                switch( *str ) {
+                    case '"': out << "\\\"";
+                        break;
+                    case '\\': out << "\\\\";
+                        break;
+                    case '\n': out << "\\n";
+                        break;
+                    default: out << *str;
+                        break;
+                }
+            }
+        }
+    }
+
+    uint64_t Trace::now() {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<nanoseconds>( steady_clock::now( ) - epoch( ) ).count( ));
+    }
+
+    void Trace::record( const char *name, const uint64_t beginNs, const uint64_t endNs, const int64_t arg ) {
+        auto                        &buffer = threadBuffer( );
+        std::lock_guard<std::mutex> lock( buffer.mutex );
+        buffer.push( Event{ name, beginNs, endNs - beginNs, arg } );
+    }
+
+    void Trace::setThreadName( const std::string &name ) {
+        auto                        &buffer = threadBuffer( );
+        std::lock_guard<std::mutex> lock( buffer.mutex );
+        buffer.name = name;
+    }
+
+    void Trace::clear() {
+        auto                        &reg = registry( );
+        std::lock_guard<std::mutex> lock( reg.mutex );
+        for( auto &&buffer : reg.buffers ) {
+            std::lock_guard<std::mutex> bufferLock( buffer->mutex );
+            buffer->events.clear( );
+            buffer->recorded = 0;
+        }
+    }
+
+    size_t Trace::eventCount() {
+        auto                        &reg = registry( );
+        std::lock_guard<std::mutex> lock( reg.mutex );
+        size_t                      count = 0;
+        for( auto &&buffer : reg.buffers ) {
+            std::lock_guard<std::mutex> bufferLock( buffer->mutex );
+            count += buffer->events.size( );
+        }
+        return count;
+    }
+
+    size_t Trace::droppedCount() {
+        auto                        &reg = registry( );
+        std::lock_guard<std::mutex> lock( reg.mutex );
+        size_t                      count = 0;
+        for( auto &&buffer : reg.buffers ) {
+            std::lock_guard<std::mutex> bufferLock( buffer->mutex );
+            count += buffer->recorded - buffer->events.size( );
+        }
+        return count;
+    }
+
+    void Trace::dumpChromeJson( std::ostream &out ) {
+        auto                        &reg = registry( );
+        std::lock_guard<std::mutex> lock( reg.mutex );
+
+        // timestamps are in microseconds, fractional parts keep the ns resolution
+        const auto oldPrecision = out.precision( 3 );
+        const auto oldFlags     = out.setf( std::ios::fixed, std::ios::floatfield );
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for( auto &&buffer : reg.buffers ) {
+            // copied out so the owning thread isn't held up while this one formats
+            std::string               name;
+            std::vector<Trace::Event> events;
+            {
+                std::lock_guard<std::mutex> bufferLock( buffer->mutex );
+                name   = buffer->name;
+                events = buffer->snapshot( );
+            }
+            if( !name.empty( ) ) {
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                    << buffer->tid << ",\"args\":{\"name\":\"";
+                writeEscaped( out, name.c_str( ) );
+                out << "\"}}";
+                first = false;
+            }
+            for( auto &&ev : events ) {
+                out << (first ? "" : ",") << "\n{\"name\":\"";
+                writeEscaped( out, ev.name );
+                out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                    << ",\"ts\":" << (double( ev.beginNs ) * 1e-3)
+                    << ",\"dur\":" << (double( ev.durationNs ) * 1e-3);
+                if( ev.arg != noArg ) {
+                    out << ",\"args\":{\"value\":" << ev.arg << "}";
+                }
+                out << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+
+        out.precision( oldPrecision );
+        out.flags( oldFlags );
+    }
+
+    bool Trace::dumpChromeJson( const std::string &filename ) {
+        std::ofstream out( filename );
+        if( !out ) {
+            return false;
+        }
+        dumpChromeJson( out );
+        return static_cast<bool>(out);
+    }
+}
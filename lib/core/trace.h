@@ -0,0 +1,91 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "core/core.h"
+
+namespace Core {
+
+    /*
+     * Timeline recorder, each thread appends complete (begin + duration) events into its own ring buffer under its
+     * own lock, which only a clear or dump ever contends, so recording stays cheap and dumping is safe while the
+     * workers run. A ring keeps the newest eventsPerThread events of each thread, older ones are overwritten.
+     * The buffers are dumped as Chrome Trace Event JSON which loads directly in ui.perfetto.dev or chrome://tracing.
+     * Use the CORE_TRACE_* macros rather than this directly, they vanish when tracing is off.
+     */
+    class Trace {
+    public:
+        struct Event {
+            const char *name;     // must be a string literal (or otherwise outlive the trace)
+            uint64_t   beginNs;
+            uint64_t   durationNs;
+            int64_t    arg;       // optional user value (layer index, batch size etc.), noArg if unused
+        };
+
+        static constexpr int64_t noArg = INT64_MIN;
+
+        static constexpr size_t eventsPerThread = size_t( 1 ) << 16;
+
+        // nanoseconds since the trace epoch (first use in the process)
+        static uint64_t now();
+
+        static void record( const char *name, const uint64_t beginNs, const uint64_t endNs,
+                            const int64_t arg = noArg );
+
+        // label the calling thread in the timeline
+        static void setThreadName( const std::string &name );
+
+        // drop all recorded events, threads keep their buffers and names
+        static void clear();
+
+        // events held, at most eventsPerThread per thread
+        static size_t eventCount();
+
+        // events overwritten by newer ones since the last clear
+        static size_t droppedCount();
+
+        // a snapshot of each buffer in turn, threads still recording just carry on
+        static void dumpChromeJson( std::ostream &out );
+
+        static bool dumpChromeJson( const std::string &filename );
+    };
+
+    class TraceScope {
+    public:
+        TraceScope( const char *_name, const int64_t _arg = Trace::noArg ) :
+                name( _name ),
+                arg( _arg ),
+                beginNs( Trace::now( ) ) {
+        }
+
+        ~TraceScope() { Trace::record( name, beginNs, Trace::now( ), arg ); }
+
+        TraceScope( const TraceScope & ) = delete;
+
+        TraceScope &operator=( const TraceScope & ) = delete;
+
+    private:
+        const char     *name;
+        const int64_t  arg;
+        const uint64_t beginNs;
+    };
+}
+
+#define CORE_TRACE_CONCAT_IMPL( a, b ) a##b
+#define CORE_TRACE_CONCAT( a, b ) CORE_TRACE_CONCAT_IMPL( a, b )
+
+#if defined( CORE_TRACE_ENABLED )
+#define CORE_TRACE_SCOPE( name ) Core::TraceScope CORE_TRACE_CONCAT( coreTraceScope, __LINE__ )( name )
+#define CORE_TRACE_SCOPE_ARG( name, arg ) \
+    Core::TraceScope CORE_TRACE_CONCAT( coreTraceScope, __LINE__ )( name, static_cast<int64_t>( arg ) )
+#define CORE_TRACE_THREAD_NAME( name ) Core::Trace::setThreadName( name )
+#else
+#define CORE_TRACE_SCOPE( name ) do { } while( false )
+#define CORE_TRACE_SCOPE_ARG( name, arg ) do { } while( false )
+#define CORE_TRACE_THREAD_NAME( name ) do { } while( false )
+#endif
@@ -7,15 +7,10 @@
 #include "core/basiccppvectoralu.h"
 
 namespace Core {
-    std::weak_ptr<VectorALU> weakSingletonVectorALU;
-
+    // inference sessions on many threads all ask for the ALU, a function local static is initialised once thread
+    // safely and after that each call is just a shared_ptr copy
     std::shared_ptr<VectorALU> VectorALUFactory() {
-        if (auto sptr = weakSingletonVectorALU.lock()) {
-            return sptr;
-        } else {
-            sptr = std::make_shared<BasicCPPVectorALU>();
-            weakSingletonVectorALU = static_cast<std::weak_ptr<VectorALU>>(sptr);
-            return sptr;
-        }
+        static const std::shared_ptr<VectorALU> singletonVectorALU = std::make_shared<BasicCPPVectorALU>();
+        return singletonVectorALU;
     }
 }
\ No newline at end of file
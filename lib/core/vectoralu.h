@@ -10,6 +10,16 @@ namespace Core {
         BASIC_CPP
     };
 
+    // the activations the fused dense kernels can apply while the sums are still in registers
+    // Step uses param0 as its threshold, ReLU param0 as its threshold and param1 as the value below it
+    enum class ActivationKernel : uint8_t {
+        Identity,
+        Step,
+        Sigmoid,
+        HyperbolicTangent,
+        ReLU
+    };
+
     struct VectorALU {
         // these are never used, consider this the 'interface' which each ALU backend should support at a minimum
 
@@ -116,6 +126,128 @@ namespace Core {
         virtual void gather( const size_t numItems, const real *a, const size_t stride, real_array_ptr o ) const = 0;
 
         virtual void scatter( const size_t numItems, const_real_array_ptr a, const size_t stride, real *o ) const = 0;
+
+        // row major matrix multiply o = alpha * op( a ) * op( b ) + beta * o, op( x ) is x transposed when its flag is set
+        // op( a ) is m x k, op( b ) is k x n and o is m x n. lda, ldb and ldo are the row strides of the stored arrays
+        virtual void gemm( const bool transA, const bool transB, const size_t m, const size_t n, const size_t k,
+                           const real alpha, const_real_array_ptr a, const size_t lda, const_real_array_ptr b,
+                           const size_t ldb, const real beta, real_array_ptr o, const size_t ldo ) const = 0;
+
+        // o = alpha * op( a ) * x + beta * o, op( a ) is m x n
+        virtual void gemv( const bool transA, const size_t m, const size_t n, const real alpha, const_real_array_ptr a,
+                           const size_t lda, const_real_array_ptr x, const real beta, real_array_ptr o ) const = 0;
+
+        // panel packed matrices. a rows x cols matrix is stored as column panels of panelWidth columns (the last may
+        // be narrower), each panel is rows x width contiguous, so kernels walking either direction read it linearly
+        virtual size_t preferredPanelWidth() const = 0;
+
+        // element ( r, c ) is src[ r * ld + c ], or src[ c * ld + r ] when transposed
+        virtual void packPanels( const size_t rows, const size_t cols, const_real_array_ptr src, const size_t ld,
+                                 const bool transposed, const size_t panelWidth, real_array_ptr o ) const = 0;
+
+        virtual void unpackPanels( const size_t rows, const size_t cols, const_real_array_ptr packed,
+                                   const size_t panelWidth, real_array_ptr o, const size_t ldo ) const = 0;
+
+        // o is the packed transpose of the first oCols rows of the packed rows x cols matrix
+        virtual void transposePanels( const size_t rows, const size_t cols, const_real_array_ptr packed,
+                                      const size_t panelWidth, const size_t oCols, real_array_ptr o ) const = 0;
+
+        // o = a * b + beta * o. a is m x k (row stride lda), b is k x n panel packed
+        virtual void packedGemm( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                 const size_t lda, const_real_array_ptr b, const size_t panelWidth, const real beta,
+                                 real_array_ptr o, const size_t ldo ) const = 0;
+
+        // o = a * b^T + beta * o. a is m x k, b is panel packed with k columns of which the first n rows are used
+        virtual void packedGemmTransposed( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                           const size_t lda, const_real_array_ptr b, const size_t bRows,
+                                           const size_t panelWidth, const real beta, real_array_ptr o,
+                                           const size_t ldo ) const = 0;
+
+        // o += a^T * b. a is m x k, b is m x n and o is the k x n panel packed accumulator
+        virtual void packedOuterAccumulate( const size_t m, const size_t k, const size_t n, const_real_array_ptr a,
+                                            const size_t lda, const_real_array_ptr b, const size_t ldb,
+                                            const size_t panelWidth, real_array_ptr o ) const = 0;
+
+        // fused dense layer, o = act( a * b ). b is k x n panel packed with the bias weights as its last row, only the
+        // first k - 1 columns of a are read (the bias input is an implied 1). sums, if not null, gets the pre
+        // activation values for training, inference skips that store entirely
+        virtual void packedDenseActivate( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                          const size_t lda, const_real_array_ptr b, const size_t panelWidth,
+                                          const ActivationKernel act, const real param0, const real param1,
+                                          real_array_ptr sums, const size_t lds, real_array_ptr o,
+                                          const size_t ldo ) const = 0;
+
+        // o += a * b with b laid out as for packedDenseActivate (bias row last, implied bias input), no activation.
+        // for layers fed by several connections, whose pre activation values are the sum of every connections
+        virtual void packedDenseAccumulate( const size_t m, const size_t n, const size_t k, const_real_array_ptr a,
+                                            const size_t lda, const_real_array_ptr b, const size_t panelWidth,
+                                            real_array_ptr o, const size_t ldo ) const = 0;
+
+        // fused optimiser updates, each is a single pass over weights, gradients and state.
+        // gradients (dE/dw) are multiplied by gradScale on read and zeroed once consumed, ready to accumulate again
+        virtual void momentumStep( const size_t numItems, const real learningRate, const real momentum,
+                                   const bool nesterov, const real gradScale, real_array_ptr weights,
+                                   real_array_ptr gradients, real_array_ptr velocity ) const = 0;
+
+        virtual void rmsPropStep( const size_t numItems, const real learningRate, const real decay,
+                                  const real epsilon, const real gradScale, real_array_ptr weights,
+                                  real_array_ptr gradients, real_array_ptr meanSquare ) const = 0;
+
+        // learningRate should already include the bias corrections for this timestep
+        virtual void adamStep( const size_t numItems, const real learningRate, const real beta1, const real beta2,
+                               const real epsilon, const real gradScale, real_array_ptr weights,
+                               real_array_ptr gradients, real_array_ptr firstMoment,
+                               real_array_ptr secondMoment ) const = 0;
+
+        // lane interleaved (structure of arrays) kernels for evaluating many same shaped networks in lock step.
+        // element e of lane l is stored at [ e * lanes + l ], so every inner loop is a full width vector op across
+        // the networks. weights are in the public ordering, k x n source major with the bias row last
+
+        // o = act( a * b ) per lane, a is k - 1 source neurons (the bias input is an implied 1), sums optional
+        virtual void laneDenseActivate( const size_t lanes, const size_t n, const size_t k, const_real_array_ptr a,
+                                        const_real_array_ptr b, const ActivationKernel act, const real param0,
+                                        const real param1, real_array_ptr sums, real_array_ptr o ) const = 0;
+
+        // per lane o += a^T * delta, with delta itself added to the bias row
+        virtual void laneOuterAccumulate( const size_t lanes, const size_t k, const size_t n, const_real_array_ptr a,
+                                          const_real_array_ptr delta, real_array_ptr o ) const = 0;
+
+        // per lane o = b * delta over the k - 1 source rows, the deltas flowing back to the source neurons
+        virtual void laneTransposedProduct( const size_t lanes, const size_t k, const size_t n, const_real_array_ptr b,
+                                            const_real_array_ptr delta, real_array_ptr o ) const = 0;
+
+        // per lane momentum update, learningRate and momentum hold one value per lane
+        virtual void laneMomentumStep( const size_t lanes, const size_t numItems, const_real_array_ptr learningRate,
+                                       const_real_array_ptr momentum, const real gradScale, real_array_ptr weights,
+                                       real_array_ptr gradients, real_array_ptr velocity ) const = 0;
+
+        // o = act( a ) elementwise, exactly as the fused kernels apply it. a may be o
+        virtual void activate( const size_t numItems, const ActivationKernel act, const real param0,
+                               const real param1, const_real_array_ptr a, real_array_ptr o ) const = 0;
+
+        // o *= act'( sums ), for back propagating through an activation kernel
+        virtual void mulActivationDerivative( const size_t numItems, const ActivationKernel act, const real param0,
+                                              const_real_array_ptr sums, real_array_ptr o ) const = 0;
+
+        // o = sum c_k T_k( a ) by Clenshaw's recurrence, a is already mapped to [-1, 1]
+        virtual void chebyshevSeries( const size_t numItems, const_real_array_ptr coefficients,
+                                      const size_t coefficientCount, const_real_array_ptr a,
+                                      real_array_ptr o ) const = 0;
+
+        // adjoint accumulation for reverse mode differentiation, o += scale * a
+        virtual void accumulate( const size_t numItems, const_real_array_ptr a, const real scale,
+                                 real_array_ptr o ) const = 0;
+
+        // o += a * b
+        virtual void accumulateProduct( const size_t numItems, const_real_array_ptr a, const_real_array_ptr b,
+                                        real_array_ptr o ) const = 0;
+
+        // sum a * b, honours the reduction mode like horizSum
+        virtual real dot( const size_t numItems, const_real_array_ptr a, const_real_array_ptr b ) const = 0;
+
+        // sum ( a - b )^2, likewise
+        virtual real sumSquaredDifference( const size_t numItems, const_real_array_ptr a,
+                                           const_real_array_ptr b ) const = 0;
     };
 
     std::shared_ptr<VectorALU> VectorALUFactory();
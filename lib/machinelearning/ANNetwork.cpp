@@ -2,12 +2,15 @@
 // Created by Dean Calver on 12/04/2016.
 //
 
+#include <algorithm>
 #include <cassert>
+#include <iostream>
 #include "core/core.h"
 #include "ANNetwork.h"
-#include "boost/random.hpp"
-#include "boost/generator_iterator.hpp"
+#include "machinelearning/datasetevaluator.h"
 #include "core/random.h"
+#include "core/threadpool.h"
+#include "core/trace.h"
 
 namespace MachineLearning {
 
@@ -35,15 +38,22 @@ namespace MachineLearning {
     ANNetwork::ANNetwork() :
             totalNeuronCount( 0 ),
             totalWeightCount( 0 ),
-            scratchPad0( nullptr ),
-            scratchPad1( nullptr ),
-            scratchPad2( nullptr ),
+            inputCount( 0 ),
+            outputNeuronIndex( 0 ),
+            outputCount( 0 ),
+            activationMemoryBudget( 0 ),
+            activationStride( 0 ),
             sums( nullptr ),
             outputs( nullptr ),
             weights( nullptr ),
-            deltaWeights( nullptr ),
+            panelWidth( 1 ),
+            maxBatchSize( 1 ),
             nodeDeltas( nullptr ),
             gradients( nullptr ),
+            gradientSampleCount( 0 ),
+            backpropWeights( nullptr ),
+            transposedBackpropWeights( true ),
+            frozen( false ),
             etalearningRate( 0.7 ),
             alphaMomentum( 0.3 ) {
     }
@@ -51,13 +61,10 @@ namespace MachineLearning {
     ANNetwork::~ANNetwork() {
         auto alu = Core::VectorALUFactory( );
 
-        if( scratchPad0 != nullptr ) { alu->deleteRealVector( scratchPad0 ); }
-        if( scratchPad1 != nullptr ) { alu->deleteRealVector( scratchPad1 ); }
-        if( scratchPad1 != nullptr ) { alu->deleteRealVector( scratchPad2 ); }
         if( sums != nullptr ) { alu->deleteRealVector( sums ); }
         if( outputs != nullptr ) { alu->deleteRealVector( outputs ); }
         if( weights != nullptr ) { alu->deleteRealVector( weights ); }
-        if( deltaWeights != nullptr ) { alu->deleteRealVector( deltaWeights ); }
+        if( backpropWeights != nullptr ) { alu->deleteRealVector( backpropWeights ); }
         if( nodeDeltas != nullptr ) { alu->deleteRealVector( nodeDeltas ); }
         if( gradients != nullptr ) { alu->deleteRealVector( gradients ); }
 
@@ -78,35 +85,129 @@ namespace MachineLearning {
     }
 
     void ANNetwork::setRandomWeights() {
+        auto stream = Core::Random::newStream( );
+        setRandomWeights( stream );
+    }
+
+    void ANNetwork::setRandomWeights( Core::RandomStream &stream ) {
         assert( weights != nullptr );
-        using namespace Core;
-        using namespace boost::random;
+
+        // generated in the public ordering so a seed gives the same network whatever the packing
+        std::vector<Core::real> in( totalWeightCount );
 
         // todo random weights range to be user specified
-        Random::uniform_real_gen_type                            kRandGen( Random::generator,
-                                                                           Random::ur_distribution_type( -10.0,
-                                                                                                         10.0 ) );
-        boost::generator_iterator<Random::uniform_real_gen_type> kIter( &kRandGen );
-        for( int                                                 i = 0; i < totalWeightCount; ++i ) {
-            *(weights + i) = *kIter++;
-        }
+        stream.fillUniform( totalWeightCount, Core::real( -10.0 ), Core::real( 10.0 ), in.data( ) );
+        setWeights( in );
     }
 
     void ANNetwork::setWeights( const std::vector<Core::real> &in ) {
         assert( weights != nullptr );
         assert( in.size( ) == totalWeightCount );
 
-        size_t    i = 0;
-        for( auto &&it : in ) {
-            weights[ i ] = it;
-            ++i;
+        auto alu = Core::VectorALUFactory( );
+
+        // public ordering is per connection, source neuron major with the bias row last
+        for( auto &&connect : connections ) {
+            alu->packPanels( connect->from->countOfNeurons( ), connect->to->getActualNeuronCount( ),
+                             in.data( ) + connect->weightIndex, connect->srcNeuronConnectionCount, false,
+                             panelWidth, weights + connect->weightIndex );
+        }
+        refreshBackpropWeights( );
+    }
+
+    std::vector<Core::real> ANNetwork::getWeights() const {
+        return unpackWeightOrdered( weights );
+    }
+
+    std::vector<Core::real> ANNetwork::getGradients() const {
+        assert( gradients != nullptr );
+        return unpackWeightOrdered( gradients );
+    }
+
+    std::vector<Core::real> ANNetwork::unpackWeightOrdered( Core::VectorALU::const_real_array_ptr packed ) const {
+        assert( packed != nullptr );
+        auto alu = Core::VectorALUFactory( );
+
+        std::vector<Core::real> out( totalWeightCount );
+        for( auto &&connect : connections ) {
+            alu->unpackPanels( connect->from->countOfNeurons( ), connect->to->getActualNeuronCount( ),
+                               packed + connect->weightIndex, panelWidth,
+                               out.data( ) + connect->weightIndex, connect->srcNeuronConnectionCount );
+        }
+        return out;
+    }
+
+    Model::shared_ptr ANNetwork::createModel() const {
+        assert( weights != nullptr );
+
+        auto model = std::shared_ptr<Model>( new Model( ) );
+        auto alu   = model->alu;
+
+        model->inputCount        = inputCount;
+        model->inputNeuronIndex  = layers.front( )->getNeuronIndex( );
+        model->outputCount       = outputCount;
+        model->outputNeuronIndex = outputNeuronIndex;
+        model->totalNeuronCount  = totalNeuronCount;
+        model->totalWeightCount  = totalWeightCount;
+        model->panelWidth        = panelWidth;
+
+        // in schedule order. a layer fed by several connections sums them in place then activates in place
+        for( auto &&level : levels ) {
+            for( auto &&layer : level ) {
+                const auto &dst   = layers[ layer ];
+                const auto &af    = dst->getActivationFunc( );
+                const bool single = inbound[ layer ].size( ) == 1;
+                for( size_t i = 0; i < inbound[ layer ].size( ); ++i ) {
+                    const auto &connect = connections[ inbound[ layer ][ i ] ];
+                    Model::Step step{ connect->from->getNeuronIndex( ),
+                                      connect->from->countOfNeurons( ),
+                                      dst->getNeuronIndex( ),
+                                      dst->getActualNeuronCount( ),
+                                      connect->weightIndex,
+                                      single ? af.getKernel( ) : Core::ActivationKernel::Identity,
+                                      single ? af.getKernelParam0( ) : Core::real( 0 ),
+                                      single ? af.getKernelParam1( ) : Core::real( 0 ) };
+                    step.kind = (i == 0) ? Model::StepKind::Dense : Model::StepKind::Accumulate;
+                    model->steps.push_back( step );
+                }
+                if( !single ) {
+                    Model::Step step{ dst->getNeuronIndex( ), dst->getActualNeuronCount( ),
+                                      dst->getNeuronIndex( ), dst->getActualNeuronCount( ), 0,
+                                      af.getKernel( ), af.getKernelParam0( ), af.getKernelParam1( ) };
+                    step.kind = Model::StepKind::Activate;
+                    model->steps.push_back( step );
+                }
+            }
+        }
+
+        model->weights = alu->newRealVector( totalWeightCount );
+        alu->copy( totalWeightCount, weights, model->weights );
+
+        return model;
+    }
+
+    void ANNetwork::refreshBackpropWeights() {
+        if( backpropWeights == nullptr ) {
+            return;
+        }
+        CORE_TRACE_SCOPE( "ANNetwork::refreshBackpropWeights" );
+
+        auto alu = Core::VectorALUFactory( );
+
+        // W^T without the bias row, so delta propagation runs through the same panel kernel as evaluate
+        for( auto &&connect : connections ) {
+            alu->transposePanels( connect->from->countOfNeurons( ), connect->to->getActualNeuronCount( ),
+                                  weights + connect->weightIndex, panelWidth,
+                                  connect->from->getActualNeuronCount( ),
+                                  backpropWeights + connect->weightIndex );
         }
     }
 
-    void ANNetwork::finalise( bool willTrain ) {
+    void ANNetwork::finalise( bool willTrain, size_t _maxBatchSize ) {
+        CORE_TRACE_SCOPE( "ANNetwork::finalise" );
 
         assert( layers.back( )->getLayerType( ) == LayerType::OutputLayer );
-        assert( connections.size( ) == (layers.size( ) - 1) );
+        assert( _maxBatchSize > 0 );
 
         auto alu = Core::VectorALUFactory( );
 
@@ -116,192 +217,520 @@ namespace MachineLearning {
             neuronIndex += layers[ i ]->countOfNeurons( );
         }
 
+        // the heads are the trailing run of output layers, unbiased so their neurons are contiguous
+        size_t firstHead = layers.size( );
+        while( firstHead > 1 && layers[ firstHead - 1 ]->getLayerType( ) == LayerType::OutputLayer ) { --firstHead; }
+        inputCount        = layers.front( )->getActualNeuronCount( );
+        outputNeuronIndex = layers[ firstHead ]->getNeuronIndex( );
+        outputCount       = neuronIndex - outputNeuronIndex;
+
+        inbound.assign( layers.size( ), { } );
+        outbound.assign( layers.size( ), { } );
+        sourceLayer.assign( connections.size( ), 0 );
+        targetLayer.assign( connections.size( ), 0 );
+        for( size_t c = 0; c < connections.size( ); ++c ) {
+            const auto from = size_t( std::find( layers.begin( ), layers.end( ), connections[ c ]->from ) -
+                                      layers.begin( ) );
+            const auto to   = size_t( std::find( layers.begin( ), layers.end( ), connections[ c ]->to ) -
+                                      layers.begin( ) );
+            assert( from < layers.size( ) && to < layers.size( ) && from != to );
+            assert( layers[ from ]->getLayerType( ) != LayerType::OutputLayer );
+            sourceLayer[ c ] = from;
+            targetLayer[ c ] = to;
+            outbound[ from ].push_back( c );
+            inbound[ to ].push_back( c );
+        }
+
+        // longest path from the input, so every layer comes after everything feeding it. a layer still unplaced
+        // after layers.size( ) passes is on a cycle
+        std::vector<size_t> depth( layers.size( ), 0 );
+        for( size_t pass = 0; pass < layers.size( ); ++pass ) {
+            for( size_t l = 1; l < layers.size( ); ++l ) {
+                assert( !inbound[ l ].empty( ) );
+                for( auto &&c : inbound[ l ] ) { depth[ l ] = std::max( depth[ l ], depth[ sourceLayer[ c ] ] + 1 ); }
+            }
+        }
+        levels.clear( );
+        for( size_t l = 1; l < layers.size( ); ++l ) {
+            assert( depth[ l ] < layers.size( ) );
+            assert( (l >= firstHead) || !outbound[ l ].empty( ) ); // a hidden layer nothing reads is a mistake
+            levels.resize( std::max( levels.size( ), depth[ l ] ) );
+            levels[ depth[ l ] - 1 ].push_back( l );
+        }
+
         size_t   weightIndex = 0;
         for( int j           = 0; j < connections.size( ); ++j ) {
+            // the layer level matrix kernels need every source neuron connected to every destination neuron and
+            // the fused kernels take the bias weights from the last source row
+            assert( connections[ j ]->srcNeuronConnectionCount == connections[ j ]->to->getActualNeuronCount( ) );
+            assert( connections[ j ]->from->isBiased( ) );
             connections[ j ]->weightIndex = weightIndex;
             weightIndex += connections[ j ]->weightCount;
         }
 
         totalNeuronCount = neuronIndex;
         totalWeightCount = weightIndex;
+        maxBatchSize     = _maxBatchSize;
+        panelWidth       = alu->preferredPanelWidth( );
+
+        activationStride = totalNeuronCount;
+        activationIndex.resize( layers.size( ) );
+        for( size_t l = 0; l < layers.size( ); ++l ) { activationIndex[ l ] = layers[ l ]->getNeuronIndex( ); }
+        checkpointed.assign( layers.size( ), true );
+        chainOrder.clear( );
+        if( willTrain && activationMemoryBudget > 0 ) {
+            chooseCheckpoints( );
+        }
 
-        // temp buffers reused in several places through an epoch, enough for all weights
-        scratchPad0 = alu->newRealVector( totalWeightCount );
-        scratchPad1 = alu->newRealVector( totalWeightCount );
-        scratchPad2 = alu->newRealVector( totalWeightCount );
-
-        alu->set( totalWeightCount, Core::real( 0 ), scratchPad0 );
-        alu->set( totalWeightCount, Core::real( 0 ), scratchPad1 );
-        alu->set( totalWeightCount, Core::real( 0 ), scratchPad2 );
-
-        sums    = alu->newRealVector( totalNeuronCount );
-        outputs = alu->newRealVector( totalNeuronCount );
-
+        // one row of activationStride per sample in a batch
+        outputs = alu->newRealVector( activationStride * maxBatchSize );
+        alu->set( activationStride * maxBatchSize, Core::real( 0 ), outputs );
 
-        alu->set( totalNeuronCount, Core::real( 0 ), sums );
-        alu->set( totalNeuronCount, Core::real( 0 ), outputs );
+        // bias neurons always output 1, activations never write past the actual neuron count
+        for( size_t b = 0; b < maxBatchSize; ++b ) {
+            for( size_t l = 0; l < layers.size( ); ++l ) {
+                if( layers[ l ]->isBiased( ) ) {
+                    outputs[ (b * activationStride) + activationIndex[ l ] + layers[ l ]->getActualNeuronCount( ) ] =
+                            Core::real( 1.0 );
+                }
+            }
+        }
 
         weights = alu->newRealVector( totalWeightCount );
         alu->set( totalWeightCount, Core::real( 0 ), weights );
 
         if( willTrain ) {
-            deltaWeights = alu->newRealVector( totalWeightCount );
-            gradients    = alu->newRealVector( totalWeightCount );
-            nodeDeltas   = alu->newRealVector( totalNeuronCount );
+            // pre activation sums are only needed for the derivatives
+            sums = alu->newRealVector( activationStride * maxBatchSize );
+            alu->set( activationStride * maxBatchSize, Core::real( 0 ), sums );
+
+            gradients  = alu->newRealVector( totalWeightCount );
+            nodeDeltas = alu->newRealVector( activationStride * maxBatchSize );
 
-            alu->set( totalWeightCount, Core::real( 0 ), deltaWeights );
             alu->set( totalWeightCount, Core::real( 0 ), gradients );
-            alu->set( totalNeuronCount, Core::real( 0 ), nodeDeltas );
+            alu->set( activationStride * maxBatchSize, Core::real( 0 ), nodeDeltas );
+            gradientSampleCount = 0;
+
+            if( transposedBackpropWeights ) {
+                // same offsets as weights, each connection only needs its non bias rows so this is big enough
+                backpropWeights = alu->newRealVector( totalWeightCount );
+                alu->set( totalWeightCount, Core::real( 0 ), backpropWeights );
+            }
+
+            if( !optimizer ) {
+                optimizer = std::make_shared<MomentumOptimizer>( alphaMomentum );
+            }
+            optimizer->allocate( totalWeightCount );
         }
     }
 
+    void ANNetwork::freezeForInference() {
+        CORE_TRACE_SCOPE( "ANNetwork::freezeForInference" );
+        assert( weights != nullptr );
+
+        auto alu = Core::VectorALUFactory( );
+
+        // evaluate only keeps pre activation sums while gradients exist, so freeing them switches it over
+        for( auto buffer : { &sums, &nodeDeltas, &gradients, &backpropWeights } ) {
+            if( *buffer != nullptr ) {
+                alu->deleteRealVector( *buffer );
+                *buffer = nullptr;
+            }
+        }
+        gradientSampleCount = 0;
+
+        if( optimizer ) {
+            optimizer->releaseState( );
+        }
+        frozen = true;
+    }
+
+    ANNetwork::MemoryUsage ANNetwork::getMemoryUsage() const {
+        const size_t weightBytes = totalWeightCount * sizeof( Core::real );
+        const size_t rowBytes    = activationStride * maxBatchSize * sizeof( Core::real );
+
+        MemoryUsage usage;
+        usage.weights         = (weights != nullptr) ? weightBytes : 0;
+        usage.activations     = (outputs != nullptr) ? rowBytes : 0;
+        usage.preActivations  = (sums != nullptr) ? rowBytes : 0;
+        usage.deltas          = (nodeDeltas != nullptr) ? rowBytes : 0;
+        usage.gradients       = (gradients != nullptr) ? weightBytes : 0;
+        usage.backpropWeights = (backpropWeights != nullptr) ? weightBytes : 0;
+        usage.optimizerState  = optimizer ? optimizer->getStateBytes( ) : 0;
+        return usage;
+    }
+
     void ANNetwork::evaluate( Core::VectorALU::const_real_array_ptr input, Core::VectorALU::real_array_ptr results ) {
+        evaluate( 1, input, results );
+    }
+
+    void ANNetwork::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                              Core::VectorALU::real_array_ptr results ) {
         using namespace Core;
+        CORE_TRACE_SCOPE_ARG( "ANNetwork::evaluate", batchSize );
+        assert( batchSize <= maxBatchSize );
 
-        auto     alu = Core::VectorALUFactory( );
+        auto alu = Core::VectorALUFactory( );
 
-        {
-            const auto &iLayer  = connections[ 0 ]->from;
-            auto       iOutputs = outputs + iLayer->getNeuronIndex( );
-            alu->copy( iLayer->getActualNeuronCount( ), input, iOutputs ); // neuronCount doesn't have bias in
-            iOutputs[ iLayer->getActualNeuronCount( ) ] = Core::real( 1.0 ); // bias neuron
+        for( size_t b = 0; b < batchSize; ++b ) {
+            alu->copy( inputCount,
+                       inputs + (b * inputCount),
+                       outputs + (b * activationStride) + activationIndex.front( ) );
         }
 
-        for( int i   = 0; i < connections.size( ); ++i ) {
-            const auto &srcLayer = connections[ i ]->from;
+        for( auto &&level : levels ) {
+            forEachInLevel( level, [ this, batchSize ]( const size_t layer ) { evaluateLayer( layer, batchSize ); } );
+        }
 
-            const auto srcNeuronCount = srcLayer->getActualNeuronCount( );
-            const auto srcOutputs     = outputs + srcLayer->getNeuronIndex( );
+        // the heads are always kept and stay contiguous, ending with the last layer
+        if( results != nullptr ) {
+            const size_t heads = activationIndex.back( ) + layers.back( )->getActualNeuronCount( ) - outputCount;
+            for( size_t b = 0; b < batchSize; ++b ) {
+                alu->copy( outputCount,
+                           outputs + (b * activationStride) + heads,
+                           results + (b * outputCount) );
+            }
+        }
+    }
 
-            const auto neuronConnectionCount = connections[ i ]->srcNeuronConnectionCount;
-            auto       scratch               = scratchPad0 + connections[ i ]->weightIndex;
+    void ANNetwork::forEachInLevel( const std::vector<size_t> &level,
+                                    const std::function<void( const size_t )> &work ) {
+        if( !threadPool || level.size( ) < 2 ) {
+            for( auto &&layer : level ) { work( layer ); }
+            return;
+        }
+        for( auto &&layer : level ) {
+            threadPool->submit( [ &work, layer ]() { work( layer ); } );
+        }
+        threadPool->wait( );
+    }
+
+    void ANNetwork::evaluateLayer( const size_t layer, const size_t batchSize ) {
+        CORE_TRACE_SCOPE_ARG( "evaluate.layer", layer );
+        auto alu = Core::VectorALUFactory( );
 
-            alu->replicateItems( srcNeuronCount, neuronConnectionCount, srcOutputs, scratch );
-            // now add bias 1 if need
-            if( srcLayer->isBiased( ) ) {
-                for( int j = 0; j < neuronConnectionCount; ++j ) {
-                    scratch[ (srcNeuronCount * neuronConnectionCount) + j ] = Core::real( 1.0 );
+        const auto &dstLayer       = layers[ layer ];
+        const auto dstNeuronCount = dstLayer->getActualNeuronCount( );
+        const auto dstNeuronIndex = activationIndex[ layer ];
+        const auto &af             = dstLayer->getActivationFunc( );
+
+        // outputs = act( src outputs * weights + bias weights ) for the whole batch in one fused pass, the pre
+        // activation sums are only kept when training needs them for the derivatives
+        const auto &feeds = inbound[ layer ];
+        if( feeds.size( ) == 1 ) {
+            const auto &connect = connections[ feeds.front( ) ];
+            alu->packedDenseActivate( batchSize, dstNeuronCount, connect->from->countOfNeurons( ),
+                                      outputs + activationIndex[ sourceLayer[ feeds.front( ) ] ], activationStride,
+                                      weights + connect->weightIndex, panelWidth,
+                                      af.getKernel( ), af.getKernelParam0( ), af.getKernelParam1( ),
+                                      (gradients != nullptr) ? sums + dstNeuronIndex : nullptr, activationStride,
+                                      outputs + dstNeuronIndex, activationStride );
+        } else {
+            // several feeds are summed before the activation, in the sums when training else in place in the outputs
+            auto pre = ((gradients != nullptr) ? sums : outputs) + dstNeuronIndex;
+            for( size_t i = 0; i < feeds.size( ); ++i ) {
+                const auto &connect = connections[ feeds[ i ] ];
+                const auto src      = outputs + activationIndex[ sourceLayer[ feeds[ i ] ] ];
+                if( i == 0 ) {
+                    alu->packedDenseActivate( batchSize, dstNeuronCount, connect->from->countOfNeurons( ),
+                                              src, activationStride,
+                                              weights + connect->weightIndex, panelWidth,
+                                              Core::ActivationKernel::Identity, Core::real( 0 ), Core::real( 0 ),
+                                              nullptr, 0, pre, activationStride );
+                } else {
+                    alu->packedDenseAccumulate( batchSize, dstNeuronCount, connect->from->countOfNeurons( ),
+                                                src, activationStride,
+                                                weights + connect->weightIndex, panelWidth, pre, activationStride );
                 }
             }
+            for( size_t b = 0; b < batchSize; ++b ) {
+                alu->activate( dstNeuronCount, af.getKernel( ), af.getKernelParam0( ), af.getKernelParam1( ),
+                               pre + (b * activationStride), outputs + (b * activationStride) + dstNeuronIndex );
+            }
         }
 
-        // weight the connections (all at once)
-        alu->mul( totalWeightCount, weights, scratchPad0, scratchPad1 );
+        // recomputed layers share columns so their bias neuron may have been overwritten by another segment
+        if( !checkpointed[ layer ] && dstLayer->isBiased( ) ) {
+            for( size_t b = 0; b < batchSize; ++b ) {
+                outputs[ (b * activationStride) + dstNeuronIndex + dstNeuronCount ] = Core::real( 1 );
+            }
+        }
+    }
 
-        // sum the result per layer
-        for( int i = 0; i < connections.size( ); ++i ) {
-            const auto &toLayer = connections[ i ]->to;
+    void ANNetwork::computeGradients( Core::VectorALU::const_real_array_ptr &perfect ) {
+        computeGradients( 1, perfect );
+    }
 
-            // weights store on from layer
-            const auto toNeuronCount = toLayer->getActualNeuronCount( );
-            const auto toNeuronIndex = toLayer->getNeuronIndex( );
+    void ANNetwork::computeGradients( const size_t batchSize, Core::VectorALU::const_real_array_ptr perfect ) {
+        CORE_TRACE_SCOPE_ARG( "ANNetwork::computeGradients", batchSize );
+        assert( gradients != nullptr );
+        assert( batchSize <= maxBatchSize );
+
+        if( chainOrder.empty( ) ) {
+            // note: we are back propagating so last level to first, every layer a level feeds is already done
+            for( size_t i = levels.size( ) - 1; i < levels.size( ); --i ) {
+                forEachInLevel( levels[ i ], [ this, batchSize, perfect ]( const size_t layer ) {
+                    backPropagateLayer( layer, batchSize, perfect );
+                } );
+            }
+        } else {
+            // down the chain, before a checkpoint the segment below it is evaluated again from the checkpoint before
+            // that, its outputs are what the checkpoints gradients need. the last segment is still there from evaluate
+            for( size_t p = chainOrder.size( ) - 1; p > 0; --p ) {
+                if( checkpointed[ chainOrder[ p ] ] && p + 1 < chainOrder.size( ) &&
+                    !checkpointed[ chainOrder[ p - 1 ] ] ) {
+                    CORE_TRACE_SCOPE_ARG( "computeGradients.recompute", chainOrder[ p ] );
+                    size_t first = p - 1;
+                    while( !checkpointed[ chainOrder[ first - 1 ] ] ) { --first; }
+                    for( size_t q = first; q < p; ++q ) { evaluateLayer( chainOrder[ q ], batchSize ); }
+                }
+                backPropagateLayer( chainOrder[ p ], batchSize, perfect );
+            }
+        }
 
-            const auto neuronConnectionCount = connections[ i ]->dstNeuronConnectionCount;
-            auto       layerSums             = sums + toNeuronIndex;
-            auto       layerOutputs          = outputs + toNeuronIndex;
-            auto       scratch               = scratchPad1 + connections[ i ]->weightIndex;
+        gradientSampleCount += batchSize;
+    }
 
-            for( auto j = 0; j < toNeuronCount; ++j ) {
-                alu->gather( neuronConnectionCount,
-                             scratch + j,
-                             connections[ i ]->srcNeuronConnectionCount,
-                             scratchPad0 );
-                *(layerSums + j) = alu->horizSum( neuronConnectionCount, scratchPad0 );
+    void ANNetwork::backPropagateLayer( const size_t layer, const size_t batchSize,
+                                        Core::VectorALU::const_real_array_ptr perfect ) {
+        CORE_TRACE_SCOPE_ARG( "computeGradients.layer", layer );
+        auto alu = Core::VectorALUFactory( );
+
+        const auto &dstLayer       = layers[ layer ];
+        const auto dstNeuronIndex = activationIndex[ layer ];
+        const auto dstNeuronCount = dstLayer->getActualNeuronCount( );
+        const auto &af             = dstLayer->getActivationFunc( );
+
+        if( dstLayer->getLayerType( ) == LayerType::OutputLayer ) {
+            // heads compare with their slice of perfect, for E = 1/2 |output - perfect|^2 delta = output - perfect
+            const auto head = dstLayer->getNeuronIndex( ) - outputNeuronIndex;
+            for( size_t b = 0; b < batchSize; ++b ) {
+                const auto row = (b * activationStride) + dstNeuronIndex;
+                alu->sub( dstNeuronCount, outputs + row, perfect + (b * outputCount) + head, nodeDeltas + row );
+            }
+        } else {
+            // deltas = sum over what this layer feeds of (dst deltas * W^T), the bias row is skipped as nothing
+            // feeds a bias neuron
+            const auto &feeds = outbound[ layer ];
+            for( size_t i = 0; i < feeds.size( ); ++i ) {
+                const auto &connect = connections[ feeds[ i ] ];
+                const auto beta     = (i == 0) ? Core::real( 0 ) : Core::real( 1 );
+                const auto toCount  = connect->to->getActualNeuronCount( );
+                const auto toDeltas = nodeDeltas + activationIndex[ targetLayer[ feeds[ i ] ] ];
+                if( backpropWeights != nullptr ) {
+                    alu->packedGemm( batchSize, dstNeuronCount, toCount,
+                                     toDeltas, activationStride,
+                                     backpropWeights + connect->weightIndex, panelWidth,
+                                     beta,
+                                     nodeDeltas + dstNeuronIndex, activationStride );
+                } else {
+                    alu->packedGemmTransposed( batchSize, dstNeuronCount, toCount,
+                                               toDeltas, activationStride,
+                                               weights + connect->weightIndex, dstLayer->countOfNeurons( ),
+                                               panelWidth, beta,
+                                               nodeDeltas + dstNeuronIndex, activationStride );
+                }
             }
+        }
 
-            // activate each neuron in this layer
-            toLayer->getActivationFunc( ).activate( toNeuronCount, layerSums, layerOutputs );
+        // . f'( sums )
+        for( size_t b = 0; b < batchSize; ++b ) {
+            const auto row = (b * activationStride) + dstNeuronIndex;
+            alu->mulActivationDerivative( dstNeuronCount, af.getKernel( ), af.getKernelParam0( ), sums + row,
+                                          nodeDeltas + row );
         }
 
-        if( results != nullptr ) {
-            alu->copy( layers.back( )->getActualNeuronCount( ), outputs + layers.back( )->getNeuronIndex( ), results );
+        // dE/dw += src outputs^T * deltas for every connection feeding this layer, summed over the batch by the
+        // matrix multiply. nothing reads them again this pass so they can go as soon as they are done
+        for( auto &&c : inbound[ layer ] ) {
+            const auto &connect = connections[ c ];
+            alu->packedOuterAccumulate( batchSize, connect->from->countOfNeurons( ), dstNeuronCount,
+                                        outputs + activationIndex[ sourceLayer[ c ] ], activationStride,
+                                        nodeDeltas + dstNeuronIndex, activationStride,
+                                        panelWidth, gradients + connect->weightIndex );
+            if( gradientReady ) {
+                gradientReady( c );
+            }
         }
     }
 
-    void ANNetwork::computeGradients( Core::VectorALU::const_real_array_ptr &perfect ) {
-        using namespace Core;
+    std::vector<size_t> ANNetwork::getCheckpointLayers() const {
+        std::vector<size_t> kept;
+        for( size_t l = 0; l < checkpointed.size( ); ++l ) {
+            if( checkpointed[ l ] ) { kept.push_back( l ); }
+        }
+        return kept;
+    }
 
-        auto alu = Core::VectorALUFactory( );
+    void ANNetwork::chooseCheckpoints() {
+        // the chain in order, every level a single layer fed by the one before
+        std::vector<size_t> chain{ 0 };
+        for( auto &&level : levels ) {
+            assert( level.size( ) == 1 && inbound[ level.front( ) ].size( ) == 1 );
+            assert( sourceLayer[ inbound[ level.front( ) ].front( ) ] == chain.back( ) );
+            chain.push_back( level.front( ) );
+        }
+        const size_t columnBytes = 3 * maxBatchSize * sizeof( Core::real ); // outputs, sums and deltas
+
+        // for a widest segment of at most limit neurons, greedily grow segments and checkpoint the layer that
+        // doesn't fit. the input and the output are always kept
+        struct Plan {
+            std::vector<bool> kept;
+            size_t            stride;
+            size_t            recomputed; // weights evaluated again per sample
+        };
+        const auto plan = [ this, &chain ]( const size_t limit ) {
+            Plan   result{ std::vector<bool>( chain.size( ), true ), 0, 0 };
+            size_t kept = layers[ chain.front( ) ]->countOfNeurons( ) + layers[ chain.back( ) ]->countOfNeurons( );
+            size_t segment = 0, widest = 0, pending = 0;
+            for( size_t p = 1; p + 1 < chain.size( ); ++p ) {
+                const size_t width = layers[ chain[ p ] ]->countOfNeurons( );
+                if( segment + width <= limit ) {
+                    result.kept[ p ] = false;
+                    segment += width;
+                    pending += connections[ inbound[ chain[ p ] ].front( ) ]->weightCount;
+                    widest = std::max( widest, segment );
+                } else {
+                    // the segment just closed gets evaluated twice
+                    kept += width;
+                    result.recomputed += pending;
+                    segment = 0;
+                    pending = 0;
+                }
+            }
+            result.stride = kept + widest;
+            return result;
+        };
+
+        // every run of consecutive layers is a candidate limit, 0 keeps everything
+        std::vector<size_t> limits{ 0 };
+        for( size_t p = 1; p + 1 < chain.size( ); ++p ) {
+            size_t width = 0;
+            for( size_t q = p; q + 1 < chain.size( ); ++q ) {
+                width += layers[ chain[ q ] ]->countOfNeurons( );
+                limits.push_back( width );
+            }
+        }
 
-        // output layer is a special case (compare with perfect)
-        {
-            const auto &connect  = connections.back( );
-            const auto &dstLayer = connect->to;
-            assert( dstLayer->getLayerType( ) == LayerType::OutputLayer );
+        // least recomputation within the budget, else the smallest footprint there is
+        Plan best = plan( 0 );
+        bool fits = best.stride * columnBytes <= activationMemoryBudget;
+        for( auto &&limit : limits ) {
+            Plan       candidate     = plan( limit );
+            const bool candidateFits = candidate.stride * columnBytes <= activationMemoryBudget;
+            const bool cheaper       = (candidate.recomputed < best.recomputed) ||
+                                       (candidate.recomputed == best.recomputed && candidate.stride < best.stride);
+            const bool better        = fits ? (candidateFits && cheaper)
+                                            : (candidateFits || candidate.stride < best.stride);
+            if( better ) {
+                best = std::move( candidate );
+                fits = candidateFits;
+            }
+        }
 
-            const auto dstNeuronIndex = dstLayer->getNeuronIndex( );
-            const auto dstNeuronCount = dstLayer->countOfNeurons( );
+        // kept layers first in chain order, then the segments all starting at the same column
+        size_t stride = 0;
+        for( size_t p = 0; p < chain.size( ); ++p ) {
+            checkpointed[ chain[ p ] ] = best.kept[ p ];
+            if( best.kept[ p ] ) {
+                activationIndex[ chain[ p ] ] = stride;
+                stride += layers[ chain[ p ] ]->countOfNeurons( );
+            }
+        }
+        size_t column = stride;
+        for( size_t p = 1; p < chain.size( ); ++p ) {
+            if( !best.kept[ p ] ) {
+                activationIndex[ chain[ p ] ] = column;
+                column += layers[ chain[ p ] ]->countOfNeurons( );
+            } else {
+                column = stride;
+            }
+        }
+        activationStride = best.stride;
+        assert( activationStride >= stride );
 
-            alu->sub( dstNeuronCount,
-                      perfect,
-                      outputs + dstNeuronIndex,
-                      scratchPad0 );
+        if( activationStride < totalNeuronCount ) {
+            chainOrder = chain;
+        }
+    }
 
-            auto dstDeltas = nodeDeltas + dstNeuronIndex;
+    void ANNetwork::updateWeights() {
+        CORE_TRACE_SCOPE( "ANNetwork::updateWeights" );
+        assert( optimizer );
+        assert( !frozen );
 
-            dstLayer->getActivationFunc( ).differentiate( dstNeuronCount, scratchPad0, scratchPad1 );
-            alu->negate( dstNeuronCount, scratchPad1, dstDeltas );
+        if( gradientSampleCount == 0 ) {
+            return;
         }
 
-        // note: we are back propagating so last hidden layer to first hidden layer
-        for( size_t i = connections.size( ) - 1; i < connections.size( ); i-- ) {
-            const auto &dstLayer = connections[ i ]->from;
-            const auto &srcLayer = connections[ i ]->to;
-
-            const auto weight                  = weights + connections[ i ]->weightIndex;
-            const auto weightCount             = connections[ i ]->weightCount;
-            const auto numConnectionsPerNeuron = connections[ i ]->dstNeuronConnectionCount;
+        optimizer->step( weights, gradients, etalearningRate, Core::real( 1 ) / Core::real( gradientSampleCount ) );
+        gradientSampleCount = 0;
 
-            const auto srcDeltas      = nodeDeltas + srcLayer->getNeuronIndex( );
-            const auto srcOutputs     = outputs + srcLayer->getNeuronIndex( );
-            const auto srcNeuronCount = srcLayer->countOfNeurons( );
+        refreshBackpropWeights( );
+    }
 
-            auto       tmpDeltas      = scratchPad1 + dstLayer->getNeuronIndex( );
-            auto       dstDeltas      = nodeDeltas + dstLayer->getNeuronIndex( );
-            const auto dstNeuronCount = dstLayer->countOfNeurons( );
+    ANNetwork::BatchStage ANNetwork::newBatchStage() const {
+        BatchStage stage;
+        stage.inputs.assign( maxBatchSize * inputCount, Core::real( 0 ) );
+        stage.perfect.assign( maxBatchSize * outputCount, Core::real( 0 ) );
+        stage.results.assign( maxBatchSize * outputCount, Core::real( 0 ) );
+        return stage;
+    }
 
-            for( int j = 0; j < srcNeuronCount; ++j ) {
-                alu->mul( numConnectionsPerNeuron,
-                          weight + (j * numConnectionsPerNeuron),
-                          *(srcDeltas + j),
-                          scratchPad0 );
+    Core::real ANNetwork::runBatch( BatchStage &stage, const std::vector<MatchingPair> &set, const size_t first,
+                                    const size_t batchSize, const bool backPropagate ) {
+        assert( batchSize > 0 && batchSize <= maxBatchSize && first + batchSize <= set.size( ) );
+        auto alu = Core::VectorALUFactory( );
 
-                *(tmpDeltas + j) = alu->horizSum( numConnectionsPerNeuron, scratchPad0 );
-            }
+        for( size_t b = 0; b < batchSize; ++b ) {
+            alu->copy( inputCount, set[ first + b ].first, stage.inputs.data( ) + (b * inputCount) );
+            alu->copy( outputCount, set[ first + b ].second, stage.perfect.data( ) + (b * outputCount) );
+        }
 
-            dstLayer->getActivationFunc( ).differentiate( dstNeuronCount, tmpDeltas, dstDeltas );
+        evaluate( batchSize, stage.inputs.data( ), stage.results.data( ) );
+        if( backPropagate ) {
+            computeGradients( batchSize, stage.perfect.data( ) );
         }
+        return SumOfSquare( *alu, batchSize * outputCount, stage.perfect.data( ), stage.results.data( ) );
     }
 
-    void ANNetwork::updateWeights() {
+    Core::real ANNetwork::trainEpoch( const std::vector<MatchingPair> &trainingSet ) {
+        assert( trainingSet.size( ) > 0 );
 
-        auto alu = Core::VectorALUFactory( );
+        auto       stage = newBatchStage( );
+        Core::real err   = Core::real( 0 );
+        for( size_t first = 0; first < trainingSet.size( ); first += maxBatchSize ) {
+            err += runBatch( stage, trainingSet, first, std::min( maxBatchSize, trainingSet.size( ) - first ), true );
+            updateWeights( );
+        }
 
-        for( int i = 0; i < connections.size( ); ++i ) {
-            const auto &srcLayer = connections[ i ]->from;
+        return std::sqrt( err / Core::real( trainingSet.size( ) * outputCount ) );
+    }
 
-            const auto srcNeuronConnectionCount = connections[ i ]->srcNeuronConnectionCount;
-            const auto srcOutput                = outputs + srcLayer->getNeuronIndex( );
-            auto       scratch0                 = scratchPad0 + connections[ i ]->weightIndex;
-            alu->replicateItems( srcLayer->countOfNeurons( ), srcNeuronConnectionCount, srcOutput, scratch0 );
+    Core::real ANNetwork::accumulateGradients( const std::vector<MatchingPair> &trainingSet ) {
+        assert( trainingSet.size( ) > 0 );
+        CORE_TRACE_SCOPE( "ANNetwork::accumulateGradients" );
 
-            const auto &dstLayer                = connections[ i ]->to;
-            const auto dstNeuronConnectionCount = connections[ i ]->dstNeuronConnectionCount;
-            const auto dstDeltas                = outputs + dstLayer->getNeuronIndex( );
-            auto       scratch1                 = scratchPad1 + connections[ i ]->weightIndex;
-            alu->replicateItems( dstLayer->countOfNeurons( ), dstNeuronConnectionCount, dstDeltas, scratch1 );
+        auto       stage = newBatchStage( );
+        Core::real err   = Core::real( 0 );
+        for( size_t first = 0; first < trainingSet.size( ); first += maxBatchSize ) {
+            err += runBatch( stage, trainingSet, first, std::min( maxBatchSize, trainingSet.size( ) - first ), true );
         }
-        alu->mul( totalWeightCount, scratchPad0, scratchPad1, scratchPad2 );
 
-        // weight the connections (all at once)
-        alu->fmad( totalWeightCount,
-                   scratchPad2,
-                   weights,
-                   -etalearningRate,
-                   scratchPad0 ); // eta * grad * in (at weight rate)
-        alu->fmad( totalNeuronCount, weights, alphaMomentum, scratchPad0, scratchPad1 ); // momentum
+        return err;
+    }
+
+    Core::real ANNetwork::testError( const std::vector<MatchingPair> &testSet ) {
+        assert( testSet.size( ) > 0 );
+        CORE_TRACE_SCOPE( "ANNetwork::testError" );
+
+        auto       stage = newBatchStage( );
+        Core::real err   = Core::real( 0 );
+        for( size_t first = 0; first < testSet.size( ); first += maxBatchSize ) {
+            err += runBatch( stage, testSet, first, std::min( maxBatchSize, testSet.size( ) - first ), false );
+        }
 
-        alu->copy( totalWeightCount, scratchPad1, weights );
+        return std::sqrt( err / Core::real( testSet.size( ) * outputCount ) );
     }
 
     void ANNetwork::supervisedTrain( const std::vector<MatchingPair> &trainingSet,
@@ -310,30 +739,15 @@ namespace MachineLearning {
         assert( trainingSet.size( ) > 0 );
         assert( testSet.size( ) > 0 );
 
-        int epoch = 0;
-
-        auto tmpResults = std::vector<Core::real>( connections.back( )->to->getActualNeuronCount( ), Core::real( 0 ) );
-
-        Core::real bestErr = Core::real( 1 );
-
+        // validation runs on a snapshot across the pool, so it costs little next to the epoch itself
+        DatasetEvaluator evaluator{ DatasetEvaluator::Config( ) };
         for( int epoch = 0; epoch < 10; ++epoch ) {
-            Core::real err = Core::real( 0 );
-
-            for( auto &&ipair : trainingSet ) {
-                evaluate( ipair.first, tmpResults.data( ) );
-                computeGradients( ipair.second );
-
-                err = RootMeanSquare( 1, ipair.second, tmpResults.data( ) );
-                std::cout << "training " << err << "\n";
-            }
-            if( err < bestErr ) {
-                std::cout << "Epoch " << epoch << "\n";
-                updateWeights( );
-                bestErr = err;
-            }
+            CORE_TRACE_SCOPE_ARG( "supervisedTrain.epoch", epoch );
+            const auto err  = trainEpoch( trainingSet );
+            const auto test = evaluator.evaluate( *createModel( ), testSet );
+            std::cout << "Epoch " << epoch << " training RMS " << err << " test RMS " << test.rms << " MAE "
+                      << test.mae << " max " << test.maxAbs << "\n";
         }
-
-//        setErr /= trainingSet.size( );
     }
 /*
     void ANNetwork::supervisedTrainMiniBatch( int numTraining,  Core::VectorALU::const_real_array_ptr* input,
@@ -4,27 +4,62 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <vector>
 #include "core/core.h"
+#include "core/randomstream.h"
 #include "machinelearning/machinelearning.h"
 #include "machinelearning/layer.h"
 #include "machinelearning/connections.h"
+#include "machinelearning/model.h"
+#include "machinelearning/optimizer.h"
+
+namespace Core {
+    class ThreadPool;
+}
 
 namespace MachineLearning {
     class ANNetwork {
         FRIEND_TEST( MachineLearningTests, ANNetworkStructureInOut );
+        FRIEND_TEST( MachineLearningTests, ANNetworkBackprop );
+        friend class LBFGSTrainer;
+        friend class DataParallelTrainer;
+        friend class PipelineTrainer;
 
     public:
         using MatchingPair = std::pair<Core::VectorALU::const_real_array_ptr, Core::VectorALU::const_real_array_ptr>;
 
+        // bytes currently allocated, by what the buffers are for
+        struct MemoryUsage {
+            size_t weights         = 0;
+            size_t activations     = 0; // per neuron outputs, maxBatchSize rows
+            size_t preActivations  = 0; // training only from here down
+            size_t deltas          = 0;
+            size_t gradients       = 0;
+            size_t backpropWeights = 0;
+            size_t optimizerState  = 0;
+
+            size_t total() const {
+                return weights + activations + preActivations + deltas + gradients + backpropWeights + optimizerState;
+            }
+        };
+
         ANNetwork();
 
         ~ANNetwork();
 
         void addLayer( const Layer::shared_ptr layer );
 
+        // the layers and connections can form any DAG: a layer fed by several connections sums them (each brings
+        // its own bias row) so skip connections and merging branches work, and several OutputLayers make several
+        // heads. the heads must be the last layers added, results hold their outputs one after another
         void connectLayers( const Connections::shared_ptr connector );
 
+        // layers that don't depend on each other (the branches of a level) run as tasks on the pool, forwards and
+        // backwards. only pays once branches are wide, nullptr (the default) runs everything on the calling thread
+        void setThreadPool( const std::shared_ptr<Core::ThreadPool> &pool ) { threadPool = pool; }
+
         std::vector<Layer::shared_ptr>::iterator begin() { return layers.begin( ); }
 
         std::vector<Layer::shared_ptr>::const_iterator cbegin() const { return layers.cbegin( ); }
@@ -35,20 +70,75 @@ namespace MachineLearning {
 
         size_t getLayerCount() const { return layers.size( ); }
 
+        // uses the next stream of Core::Random's seed
         void setRandomWeights();
 
+        // from a specific stream, for reproducible networks when several are built concurrently
+        void setRandomWeights( Core::RandomStream &stream );
+
+        // weights are always exchanged in the public ordering: per connection, source neuron major (bias row last),
+        // whatever packing finalise chose internally
         void setWeights( const std::vector<Core::real> &in );
 
+        std::vector<Core::real> getWeights() const;
+
+        // accumulated dE/dw since the last update, in the same public ordering as the weights
+        std::vector<Core::real> getGradients() const;
+
+        // immutable snapshot of the topology and current weights that any number of threads can share
+        Model::shared_ptr createModel() const;
+
+        // keep a packed W^T so delta propagation reads weights contiguously through the evaluate kernel, costs one
+        // extra weight sized buffer refreshed per update. set before finalise( true ), defaults on
+        void setTransposedBackpropWeights( const bool enable ) { transposedBackpropWeights = enable; }
+
+        // caps the training activation memory (outputs, pre activations and deltas of maxBatchSize samples) by only
+        // keeping the activations of some checkpoint layers and running the forward pass of the layers between two
+        // checkpoints again as computeGradients reaches them. finalise( true ) picks the checkpoints that recompute
+        // the least within the budget, or keeps as little as it can if nothing fits. plain chains only, 0 (the
+        // default) keeps everything. set before finalise
+        void setActivationMemoryBudget( const size_t bytes ) { activationMemoryBudget = bytes; }
+
+        // layers whose activations are kept through training, all of them without a budget
+        std::vector<size_t> getCheckpointLayers() const;
+
         /// call this before using the network, if you will be training pass willTrain = true
-        void finalise( bool willTrain = false );
+        /// maxBatchSize is the largest number of samples that will be evaluated or back propagated at once
+        void finalise( bool willTrain = false, size_t maxBatchSize = 1 );
 
         // given input produce the approximate answer output
+        // evaluate uses the networks own buffers, for concurrent inference use createModel and InferenceSessions
         void evaluate( Core::VectorALU::const_real_array_ptr input, Core::VectorALU::real_array_ptr results );
 
+        // batchSize samples at once, inputs and results are packed one sample after another
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results );
+
+        // back propagate against the perfect answer for the last evaluate, accumulating into the weight gradients
         void computeGradients( Core::VectorALU::const_real_array_ptr &perfect );
 
+        // back propagate the whole batch from the last batched evaluate, perfect is packed like the results
+        void computeGradients( const size_t batchSize, Core::VectorALU::const_real_array_ptr perfect );
+
+        // called by computeGradients as soon as a connections gradients for the batch are final, so they can be
+        // sent while the earlier layers are still back propagating. from pool threads if there is a thread pool
+        using GradientReadyCallback = std::function<void( const size_t connection )>;
+
+        void setGradientReadyCallback( GradientReadyCallback callback ) { gradientReady = std::move( callback ); }
+
+        // apply the optimizer to the gradients accumulated since the last update (averaged over the samples)
         void updateWeights();
 
+        // one pass over the training set in mini batches of maxBatchSize, returns the training RMS
+        Core::real trainEpoch( const std::vector<MatchingPair> &trainingSet );
+
+        // back propagate the whole set in batches of maxBatchSize without updating the weights, for full or large
+        // batch methods. returns the sum of squared errors, the gradients hold the sum over the set
+        Core::real accumulateGradients( const std::vector<MatchingPair> &trainingSet );
+
+        // RMS error over the set without training, batched like trainEpoch
+        Core::real testError( const std::vector<MatchingPair> &testSet );
+
         // given known input and output, update the layer weights
         void supervisedTrain( const std::vector<MatchingPair> &trainingSet, const std::vector<MatchingPair> &testSet );
 
@@ -58,30 +148,113 @@ namespace MachineLearning {
 
         Core::real getMomentum() const { return alphaMomentum; }
 
+        // momentum of the default optimizer finalise( true ) creates when none has been set
         void setMomentum( Core::real _momentum ) { alphaMomentum = _momentum; }
 
+        // set before finalise( true ) which allocates the optimizer state
+        void setOptimizer( const Optimizer::shared_ptr _optimizer ) { optimizer = _optimizer; }
+
+        Optimizer::shared_ptr getOptimizer() const { return optimizer; }
+
         size_t getTotalNeuronCount() const { return totalNeuronCount; }
 
+        size_t getInputCount() const { return inputCount; }
+
+        // across every head
+        size_t getOutputCount() const { return outputCount; }
+
+        size_t getTotalWeightCount() const { return totalWeightCount; }
+
+        size_t getMaxBatchSize() const { return maxBatchSize; }
+
+        // done training for good: frees everything but the weights and activations, that's two weight sized
+        // buffers (gradients and backpropWeights), the per layer sums and delta rows and the optimizer state.
+        // evaluate, the weight accessors and createModel keep working, the training calls must not be used again
+        void freezeForInference();
+
+        bool isFrozen() const { return frozen; }
+
+        MemoryUsage getMemoryUsage() const;
+
     private:
+        // mini batches are staged contiguously for the batched evaluate and back propagation
+        struct BatchStage {
+            std::vector<Core::real> inputs;
+            std::vector<Core::real> perfect;
+            std::vector<Core::real> results;
+        };
+
+        // sized for maxBatchSize rows
+        BatchStage newBatchStage() const;
+
+        // stages set[ first, first + batchSize ), evaluates it, back propagates when asked and returns the batches
+        // sum of squared errors
+        Core::real runBatch( BatchStage &stage, const std::vector<MatchingPair> &set, const size_t first,
+                             const size_t batchSize, const bool backPropagate );
+
+        std::vector<Core::real> unpackWeightOrdered( Core::VectorALU::const_real_array_ptr packed ) const;
+
+        void refreshBackpropWeights();
+
+        // work( layer ) for every layer of a level, as pool tasks when there's a pool and more than one layer
+        void forEachInLevel( const std::vector<size_t> &level, const std::function<void( const size_t )> &work );
+
+        void evaluateLayer( const size_t layer, const size_t batchSize );
+
+        void backPropagateLayer( const size_t layer, const size_t batchSize,
+                                 Core::VectorALU::const_real_array_ptr perfect );
+
+        // lays out activationIndex for the cheapest checkpoints within activationMemoryBudget
+        void chooseCheckpoints();
+
         size_t totalNeuronCount; // how many neurons across the whole network
         size_t totalWeightCount; // how many weights across the whole network
+        size_t inputCount;
+        size_t outputNeuronIndex; // the heads are contiguous from here
+        size_t outputCount;
+
+        // the schedule finalise builds from the graph
+        std::vector<std::vector<size_t>> inbound;     // per layer, the connections feeding it
+        std::vector<std::vector<size_t>> outbound;    // per layer, the connections it feeds
+        std::vector<std::vector<size_t>> levels;      // layers by depth, each only depends on earlier levels
+        std::vector<size_t>              sourceLayer; // per connection
+        std::vector<size_t>              targetLayer; // per connection
+
+        // where each layer lives in the per sample rows of outputs, sums and nodeDeltas. without checkpoints that's
+        // its neuron index in rows of totalNeuronCount, with them the layers between two checkpoints share columns
+        // with those of every other segment and are recomputed when back propagation needs them
+        size_t              activationMemoryBudget;
+        size_t              activationStride;
+        std::vector<size_t> activationIndex; // per layer
+        std::vector<bool>   checkpointed;    // per layer
+        std::vector<size_t> chainOrder;      // the layers input first, only when some aren't checkpointed
+
+        Core::VectorALU::real_array_ptr sums;       // the summed pre activation value of each neuron (training only)
+        Core::VectorALU::real_array_ptr outputs;    // the output post activation per neuron (per sample)
+        Core::VectorALU::real_array_ptr weights;    // the weight value of each neuron to neuron interconnect
 
-        Core::VectorALU::real_array_ptr scratchPad0; // scratch pad 0 used as a temporary, totalWeightCount in size
-        Core::VectorALU::real_array_ptr scratchPad1; // scratch pad 1 used as a temporary, totalWeightCount in size
-        Core::VectorALU::real_array_ptr scratchPad2; // scratch pad 1 used as a temporary, totalWeightCount in size
+        // weights (and gradients and optimizer state) are panel packed per connection: the destination neurons are
+        // split into panels of panelWidth and each panel stores every source neurons weights to it contiguously
+        size_t panelWidth;
 
-        Core::VectorALU::real_array_ptr sums;       // the summed per activation value of each neuron
-        Core::VectorALU::real_array_ptr outputs;    // the output post activation per neuron
-        Core::VectorALU::real_array_ptr weights;    // the weight value of each neuron to neuron interconnect
+        size_t maxBatchSize; // sums, outputs and nodeDeltas hold this many rows of totalNeuronCount
 
         // training only arrays
-        Core::VectorALU::real_array_ptr deltaWeights;
         Core::VectorALU::real_array_ptr nodeDeltas;
         Core::VectorALU::real_array_ptr gradients;
+        size_t                          gradientSampleCount; // how many samples have been accumulated into gradients
+        Core::VectorALU::real_array_ptr backpropWeights;     // optional packed transpose of weights
+        bool                            transposedBackpropWeights;
+        bool                            frozen;
 
         Core::real etalearningRate;
         Core::real alphaMomentum;
 
+        Optimizer::shared_ptr optimizer; // owns any per weight training state (velocity, moments etc.)
+        GradientReadyCallback gradientReady;
+
+        std::shared_ptr<Core::ThreadPool> threadPool;
+
         std::vector<Layer::shared_ptr>       layers;
         std::vector<Connections::shared_ptr> connections;
     };
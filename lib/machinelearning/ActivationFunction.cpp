@@ -25,7 +25,7 @@ namespace MachineLearning {
                 alu->hyperbolicTangent(numItems, begin, output);
                 break;
             case ActivationFunctionType::ReLU:
-                alu->relu( numItems, begin, param0, output );
+                alu->relu( numItems, begin, param0, output, param1 );
                 break;
         }
     }
@@ -37,11 +37,11 @@ namespace MachineLearning {
 
         switch (activationFunctionType) {
             case ActivationFunctionType::Linear:
-                // TODO Can we alias rather than copy here?
-                alu->copy(numItems, begin, output);
+                alu->set( numItems, Core::real( 1.0 ), output );
                 break;
             case ActivationFunctionType::Step:
-                alu->step(numItems, begin, 0.5, output);
+                // flat everywhere except the discontinuity
+                alu->set( numItems, Core::real( 0.0 ), output );
                 break;
             case ActivationFunctionType::Sigmoid: {
                 // todo remove allocations
@@ -56,8 +56,16 @@ namespace MachineLearning {
                 alu->deleteRealVector(tmp2);
             }
                 break;
-            case ActivationFunctionType::HyperbolicTangent:
-                alu->hyperbolicTangent(numItems, begin, output);
+            case ActivationFunctionType::HyperbolicTangent: {
+                // 1 - tanh^2, todo remove allocations
+                auto tmp  = alu->newRealVector( numItems );
+                auto tmp2 = alu->newRealVector( numItems );
+                alu->hyperbolicTangent( numItems, begin, tmp );
+                alu->negate( numItems, tmp, tmp2 );
+                alu->fmad( numItems, tmp, tmp2, Core::real( 1.0 ), output );
+                alu->deleteRealVector( tmp );
+                alu->deleteRealVector( tmp2 );
+            }
                 break;
             case ActivationFunctionType::ReLU:
                 alu->step(numItems, begin, param0, output);
@@ -65,6 +73,27 @@ namespace MachineLearning {
         }
     }
 
+    Core::ActivationKernel ActivationFunction::getKernel() const {
+        switch( activationFunctionType ) {
+            case ActivationFunctionType::Linear:
+                return Core::ActivationKernel::Identity;
+            case ActivationFunctionType::Step:
+                return Core::ActivationKernel::Step;
+            case ActivationFunctionType::Sigmoid:
+                return Core::ActivationKernel::Sigmoid;
+            case ActivationFunctionType::HyperbolicTangent:
+                return Core::ActivationKernel::HyperbolicTangent;
+            case ActivationFunctionType::ReLU:
+                return Core::ActivationKernel::ReLU;
+        }
+        return Core::ActivationKernel::Identity;
+    }
+
+    Core::real ActivationFunction::getKernelParam0() const {
+        // step has a fixed threshold, see activate
+        return (activationFunctionType == ActivationFunctionType::Step) ? Core::real( 0.5 ) : param0;
+    }
+
     bool ActivationFunction::hasDerivative() const {
         switch (activationFunctionType) {
             case ActivationFunctionType::Linear:
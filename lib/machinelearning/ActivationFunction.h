@@ -23,8 +23,27 @@ namespace MachineLearning {
 
         }
 
+        ActivationFunction( const ActivationFunctionType activationLayerType, const Core::real _param0,
+                            const Core::real _param1 ) :
+                activationFunctionType( activationLayerType ),
+                param0( _param0 ),
+                param1( _param1 ) {
+        }
+
         bool hasDerivative() const;
 
+        // the fused kernel form of this activation, with its parameters
+        Core::ActivationKernel getKernel() const;
+
+        Core::real getKernelParam0() const;
+
+        Core::real getKernelParam1() const { return param1; }
+
+        // as constructed, what a copy of this function needs
+        Core::real getParam0() const { return param0; }
+
+        Core::real getParam1() const { return param1; }
+
         void activate( const size_t numItems, Core::VectorALU::const_real_array_ptr &begin,
                        Core::VectorALU::real_array_ptr output ) const;
 
@@ -0,0 +1,142 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "machinelearning/adaptivesampler.h"
+
+namespace MachineLearning {
+
+    AdaptiveSampler::AdaptiveSampler( const std::vector<Core::real> &_lo, const std::vector<Core::real> &_hi,
+                                      const Config &_config ) :
+            lo( _lo ),
+            hi( _hi ),
+            config( _config ),
+            dirty( true ),
+            importance( _lo.size( ) + 1, _config.seed ),
+            domain( _lo.size( ), _config.seed + 1 ) {
+        assert( lo.size( ) == hi.size( ) );
+        assert( lo.size( ) > 0 && lo.size( ) < Core::SobolSequence::maxDimensions );
+        assert( config.cellsPerDimension > 0 );
+        assert( config.uniformFraction >= Core::real( 0 ) && config.uniformFraction <= Core::real( 1 ) );
+
+        size_t cells = 1;
+        for( size_t d = 0; d < lo.size( ); ++d ) {
+            assert( hi[ d ] > lo[ d ] );
+            cells *= config.cellsPerDimension;
+        }
+        assert( cells <= (size_t( 1 ) << 24) );
+        errorMap.assign( cells, Core::real( 0 ) );
+        observed.assign( cells, false );
+    }
+
+    size_t AdaptiveSampler::cellOf( const Core::real *point ) const {
+        const size_t n    = config.cellsPerDimension;
+        size_t       cell = 0, stride = 1;
+        for( size_t d = 0; d < lo.size( ); ++d ) {
+            const Core::real u = std::min( std::max( (point[ d ] - lo[ d ]) / (hi[ d ] - lo[ d ]), Core::real( 0 ) ),
+                                           Core::real( 1 ) );
+            const auto       c = size_t( u * Core::real( n ) );
+            cell += std::min( c, n - 1 ) * stride;
+            stride *= n;
+        }
+        return cell;
+    }
+
+    void AdaptiveSampler::recordResiduals( const size_t count, const Core::real *points, const Core::real *errors ) {
+        const size_t dims = lo.size( );
+
+        // this batch's RMS per cell first, so one call counts once against the history however many points it has
+        std::vector<double> sumSquares( errorMap.size( ), 0.0 );
+        std::vector<size_t> hits( errorMap.size( ), 0 );
+        for( size_t i = 0; i < count; ++i ) {
+            const size_t cell = cellOf( points + (i * dims) );
+            sumSquares[ cell ] += double( errors[ i ] ) * double( errors[ i ] );
+            ++hits[ cell ];
+        }
+
+        for( size_t c = 0; c < errorMap.size( ); ++c ) {
+            if( hits[ c ] == 0 ) { continue; }
+            const auto rms = Core::real( std::sqrt( sumSquares[ c ] / double( hits[ c ] ) ) );
+            errorMap[ c ] = observed[ c ] ? (config.smoothing * errorMap[ c ]) +
+                                            ((Core::real( 1 ) - config.smoothing) * rms ) : rms;
+            observed[ c ] = true;
+        }
+        dirty = true;
+    }
+
+    void AdaptiveSampler::rebuildDistribution() {
+        const size_t cells = errorMap.size( );
+
+        // cells nobody has looked at yet get the average of those that have
+        double total = 0.0;
+        size_t seen  = 0;
+        for( size_t c = 0; c < cells; ++c ) {
+            if( observed[ c ] ) {
+                total += errorMap[ c ];
+                ++seen;
+            }
+        }
+        const double unseen = (seen > 0) ? total / double( seen ) : 1.0;
+        total += unseen * double( cells - seen );
+
+        const double uniform = double( config.uniformFraction ) / double( cells );
+        const double scale   = (total > 0.0) ? (1.0 - double( config.uniformFraction )) / total : 0.0;
+        const double spread  = (total > 0.0) ? uniform : 1.0 / double( cells );
+        cumulative.resize( cells );
+        double running = 0.0;
+        for( size_t c = 0; c < cells; ++c ) {
+            running += spread + (scale * (observed[ c ] ? double( errorMap[ c ] ) : unseen));
+            cumulative[ c ] = running;
+        }
+        dirty = false;
+    }
+
+    std::vector<Core::real> AdaptiveSampler::getCellProbabilities() {
+        if( dirty ) { rebuildDistribution( ); }
+        std::vector<Core::real> probabilities( cumulative.size( ) );
+        for( size_t c = 0; c < cumulative.size( ); ++c ) {
+            probabilities[ c ] = Core::real( cumulative[ c ] - ((c > 0) ? cumulative[ c - 1 ] : 0.0) );
+        }
+        return probabilities;
+    }
+
+    void AdaptiveSampler::sample( const size_t count, Core::real *points ) {
+        if( dirty ) { rebuildDistribution( ); }
+
+        const size_t            dims = lo.size( );
+        const size_t            n    = config.cellsPerDimension;
+        std::vector<Core::real> u( dims + 1 );
+        for( size_t i = 0; i < count; ++i ) {
+            importance.next( u.data( ) );
+
+            // inverse of the cumulative distribution picks the cell
+            const double target = double( u[ 0 ] ) * cumulative.back( );
+            size_t       cell   = size_t( std::upper_bound( cumulative.begin( ), cumulative.end( ), target ) -
+                                          cumulative.begin( ) );
+            cell = std::min( cell, cumulative.size( ) - 1 );
+
+            Core::real *p = points + (i * dims);
+            for( size_t d = 0; d < dims; ++d ) {
+                const size_t     c    = cell % n;
+                const Core::real step = (hi[ d ] - lo[ d ]) / Core::real( n );
+                p[ d ] = std::min( lo[ d ] + ((Core::real( c ) + u[ d + 1 ]) * step ), hi[ d ] );
+                cell /= n;
+            }
+        }
+    }
+
+    void AdaptiveSampler::sampleSobol( const size_t count, Core::real *points ) {
+        const size_t dims = lo.size( );
+        domain.fill( count, points );
+        for( size_t i = 0; i < count; ++i ) {
+            for( size_t d = 0; d < dims; ++d ) {
+                Core::real &x = points[ (i * dims) + d ];
+                x = lo[ d ] + (x * (hi[ d ] - lo[ d ]));
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "core/core.h"
+#include "core/sobol.h"
+
+namespace MachineLearning {
+
+    /*
+     * Picks training inputs where the approximation is worst. The box [lo, hi] is cut into a grid of cells, each
+     * holding a smoothed RMS of the residuals recorded in it, and new points are drawn with density proportional to
+     * that error (mixed with a uniform share so no region is starved of samples). Draws are quasi random: one Sobol
+     * coordinate chooses the cell through the cumulative error and the rest place the point inside it, so even the
+     * importance samples are stratified. sampleSobol gives the plain domain wide sequence for initial or validation
+     * sets. Domains of up to SobolSequence::maxDimensions - 1 inputs, keep the cell count modest in higher ones.
+     */
+    class AdaptiveSampler {
+    public:
+        struct Config {
+            size_t     cellsPerDimension = 16;
+            Core::real smoothing         = Core::real( 0.5 ); // weight a cells old estimate keeps on new residuals
+            Core::real uniformFraction   = Core::real( 0.1 ); // share of draws that ignore the map
+            uint64_t   seed              = 0xDEA0DEA0;
+        };
+
+        AdaptiveSampler( const std::vector<Core::real> &lo, const std::vector<Core::real> &hi, const Config &config );
+
+        size_t getDimensions() const { return lo.size( ); }
+
+        size_t getCellCount() const { return errorMap.size( ); }
+
+        // fold | approximation - target | at count points (packed one after another) into the map
+        void recordResiduals( const size_t count, const Core::real *points, const Core::real *errors );
+
+        // count points with density proportional to the mapped error
+        void sample( const size_t count, Core::real *points );
+
+        // the next count points of a Sobol sequence over the whole domain
+        void sampleSobol( const size_t count, Core::real *points );
+
+        // smoothed RMS residual per cell, the first dimension varies fastest. 0 for cells never observed
+        const std::vector<Core::real> &getErrorMap() const { return errorMap; }
+
+        // probability of a draw landing in each cell
+        std::vector<Core::real> getCellProbabilities();
+
+    private:
+        size_t cellOf( const Core::real *point ) const;
+
+        void rebuildDistribution();
+
+        const std::vector<Core::real> lo;
+        const std::vector<Core::real> hi;
+        const Config                  config;
+
+        std::vector<Core::real> errorMap;
+        std::vector<bool>       observed;
+        std::vector<double>     cumulative; // running sum of the cell probabilities, rebuilt when dirty
+        bool                    dirty;
+
+        Core::SobolSequence importance; // cell choice plus a position per dimension
+        Core::SobolSequence domain;
+    };
+}
@@ -0,0 +1,69 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/approximator.h"
+
+namespace MachineLearning {
+
+    namespace {
+        std::vector<Core::real> EvenSamples( const Core::real lo, const Core::real hi, const size_t sampleCount ) {
+            assert( sampleCount > 1 );
+            std::vector<Core::real> xs( sampleCount );
+            for( size_t i = 0; i < sampleCount; ++i ) {
+                xs[ i ] = lo + ((hi - lo) * Core::real( i ) / Core::real( sampleCount - 1 ));
+            }
+            return xs;
+        }
+
+        Core::real LargestDifference( Approximator &approx, const std::vector<Core::real> &xs,
+                                      const std::vector<Core::real> &expected ) {
+            assert( approx.getInputCount( ) == 1 && approx.getOutputCount( ) == 1 );
+            std::vector<Core::real> ys( xs.size( ) );
+            approx.evaluate( xs.size( ), xs.data( ), ys.data( ) );
+
+            Core::real worst = Core::real( 0 );
+            for( size_t i = 0; i < xs.size( ); ++i ) {
+                worst = std::max( worst, std::fabs( ys[ i ] - expected[ i ] ) );
+            }
+            return worst;
+        }
+    }
+
+    Core::real Approximator::maxError( const ScalarFunction &f, const Core::real lo, const Core::real hi,
+                                       const size_t sampleCount ) {
+        const auto              xs = EvenSamples( lo, hi, sampleCount );
+        std::vector<Core::real> expected( sampleCount );
+        for( size_t i = 0; i < sampleCount; ++i ) { expected[ i ] = f( xs[ i ] ); }
+        return LargestDifference( *this, xs, expected );
+    }
+
+    Core::real Approximator::maxError( Approximator &reference, const Core::real lo, const Core::real hi,
+                                       const size_t sampleCount ) {
+        assert( reference.getInputCount( ) == 1 && reference.getOutputCount( ) == 1 );
+        const auto              xs = EvenSamples( lo, hi, sampleCount );
+        std::vector<Core::real> expected( sampleCount );
+        reference.evaluate( sampleCount, xs.data( ), expected.data( ) );
+        return LargestDifference( *this, xs, expected );
+    }
+
+    NetworkApproximator::NetworkApproximator( const Model::shared_ptr _model, const size_t maxBatchSize ) :
+            model( _model ),
+            session( _model, maxBatchSize ) {
+    }
+
+    void NetworkApproximator::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                                        Core::VectorALU::real_array_ptr results ) {
+        // the session has a fixed batch size, bigger requests go through in slices
+        const size_t slice = session.getMaxBatchSize( );
+        for( size_t first = 0; first < batchSize; first += slice ) {
+            const size_t count = std::min( slice, batchSize - first );
+            session.evaluate( count, inputs + (first * getInputCount( )), results + (first * getOutputCount( )) );
+        }
+    }
+}
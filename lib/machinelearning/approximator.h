@@ -0,0 +1,73 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include "core/core.h"
+#include "core/vectoralu.h"
+#include "machinelearning/model.h"
+
+namespace MachineLearning {
+
+    // anything RealFunc like
+    using ScalarFunction = std::function<Core::real( const Core::real )>;
+
+    /*
+     * The common face of everything that approximates a function, a trained network or a classical fit, so callers
+     * can measure each against the accuracy they need and keep whichever is cheapest. Like an InferenceSession an
+     * instance is used from one thread at a time.
+     */
+    class Approximator {
+    public:
+        using shared_ptr = std::shared_ptr<Approximator>;
+
+        virtual ~Approximator() = default;
+
+        virtual size_t getInputCount() const = 0;
+
+        virtual size_t getOutputCount() const = 0;
+
+        // stored coefficients or weights, a rough guide to evaluation cost and memory traffic
+        virtual size_t getParameterCount() const = 0;
+
+        // inputs and results are packed one sample after another
+        virtual void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                               Core::VectorALU::real_array_ptr results ) = 0;
+
+        void evaluate( Core::VectorALU::const_real_array_ptr input, Core::VectorALU::real_array_ptr result ) {
+            evaluate( 1, input, result );
+        }
+
+        // largest | approximation - f | over sampleCount evenly spaced points of [lo, hi], 1 input 1 output only
+        Core::real maxError( const ScalarFunction &f, const Core::real lo, const Core::real hi,
+                             const size_t sampleCount = 4096 );
+
+        // the same against another approximator, e.g. a compact stand in against the network it replaces
+        Core::real maxError( Approximator &reference, const Core::real lo, const Core::real hi,
+                             const size_t sampleCount = 4096 );
+    };
+
+    // a network Model through its own InferenceSession
+    class NetworkApproximator : public Approximator {
+    public:
+        NetworkApproximator( const Model::shared_ptr _model, const size_t maxBatchSize = 64 );
+
+        size_t getInputCount() const override { return model->getInputCount( ); }
+
+        size_t getOutputCount() const override { return model->getOutputCount( ); }
+
+        size_t getParameterCount() const override { return model->getTotalWeightCount( ); }
+
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results ) override;
+
+        using Approximator::evaluate;
+
+    private:
+        const Model::shared_ptr model;
+        InferenceSession        session;
+    };
+}
@@ -0,0 +1,92 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "machinelearning/chebyshevapproximator.h"
+
+namespace MachineLearning {
+
+    namespace {
+        // c_j = 2/N sum_k f( x_k ) cos( pi j ( k + 1/2 ) / N ) at the N first kind nodes, c_0 halved. the cosines
+        // are all multiples of pi / 2N so come from one table
+        std::vector<double> ChebyshevCoefficients( const ScalarFunction &f, const double lo, const double hi,
+                                                   const size_t nodeCount ) {
+            const double        pi = 3.14159265358979323846;
+            std::vector<double> cosTable( 4 * nodeCount );
+            for( size_t i = 0; i < cosTable.size( ); ++i ) {
+                cosTable[ i ] = std::cos( pi * double( i ) / double( 2 * nodeCount ) );
+            }
+
+            std::vector<double> values( nodeCount );
+            for( size_t k = 0; k < nodeCount; ++k ) {
+                const double t = cosTable[ 2 * k + 1 ];
+                values[ k ] = f( Core::real( (0.5 * (hi + lo)) + (0.5 * (hi - lo) * t) ) );
+            }
+
+            std::vector<double> c( nodeCount );
+            for( size_t j = 0; j < nodeCount; ++j ) {
+                double sum = 0;
+                for( size_t k = 0; k < nodeCount; ++k ) {
+                    sum += values[ k ] * cosTable[ (j * (2 * k + 1)) % cosTable.size( ) ];
+                }
+                c[ j ] = 2.0 * sum / double( nodeCount );
+            }
+            c[ 0 ] *= 0.5;
+            return c;
+        }
+    }
+
+    ChebyshevApproximator::shared_ptr ChebyshevApproximator::fit( const ScalarFunction &f, const Core::real lo,
+                                                                  const Core::real hi, const Core::real tolerance,
+                                                                  const size_t maxCoefficients ) {
+        assert( hi > lo );
+        assert( tolerance > Core::real( 0 ) );
+
+        for( size_t nodeCount = 16; nodeCount <= maxCoefficients; nodeCount *= 2 ) {
+            const auto c = ChebyshevCoefficients( f, lo, hi, nodeCount );
+
+            // sum |c_k| beyond a cut bounds the truncation error, the upper half is the aliasing estimate
+            std::vector<double> tail( nodeCount + 1, 0.0 );
+            for( size_t k = nodeCount; k > 0; --k ) { tail[ k - 1 ] = tail[ k ] + std::fabs( c[ k - 1 ] ); }
+            if( tail[ nodeCount / 2 ] > 0.25 * tolerance ) {
+                continue;
+            }
+
+            size_t keep = nodeCount / 2;
+            while( keep > 1 && tail[ keep - 1 ] <= 0.5 * tolerance ) { keep--; }
+
+            auto approx = std::make_shared<ChebyshevApproximator>(
+                    lo, hi, std::vector<Core::real>( c.begin( ), c.begin( ) + keep ) );
+            if( approx->maxError( f, lo, hi, std::max( size_t( 4096 ), 8 * keep ) ) <= tolerance ) {
+                return approx;
+            }
+        }
+        return nullptr;
+    }
+
+    ChebyshevApproximator::ChebyshevApproximator( const Core::real lo, const Core::real hi,
+                                                  const std::vector<Core::real> &_coefficients ) :
+            scale( Core::real( 2 ) / (hi - lo) ),
+            offset( -(hi + lo) / (hi - lo) ),
+            coefficients( _coefficients ) {
+        assert( !coefficients.empty( ) );
+    }
+
+    void ChebyshevApproximator::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                                          Core::VectorALU::real_array_ptr results ) {
+        auto alu = Core::VectorALUFactory( );
+
+        // map to [-1, 1] through a small stack buffer, then the recurrence runs across the whole slice
+        constexpr size_t slice = 256;
+        Core::real       t[slice];
+        for( size_t first = 0; first < batchSize; first += slice ) {
+            const size_t count = std::min( slice, batchSize - first );
+            alu->fmad( count, inputs + first, scale, offset, t );
+            alu->chebyshevSeries( count, coefficients.data( ), coefficients.size( ), t, results + first );
+        }
+    }
+}
@@ -0,0 +1,49 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/approximator.h"
+
+namespace MachineLearning {
+
+    /*
+     * f( x ) ~ sum c_k T_k( t ) with t the input mapped from [lo, hi] to [-1, 1]. Coefficients come from a DCT of
+     * f sampled at the Chebyshev nodes, the node count doubles until the tail of the series is below the tolerance
+     * and the truncated series is then checked by sampling. Smooth functions converge geometrically so a few dozen
+     * coefficients usually do, evaluation is a batched Clenshaw recurrence in the ALU.
+     * Outside [lo, hi] the series is extrapolated and quickly becomes meaningless.
+     */
+    class ChebyshevApproximator : public Approximator {
+    public:
+        using shared_ptr = std::shared_ptr<ChebyshevApproximator>;
+
+        // nullptr if maxCoefficients can't reach the tolerance
+        static shared_ptr fit( const ScalarFunction &f, const Core::real lo, const Core::real hi,
+                               const Core::real tolerance, const size_t maxCoefficients = 4096 );
+
+        ChebyshevApproximator( const Core::real lo, const Core::real hi, const std::vector<Core::real> &coefficients );
+
+        size_t getInputCount() const override { return 1; }
+
+        size_t getOutputCount() const override { return 1; }
+
+        size_t getParameterCount() const override { return coefficients.size( ); }
+
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results ) override;
+
+        using Approximator::evaluate;
+
+        const std::vector<Core::real> &getCoefficients() const { return coefficients; }
+
+    private:
+        Core::real              scale;  // t = x * scale + offset
+        Core::real              offset;
+        std::vector<Core::real> coefficients;
+    };
+}
@@ -2,22 +2,25 @@
 // Created by Dean Calver on 14/04/2016.
 //
 
+#include <cassert>
 #include "core/core.h"
 #include "connections.h"
 
 
 namespace MachineLearning {
 
-    // fully connected
+    // fully connected, nothing connects into the destinations bias neuron
     Connections::Connections( const Layer::shared_ptr _from, const Layer::shared_ptr _to, int _fromEdgesPerNeuron ) :
             from( _from ),
             to( _to ),
             weightCount( (_fromEdgesPerNeuron == -1) ?
-                         (from->countOfNeurons( ) * to->countOfNeurons( )) : (from->countOfNeurons( ) *
+                         (from->countOfNeurons( ) * to->getActualNeuronCount( )) : (from->countOfNeurons( ) *
                                                                               _fromEdgesPerNeuron) ),
             srcNeuronConnectionCount( (_fromEdgesPerNeuron == -1) ? (weightCount / from->countOfNeurons( ))
                                                                   : _fromEdgesPerNeuron ),
             dstNeuronConnectionCount( weightCount / to->getActualNeuronCount( ) ) {
+        assert( (_fromEdgesPerNeuron == -1 || size_t( _fromEdgesPerNeuron ) == to->getActualNeuronCount( )) &&
+                "partially connected layers are not supported" );
     }
 
 
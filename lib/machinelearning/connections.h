@@ -13,10 +13,13 @@ namespace MachineLearning {
     class Connections {
     public:
         friend class ANNetwork;
+        friend class DataParallelTrainer;
+        friend class PipelineTrainer;
 
         using shared_ptr = std::shared_ptr<Connections>;
 
-        // -1 (default) for edgesPerNeuron is shortcut for fully connectioned
+        // -1 (default) for edgesPerNeuron is shortcut for fully connectioned. the layer level kernels only do fully
+        // connected, so any other value must be the destinations actual neuron count
         Connections( const Layer::shared_ptr _from, const Layer::shared_ptr _to, int _fromEdgesPerNeuron = -1 );
 
         const size_t getWeightCount() const { return weightCount; }
@@ -0,0 +1,87 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <cassert>
+#include "core/core.h"
+#include "machinelearning/convolution.h"
+
+namespace MachineLearning {
+
+    namespace {
+        // every offset of an extent sized box inside a box of the given dimensions, outermost dimension slowest
+        std::vector<size_t> BoxOffsets( const std::vector<size_t> &extent, const std::vector<size_t> &step,
+                                        const std::vector<size_t> &elementStride ) {
+            std::vector<size_t> offsets( 1, 0 );
+            for( size_t d = 0; d < extent.size( ); ++d ) {
+                std::vector<size_t> next;
+                next.reserve( offsets.size( ) * extent[ d ] );
+                for( auto &&base : offsets ) {
+                    for( size_t i = 0; i < extent[ d ]; ++i ) {
+                        next.push_back( base + (i * step[ d ] * elementStride[ d ]) );
+                    }
+                }
+                offsets.swap( next );
+            }
+            return offsets;
+        }
+    }
+
+    Convolution::Convolution( const LayerView &input, const LayerView &kernel, const size_t stride ) :
+            inputView( input ) {
+        const size_t spatialDims = input.numberOfDimensions( ) - 1;
+        assert( input.numberOfDimensions( ) >= 2 );
+        assert( kernel.numberOfDimensions( ) == input.numberOfDimensions( ) );
+        assert( stride > 0 );
+
+        inputChannels  = input.sizeOfDimension( spatialDims );
+        outputChannels = kernel.sizeOfDimension( spatialDims );
+
+        std::vector<size_t> outputDims, kernelDims, elementStride( spatialDims ), unitStep( spatialDims, 1 ),
+                            strideStep( spatialDims, stride );
+        for( size_t d = 0; d < spatialDims; ++d ) {
+            assert( kernel.sizeOfDimension( d ) <= input.sizeOfDimension( d ) );
+            outputDims.push_back( ((input.sizeOfDimension( d ) - kernel.sizeOfDimension( d )) / stride) + 1 );
+            kernelDims.push_back( kernel.sizeOfDimension( d ) );
+        }
+        outputDims.push_back( outputChannels );
+        outputView = LayerView( outputDims );
+
+        // elements between neighbours along each spatial dimension of the input
+        size_t running = inputChannels;
+        for( size_t d = spatialDims - 1; d < spatialDims; d-- ) {
+            elementStride[ d ] = running;
+            running *= input.sizeOfDimension( d );
+        }
+
+        outputDims.pop_back( );
+        positionOrigins = BoxOffsets( outputDims, strideStep, elementStride );
+        patchOffsets    = BoxOffsets( kernelDims, unitStep, elementStride );
+    }
+
+    void Convolution::im2col( Core::VectorALU::const_real_array_ptr in, Core::VectorALU::real_array_ptr o,
+                              const size_t ldo ) const {
+        auto alu = Core::VectorALUFactory( );
+
+        // the channels of each kernel element are contiguous in both the input and the patch row
+        for( size_t p = 0; p < positionOrigins.size( ); ++p ) {
+            Core::VectorALU::real_array_ptr row = o + (p * ldo);
+            for( size_t k = 0; k < patchOffsets.size( ); ++k ) {
+                alu->copy( inputChannels, in + positionOrigins[ p ] + patchOffsets[ k ], row + (k * inputChannels) );
+            }
+        }
+    }
+
+    void Convolution::col2imAccumulate( Core::VectorALU::const_real_array_ptr cols, const size_t ldc,
+                                        Core::VectorALU::real_array_ptr o ) const {
+        auto alu = Core::VectorALUFactory( );
+
+        for( size_t p = 0; p < positionOrigins.size( ); ++p ) {
+            Core::VectorALU::const_real_array_ptr row = cols + (p * ldc);
+            for( size_t k = 0; k < patchOffsets.size( ); ++k ) {
+                alu->accumulate( inputChannels, row + (k * inputChannels), Core::real( 1 ),
+                                 o + positionOrigins[ p ] + patchOffsets[ k ] );
+            }
+        }
+    }
+}
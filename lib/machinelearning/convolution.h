@@ -0,0 +1,64 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <vector>
+#include "core/core.h"
+#include "core/vectoralu.h"
+#include "machinelearning/layer.h"
+
+namespace MachineLearning {
+
+    /*
+     * Geometry of a valid (unpadded) convolution between two layers seen through LayerViews. The input view is the
+     * spatial dimensions followed by the channels, { length, channels } for 1D or { height, width, channels } for
+     * 2D. The kernel view is the kernel extent per spatial dimension followed by the output channel count, and the
+     * stride applies to every spatial dimension. The output view is derived.
+     * The convolution runs as im2col plus the ALUs panel kernels: every output position becomes a row of its input
+     * patch with a trailing 1, so the weights are a ( patchSize + 1 ) x outputChannels matrix with the bias weights
+     * as the last row, packed just like a dense connection, and shared across every position.
+     */
+    class Convolution {
+    public:
+        Convolution( const LayerView &input, const LayerView &kernel, const size_t stride = 1 );
+
+        const LayerView &getInputView() const { return inputView; }
+
+        const LayerView &getOutputView() const { return outputView; }
+
+        size_t getInputSize() const { return inputView.elementCount( ); }
+
+        size_t getOutputSize() const { return outputView.elementCount( ); }
+
+        // output positions per sample, the rows of the im2col matrix
+        size_t getPositionCount() const { return positionOrigins.size( ); }
+
+        // kernel elements times input channels, the columns of the im2col matrix without the bias column
+        size_t getPatchSize() const { return patchOffsets.size( ) * inputChannels; }
+
+        size_t getInputChannels() const { return inputChannels; }
+
+        size_t getOutputChannels() const { return outputChannels; }
+
+        size_t getWeightCount() const { return (getPatchSize( ) + 1) * outputChannels; }
+
+        // row p of o ( stride ldo ) = the input patch of output position p, the bias column is left alone
+        void im2col( Core::VectorALU::const_real_array_ptr in, Core::VectorALU::real_array_ptr o,
+                     const size_t ldo ) const;
+
+        // the adjoint of im2col, every patch element is added back to the input element it was copied from
+        void col2imAccumulate( Core::VectorALU::const_real_array_ptr cols, const size_t ldc,
+                               Core::VectorALU::real_array_ptr o ) const;
+
+    private:
+        LayerView inputView;
+        LayerView outputView;
+        size_t    inputChannels;
+        size_t    outputChannels;
+
+        std::vector<size_t> positionOrigins; // input offset of the first patch element for each output position
+        std::vector<size_t> patchOffsets;    // input offset of each kernel element relative to the origin
+    };
+}
@@ -0,0 +1,193 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/dataparalleltrainer.h"
+
+namespace MachineLearning {
+
+    DataParallelTrainer::DataParallelTrainer( ANNetwork &_network, Core::RingTransport &transport,
+                                              const Config &_config ) :
+            network( _network ),
+            allreduce( transport ),
+            config( _config ),
+            finished( 0 ),
+            failed( false ),
+            stopping( false ) {
+        assert( network.gradients != nullptr );
+        assert( !network.connections.empty( ) );
+
+        // whole connections per bucket, grouped in the order back propagation finishes them
+        const auto &connections = network.connections;
+        bucketOf.assign( connections.size( ), 0 );
+        size_t last = connections.size( ) - 1, bytes = 0;
+        for( size_t i = connections.size( ) - 1; i < connections.size( ); --i ) {
+            bytes += connections[ i ]->weightCount * sizeof( Core::real );
+            bucketOf[ i ] = buckets.size( );
+            if( bytes >= config.bucketBytes || i == 0 ) {
+                const size_t weightIndex = connections[ i ]->weightIndex;
+                const size_t weightEnd   = connections[ last ]->weightIndex + connections[ last ]->weightCount;
+                buckets.push_back( Bucket{ i, last, weightIndex, weightEnd - weightIndex } );
+                last  = i - 1;
+                bytes = 0;
+            }
+        }
+        for( auto &&bucket : buckets ) { remaining.push_back( bucket.lastConnection - bucket.firstConnection + 1 ); }
+
+        if( config.overlap ) {
+            communication = std::thread( [ this ]() { communicationLoop( ); } );
+            network.setGradientReadyCallback( [ this ]( const size_t connection ) { connectionDone( connection ); } );
+        }
+    }
+
+    DataParallelTrainer::~DataParallelTrainer() {
+        if( communication.joinable( ) ) {
+            network.setGradientReadyCallback( nullptr );
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stopping = true;
+            }
+            wake.notify_one( );
+            communication.join( );
+        }
+    }
+
+    void DataParallelTrainer::connectionDone( const size_t connection ) {
+        bool next;
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            const size_t bucket = bucketOf[ connection ];
+            next = (--remaining[ bucket ] == 0) && (bucket == finished);
+        }
+        if( next ) {
+            wake.notify_one( );
+        }
+    }
+
+    void DataParallelTrainer::communicationLoop() {
+        CORE_TRACE_THREAD_NAME( "DataParallelTrainer" );
+
+        std::unique_lock<std::mutex> lock( mutex );
+        for( ;; ) {
+            // strictly in bucket order, every rank has to join the same allreduce next
+            const auto ready = [ this ]() { return finished < buckets.size( ) && remaining[ finished ] == 0; };
+            wake.wait( lock, [ this, &ready ]() { return stopping || ready( ); } );
+            if( !ready( ) ) {
+                return;
+            }
+            const Bucket &bucket = buckets[ finished ];
+
+            // back propagation has moved on to earlier connections, nothing else touches this range until the update.
+            // once the ring has failed the rest are only counted so the step can finish
+            const bool skip = failed;
+            lock.unlock( );
+            const bool ok = skip || allreduce.sum( bucket.weightCount, network.gradients + bucket.weightIndex );
+            lock.lock( );
+            failed = failed || !ok;
+            ++finished;
+            done.notify_one( );
+        }
+    }
+
+    bool DataParallelTrainer::waitForBuckets() {
+        std::unique_lock<std::mutex> lock( mutex );
+        done.wait( lock, [ this ]() { return finished == buckets.size( ); } );
+        finished = 0;
+        for( size_t b = 0; b < buckets.size( ); ++b ) {
+            remaining[ b ] = buckets[ b ].lastConnection - buckets[ b ].firstConnection + 1;
+        }
+        return !failed;
+    }
+
+    bool DataParallelTrainer::broadcastWeights() {
+        CORE_TRACE_SCOPE( "DataParallelTrainer::broadcastWeights" );
+        auto alu = Core::VectorALUFactory( );
+
+        // rank 0s weights plus zeros is rank 0s weights exactly
+        if( allreduce.getTransport( ).getRank( ) != 0 ) {
+            alu->set( network.totalWeightCount, Core::real( 0 ), network.weights );
+        }
+        const bool ok = allreduce.sum( network.totalWeightCount, network.weights );
+        network.refreshBackpropWeights( );
+        return ok;
+    }
+
+    DataParallelTrainer::Result DataParallelTrainer::trainEpoch( const std::vector<ANNetwork::MatchingPair> &shard ) {
+        CORE_TRACE_SCOPE_ARG( "DataParallelTrainer::trainEpoch", shard.size( ) );
+
+        const size_t rank         = allreduce.getTransport( ).getRank( );
+        const size_t size         = allreduce.getTransport( ).getSize( );
+        const size_t maxBatchSize = network.maxBatchSize;
+        const size_t outCount     = network.getOutputCount( );
+
+        // everyone runs as many steps as the biggest shard needs, the others join in with empty batches
+        Result                  result;
+        std::vector<Core::real> stepCounts( size, Core::real( 0 ) );
+        stepCounts[ rank ] = Core::real( (shard.size( ) + maxBatchSize - 1) / maxBatchSize );
+        if( !allreduce.sum( size, stepCounts.data( ) ) ) {
+            return result;
+        }
+        const auto steps = size_t( *std::max_element( stepCounts.begin( ), stepCounts.end( ) ) );
+
+        auto       stage = network.newBatchStage( );
+        Core::real err = Core::real( 0 );
+        for( size_t step = 0; step < steps; ++step ) {
+            CORE_TRACE_SCOPE_ARG( "DataParallelTrainer.step", step );
+            const size_t first     = std::min( step * maxBatchSize, shard.size( ) );
+            const size_t batchSize = std::min( maxBatchSize, shard.size( ) - first );
+
+            if( batchSize > 0 ) {
+                err += network.runBatch( stage, shard, first, batchSize, true );
+            } else if( config.overlap ) {
+                // nothing back propagated so nothing is done yet, our gradients are still zero from the last update
+                for( size_t c = 0; c < bucketOf.size( ); ++c ) { connectionDone( c ); }
+            }
+
+            bool ok = true;
+            if( config.overlap ) {
+                ok = waitForBuckets( );
+            } else {
+                for( auto &&bucket : buckets ) {
+                    ok = ok && allreduce.sum( bucket.weightCount, network.gradients + bucket.weightIndex );
+                }
+            }
+
+            // the update averages the summed gradients over every ranks samples
+            Core::real count = Core::real( batchSize );
+            if( !ok || !allreduce.sum( 1, &count ) ) {
+                return result;
+            }
+            network.gradientSampleCount = size_t( count );
+            network.updateWeights( );
+            result.samples += size_t( count );
+        }
+        result.steps = steps;
+
+        Core::real totalErr = err;
+        if( !allreduce.sum( 1, &totalErr ) ) {
+            return result;
+        }
+        if( result.samples > 0 ) {
+            result.rms = std::sqrt( totalErr / Core::real( result.samples * outCount ) );
+        }
+        result.ok = true;
+        return result;
+    }
+
+    std::vector<ANNetwork::MatchingPair> DataParallelTrainer::shard( const std::vector<ANNetwork::MatchingPair> &set,
+                                                                     const size_t rank, const size_t size,
+                                                                     const size_t batchSize ) {
+        assert( rank < size && batchSize > 0 );
+
+        std::vector<ANNetwork::MatchingPair> mine;
+        for( size_t first = rank * batchSize; first < set.size( ); first += size * batchSize ) {
+            for( size_t i = first; i < std::min( first + batchSize, set.size( ) ); ++i ) { mine.push_back( set[ i ] ); }
+        }
+        return mine;
+    }
+}
@@ -0,0 +1,96 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/core.h"
+#include "core/ringallreduce.h"
+#include "machinelearning/ANNetwork.h"
+
+namespace MachineLearning {
+
+    /*
+     * Synchronous data parallel SGD across processes. Every rank has an identical ANNetwork replica and its own shard
+     * of the data, each step back propagates up to maxBatchSize local samples and the gradient sums are allreduced
+     * over the ring before every rank applies the same update, so one step is exactly one global batch of
+     * maxBatchSize * size samples. Gradients go in buckets of roughly bucketBytes, whole connections last first,
+     * handed to a communication thread as back propagation finishes them so the allreduce of the later layers
+     * overlaps the back propagation of the earlier ones. Buckets are always reduced in the same order, so ranks
+     * agree whatever order a DAG network or its thread pool finishes the connections in. Replicas stay bit identical, the allreduce hands everyone
+     * the same sums. The network must have been finalised for training with the same topology on every rank.
+     */
+    class DataParallelTrainer {
+    public:
+        struct Config {
+            size_t bucketBytes = size_t( 256 ) << 10;
+            bool   overlap     = true; // allreduce buckets during back propagation, else all after it
+        };
+
+        struct Result {
+            size_t     steps   = 0;
+            size_t     samples = 0;                 // across every rank
+            Core::real rms     = Core::real( 0 );   // training RMS across every rank
+            bool       ok      = false;             // false if the transport failed, the replicas may then differ
+        };
+
+        DataParallelTrainer( ANNetwork &network, Core::RingTransport &transport, const Config &config );
+
+        ~DataParallelTrainer();
+
+        DataParallelTrainer( const DataParallelTrainer & ) = delete;
+
+        DataParallelTrainer &operator=( const DataParallelTrainer & ) = delete;
+
+        // every rank takes rank 0s weights, call once before training
+        bool broadcastWeights();
+
+        // one pass over every ranks shard, shards may differ in size by any amount
+        Result trainEpoch( const std::vector<ANNetwork::MatchingPair> &shard );
+
+        size_t getBucketCount() const { return buckets.size( ); }
+
+        // rank's share of set, global batch b of batchSize * size samples gives rank r its r th slice, so an epoch
+        // with the network's batch size matches a single process epoch with batches of batchSize * size
+        static std::vector<ANNetwork::MatchingPair> shard( const std::vector<ANNetwork::MatchingPair> &set,
+                                                           const size_t rank, const size_t size,
+                                                           const size_t batchSize );
+
+    private:
+        // a contiguous weight range covering connections [ firstConnection, lastConnection ]
+        struct Bucket {
+            size_t firstConnection;
+            size_t lastConnection;
+            size_t weightIndex;
+            size_t weightCount;
+        };
+
+        // counts a connections gradients as final, wakes the communication thread when it completes the next bucket
+        void connectionDone( const size_t connection );
+
+        void communicationLoop();
+
+        // blocks until every bucket of the step has been reduced, false if any failed
+        bool waitForBuckets();
+
+        ANNetwork           &network;
+        Core::RingAllreduce allreduce;
+        const Config        config;
+
+        std::vector<Bucket> buckets;         // in back propagation order, last connection first
+        std::vector<size_t> bucketOf;        // per connection
+
+        std::thread             communication;
+        std::mutex              mutex;
+        std::condition_variable wake;        // a bucket completed or stopping
+        std::condition_variable done;        // a bucket finished
+        std::vector<size_t>     remaining;   // under mutex, per bucket the connections still back propagating
+        size_t                  finished;    // under mutex, buckets reduced this step, also the next to reduce
+        bool                    failed;      // under mutex
+        bool                    stopping;    // under mutex
+    };
+}
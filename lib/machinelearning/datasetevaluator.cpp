@@ -0,0 +1,150 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "core/reduction.h"
+#include "core/trace.h"
+#include "machinelearning/datasetevaluator.h"
+
+namespace MachineLearning {
+
+    namespace {
+        // samples per partial sum, fixed so the combining order doesn't depend on the thread count
+        constexpr size_t batchesPerChunk = 8;
+
+        // std::max drops a NaN that arrives second, this keeps it
+        Core::real maxKeepingNaN( const Core::real a, const Core::real b ) {
+            return (std::isnan( b ) || b > a) ? b : a;
+        }
+    }
+
+    struct DatasetEvaluator::Partial {
+        Core::NeumaierSum   squares;
+        Core::NeumaierSum   absolutes;
+        Core::real          maxAbs    = Core::real( 0 );
+        size_t              nonFinite = 0;
+        std::vector<size_t> histogram;
+    };
+
+    DatasetEvaluator::DatasetEvaluator( const Config &_config ) :
+            config( _config ) {
+        assert( config.batchSize > 0 );
+        assert( config.histogramBins >= 3 );
+        assert( config.histogramMin > Core::real( 0 ) && config.histogramMax > config.histogramMin );
+
+        logMin     = std::log( config.histogramMin );
+        binsPerLog = Core::real( config.histogramBins - 2 ) / (std::log( config.histogramMax ) - logMin);
+
+        const size_t threads = (config.threadCount == 0) ? std::max( 1u, std::thread::hardware_concurrency( ) )
+                                                         : config.threadCount;
+        if( threads > 1 ) {
+            pool.reset( new Core::ThreadPool( threads ) );
+        }
+        for( size_t t = 0; t < threads; ++t ) {
+            sessions.emplace_back( new InferenceSession( config.batchSize ) );
+        }
+    }
+
+    DatasetEvaluator::~DatasetEvaluator() = default;
+
+    size_t DatasetEvaluator::histogramBin( const Core::real error ) const {
+        if( error < config.histogramMin ) {
+            return 0;
+        }
+        // written so NaN fails the comparison too, it and infinity can't go through the log
+        if( !(error < config.histogramMax) ) {
+            return config.histogramBins - 1;
+        }
+        const auto bin = size_t( (std::log( error ) - logMin) * binsPerLog ) + 1;
+        return std::min( bin, config.histogramBins - 2 );
+    }
+
+    void DatasetEvaluator::evaluateChunks( const Model &model, const std::vector<ANNetwork::MatchingPair> &set,
+                                           const size_t firstChunk, const size_t lastChunk,
+                                           InferenceSession &session, std::vector<Partial> &partials ) const {
+        auto alu = Core::VectorALUFactory( );
+
+        const size_t            inCount  = model.getInputCount( );
+        const size_t            outCount = model.getOutputCount( );
+        std::vector<Core::real> inputs( config.batchSize * inCount ), results( config.batchSize * outCount );
+
+        for( size_t chunk = firstChunk; chunk < lastChunk; ++chunk ) {
+            Partial &partial = partials[ chunk ];
+            partial.histogram.assign( config.histogramBins, 0 );
+
+            const size_t chunkEnd = std::min( (chunk + 1) * batchesPerChunk * config.batchSize, set.size( ) );
+            for( size_t first = chunk * batchesPerChunk * config.batchSize; first < chunkEnd;
+                 first += config.batchSize ) {
+                const size_t batchSize = std::min( config.batchSize, chunkEnd - first );
+                for( size_t b = 0; b < batchSize; ++b ) {
+                    alu->copy( inCount, set[ first + b ].first, inputs.data( ) + (b * inCount) );
+                }
+                session.evaluate( model, batchSize, inputs.data( ), results.data( ) );
+
+                // every metric in the one pass over the batch while it's still in cache
+                for( size_t b = 0; b < batchSize; ++b ) {
+                    const Core::real *actual  = results.data( ) + (b * outCount);
+                    const Core::real *perfect = set[ first + b ].second;
+                    for( size_t o = 0; o < outCount; ++o ) {
+                        const Core::real e = std::fabs( actual[ o ] - perfect[ o ] );
+                        partial.squares.add( e * e );
+                        partial.absolutes.add( e );
+                        partial.maxAbs = maxKeepingNaN( partial.maxAbs, e );
+                        if( !std::isfinite( e ) ) { ++partial.nonFinite; }
+                        ++partial.histogram[ histogramBin( e ) ];
+                    }
+                }
+            }
+        }
+    }
+
+    ErrorSummary DatasetEvaluator::evaluate( const Model &model, const std::vector<ANNetwork::MatchingPair> &set ) {
+        CORE_TRACE_SCOPE_ARG( "DatasetEvaluator::evaluate", set.size( ) );
+
+        const size_t         chunkSamples = batchesPerChunk * config.batchSize;
+        const size_t         chunkCount   = (set.size( ) + chunkSamples - 1) / chunkSamples;
+        std::vector<Partial> partials( chunkCount );
+
+        // contiguous runs of chunks per thread, each with its own session
+        const size_t tasks = std::max( size_t( 1 ), std::min( sessions.size( ), chunkCount ) );
+        if( !pool || tasks == 1 ) {
+            evaluateChunks( model, set, 0, chunkCount, *sessions[ 0 ], partials );
+        } else {
+            const size_t perTask = (chunkCount + tasks - 1) / tasks;
+            for( size_t t = 0; t * perTask < chunkCount; ++t ) {
+                const size_t first = t * perTask, last = std::min( first + perTask, chunkCount );
+                pool->submit( [ this, &model, &set, &partials, first, last, t ]() {
+                    evaluateChunks( model, set, first, last, *sessions[ t ], partials );
+                } );
+            }
+            pool->wait( );
+        }
+
+        ErrorSummary summary;
+        summary.sampleCount = set.size( );
+        summary.valueCount  = set.size( ) * model.getOutputCount( );
+        summary.histogram.assign( config.histogramBins, 0 );
+        for( size_t b = 1; b < config.histogramBins; ++b ) {
+            summary.histogramEdges.push_back(
+                    Core::real( std::exp( logMin + (Core::real( b - 1 ) / binsPerLog) ) ) );
+        }
+
+        Core::NeumaierSum squares, absolutes;
+        for( auto &&partial : partials ) {
+            squares.add( partial.squares );
+            absolutes.add( partial.absolutes );
+            summary.maxAbs = maxKeepingNaN( summary.maxAbs, partial.maxAbs );
+            summary.nonFinite += partial.nonFinite;
+            for( size_t b = 0; b < config.histogramBins; ++b ) { summary.histogram[ b ] += partial.histogram[ b ]; }
+        }
+        if( summary.valueCount > 0 ) {
+            summary.rms = std::sqrt( squares.result( ) / Core::real( summary.valueCount ) );
+            summary.mae = absolutes.result( ) / Core::real( summary.valueCount );
+        }
+        return summary;
+    }
+}
@@ -0,0 +1,76 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "core/core.h"
+#include "core/threadpool.h"
+#include "machinelearning/ANNetwork.h"
+#include "machinelearning/model.h"
+
+namespace MachineLearning {
+
+    // per output value error statistics over a whole data set
+    struct ErrorSummary {
+        size_t     sampleCount = 0;
+        size_t     valueCount  = 0; // samples * outputs, what the means are over
+        Core::real rms         = Core::real( 0 );
+        Core::real mae         = Core::real( 0 );
+        Core::real maxAbs      = Core::real( 0 ); // NaN if any error was, else infinite if any was
+        size_t     nonFinite   = 0;               // NaN or infinite errors, the rms and mae can't be trusted with any
+
+        // histogram[ b ] counts | error | in [ histogramEdges[ b - 1 ], histogramEdges[ b ] ), the first bin starts
+        // at 0 and the last has no upper edge and holds the non finite errors too
+        std::vector<size_t>     histogram;
+        std::vector<Core::real> histogramEdges;
+    };
+
+    /*
+     * Batched inference over a whole data set on a thread pool with the error metrics reduced as each batch comes
+     * out, only one batch of outputs per thread ever exists. The set is cut into fixed chunks whose partial sums are
+     * combined in chunk order with compensation, so the summary is the same whatever the thread count.
+     * The evaluator keeps its pool and sessions between calls, so validating every epoch costs just the inference.
+     * One evaluate at a time.
+     */
+    class DatasetEvaluator {
+    public:
+        struct Config {
+            size_t     threadCount   = 0;  // 0 is every hardware thread
+            size_t     batchSize     = 64;
+            size_t     histogramBins = 16; // geometric between histogramMin and histogramMax plus the two open ends
+            Core::real histogramMin  = Core::real( 1e-6 );
+            Core::real histogramMax  = Core::real( 1 );
+        };
+
+        explicit DatasetEvaluator( const Config &config );
+
+        ~DatasetEvaluator();
+
+        DatasetEvaluator( const DatasetEvaluator & ) = delete;
+
+        DatasetEvaluator &operator=( const DatasetEvaluator & ) = delete;
+
+        ErrorSummary evaluate( const Model &model, const std::vector<ANNetwork::MatchingPair> &set );
+
+        const Config &getConfig() const { return config; }
+
+    private:
+        struct Partial;
+
+        void evaluateChunks( const Model &model, const std::vector<ANNetwork::MatchingPair> &set,
+                             const size_t firstChunk, const size_t lastChunk, InferenceSession &session,
+                             std::vector<Partial> &partials ) const;
+
+        size_t histogramBin( const Core::real error ) const;
+
+        const Config config;
+        Core::real   logMin;
+        Core::real   binsPerLog; // interior bins per unit of log( error )
+
+        std::unique_ptr<Core::ThreadPool>              pool; // none for a single thread
+        std::vector<std::unique_ptr<InferenceSession>> sessions;
+    };
+}
@@ -0,0 +1,217 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include "core/core.h"
+#include "core/random.h"
+#include "core/trace.h"
+#include "machinelearning/machinelearning.h"
+#include "machinelearning/ensemblenetwork.h"
+
+namespace MachineLearning {
+
+    EnsembleNetwork::EnsembleNetwork( const ANNetwork &prototype, const size_t _memberCount ) :
+            memberCount( _memberCount ),
+            gradientSampleCount( 0 ) {
+        assert( memberCount > 0 );
+
+        // the model is just a convenient flat description of the topology
+        const auto model = prototype.createModel( );
+        assert( model->isChain( ) );
+        inputCount        = model->getInputCount( );
+        inputNeuronIndex  = model->getInputNeuronIndex( );
+        outputCount       = model->getOutputCount( );
+        outputNeuronIndex = model->getOutputNeuronIndex( );
+        totalNeuronCount  = model->getTotalNeuronCount( );
+        totalWeightCount  = model->getTotalWeightCount( );
+        steps             = model->getSteps( );
+
+        for( auto &&step : steps ) {
+            auto producer = std::find_if( steps.begin( ), steps.end( ), [ &step ]( const Model::Step &other ) {
+                return other.dstNeuronIndex == step.srcNeuronIndex;
+            } );
+            srcStep.push_back( (producer != steps.end( )) ? int( producer - steps.begin( ) ) : -1 );
+        }
+
+        auto alu = Core::VectorALUFactory( );
+        weights     = alu->newRealVector( totalWeightCount * memberCount );
+        gradients   = alu->newRealVector( totalWeightCount * memberCount );
+        velocity    = alu->newRealVector( totalWeightCount * memberCount );
+        activations = alu->newRealVector( totalNeuronCount * memberCount );
+        sums        = alu->newRealVector( totalNeuronCount * memberCount );
+        deltas      = alu->newRealVector( totalNeuronCount * memberCount );
+        alu->set( totalWeightCount * memberCount, Core::real( 0 ), gradients );
+        alu->set( totalWeightCount * memberCount, Core::real( 0 ), velocity );
+        alu->set( totalNeuronCount * memberCount, Core::real( 0 ), activations );
+        alu->set( totalNeuronCount * memberCount, Core::real( 0 ), sums );
+        alu->set( totalNeuronCount * memberCount, Core::real( 0 ), deltas );
+
+        const auto protoWeights = prototype.getWeights( );
+        for( size_t m = 0; m < memberCount; ++m ) {
+            setMemberWeights( m, protoWeights );
+        }
+        learningRates.assign( memberCount, prototype.getLearningRate( ) );
+        momentums.assign( memberCount, prototype.getMomentum( ) );
+    }
+
+    EnsembleNetwork::~EnsembleNetwork() {
+        auto alu = Core::VectorALUFactory( );
+        alu->deleteRealVector( weights );
+        alu->deleteRealVector( gradients );
+        alu->deleteRealVector( velocity );
+        alu->deleteRealVector( activations );
+        alu->deleteRealVector( sums );
+        alu->deleteRealVector( deltas );
+    }
+
+    void EnsembleNetwork::setRandomWeights() {
+        auto stream = Core::Random::newStream( );
+        setRandomWeights( stream );
+    }
+
+    void EnsembleNetwork::setRandomWeights( Core::RandomStream &stream ) {
+        // same range as ANNetwork, generated member by member in the public ordering
+        std::vector<Core::real> in( totalWeightCount );
+        for( size_t m = 0; m < memberCount; ++m ) {
+            stream.fillUniform( totalWeightCount, Core::real( -10.0 ), Core::real( 10.0 ), in.data( ) );
+            setMemberWeights( m, in );
+        }
+    }
+
+    void EnsembleNetwork::setMemberWeights( const size_t member, const std::vector<Core::real> &in ) {
+        assert( member < memberCount );
+        assert( in.size( ) == totalWeightCount );
+
+        auto alu = Core::VectorALUFactory( );
+        alu->scatter( totalWeightCount, in.data( ), memberCount, weights + member );
+    }
+
+    std::vector<Core::real> EnsembleNetwork::getMemberWeights( const size_t member ) const {
+        assert( member < memberCount );
+
+        auto                    alu = Core::VectorALUFactory( );
+        std::vector<Core::real> out( totalWeightCount );
+        alu->gather( totalWeightCount, weights + member, memberCount, out.data( ) );
+        return out;
+    }
+
+    void EnsembleNetwork::setLearningRate( const size_t member, const Core::real learningRate ) {
+        assert( member < memberCount );
+        learningRates[ member ] = learningRate;
+    }
+
+    void EnsembleNetwork::setMomentum( const size_t member, const Core::real momentum ) {
+        assert( member < memberCount );
+        momentums[ member ] = momentum;
+    }
+
+    void EnsembleNetwork::evaluate( Core::VectorALU::const_real_array_ptr input,
+                                    Core::VectorALU::real_array_ptr results ) {
+        CORE_TRACE_SCOPE_ARG( "EnsembleNetwork::evaluate", memberCount );
+        auto alu = Core::VectorALUFactory( );
+
+        // broadcast the shared input across the lanes
+        alu->replicateItems( inputCount, memberCount, input, activations + (inputNeuronIndex * memberCount) );
+
+        for( auto &&step : steps ) {
+            alu->laneDenseActivate( memberCount, step.dstNeuronCount, step.srcNeuronCount,
+                                    activations + (step.srcNeuronIndex * memberCount),
+                                    weights + (step.weightIndex * memberCount),
+                                    step.activation, step.param0, step.param1,
+                                    sums + (step.dstNeuronIndex * memberCount),
+                                    activations + (step.dstNeuronIndex * memberCount) );
+        }
+
+        if( results != nullptr ) {
+            for( size_t m = 0; m < memberCount; ++m ) {
+                alu->gather( outputCount, activations + (outputNeuronIndex * memberCount) + m, memberCount,
+                             results + (m * outputCount) );
+            }
+        }
+    }
+
+    void EnsembleNetwork::computeGradients( Core::VectorALU::const_real_array_ptr perfect ) {
+        CORE_TRACE_SCOPE_ARG( "EnsembleNetwork::computeGradients", memberCount );
+        auto alu = Core::VectorALUFactory( );
+
+        // output delta = (output - perfect) * f'(sum), perfect is shared so it is broadcast like the input
+        {
+            const auto &oStep = steps.back( );
+            assert( oStep.dstNeuronIndex == outputNeuronIndex );
+            const auto  row   = outputNeuronIndex * memberCount;
+            const auto  count = outputCount * memberCount;
+
+            alu->replicateItems( outputCount, memberCount, perfect, deltas + row );
+            for( size_t i = 0; i < count; ++i ) {
+                deltas[ row + i ] = activations[ row + i ] - deltas[ row + i ];
+            }
+            alu->mulActivationDerivative( count, oStep.activation, oStep.param0, sums + row, deltas + row );
+        }
+
+        for( size_t i = steps.size( ) - 1; i < steps.size( ); i-- ) {
+            const auto &step = steps[ i ];
+            alu->laneOuterAccumulate( memberCount, step.srcNeuronCount, step.dstNeuronCount,
+                                      activations + (step.srcNeuronIndex * memberCount),
+                                      deltas + (step.dstNeuronIndex * memberCount),
+                                      gradients + (step.weightIndex * memberCount) );
+
+            if( srcStep[ i ] < 0 ) {
+                continue;
+            }
+
+            // src deltas = W * dst deltas . f'(src sums), using the activation of the step that produced them
+            const auto &producer = steps[ srcStep[ i ] ];
+            const auto srcRow    = step.srcNeuronIndex * memberCount;
+            alu->laneTransposedProduct( memberCount, step.srcNeuronCount, step.dstNeuronCount,
+                                        weights + (step.weightIndex * memberCount),
+                                        deltas + (step.dstNeuronIndex * memberCount), deltas + srcRow );
+            alu->mulActivationDerivative( (step.srcNeuronCount - 1) * memberCount, producer.activation,
+                                          producer.param0, sums + srcRow, deltas + srcRow );
+        }
+
+        gradientSampleCount++;
+    }
+
+    void EnsembleNetwork::updateWeights() {
+        if( gradientSampleCount == 0 ) {
+            return;
+        }
+        CORE_TRACE_SCOPE( "EnsembleNetwork::updateWeights" );
+
+        auto alu = Core::VectorALUFactory( );
+        alu->laneMomentumStep( memberCount, totalWeightCount, learningRates.data( ), momentums.data( ),
+                               Core::real( 1 ) / Core::real( gradientSampleCount ), weights, gradients, velocity );
+        gradientSampleCount = 0;
+    }
+
+    std::vector<Core::real> EnsembleNetwork::supervisedTrain( const std::vector<ANNetwork::MatchingPair> &trainingSet,
+                                                              const size_t batchSize ) {
+        assert( trainingSet.size( ) > 0 );
+        assert( batchSize > 0 );
+
+        auto                    alu = Core::VectorALUFactory( );
+        std::vector<Core::real> results( memberCount * outputCount );
+        std::vector<Core::real> err( memberCount, Core::real( 0 ) );
+
+        for( size_t first = 0; first < trainingSet.size( ); first += batchSize ) {
+            const auto last = std::min( first + batchSize, trainingSet.size( ) );
+            for( size_t s = first; s < last; ++s ) {
+                evaluate( trainingSet[ s ].first, results.data( ) );
+                computeGradients( trainingSet[ s ].second );
+
+                for( size_t m = 0; m < memberCount; ++m ) {
+                    Core::VectorALU::const_real_array_ptr actual = results.data( ) + (m * outputCount);
+                    err[ m ] += SumOfSquare( *alu, outputCount, trainingSet[ s ].second, actual );
+                }
+            }
+            updateWeights( );
+        }
+
+        for( auto &&e : err ) {
+            e = std::sqrt( e / Core::real( trainingSet.size( ) * outputCount ) );
+        }
+        return err;
+    }
+}
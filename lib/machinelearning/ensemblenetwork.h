@@ -0,0 +1,94 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <vector>
+#include "core/core.h"
+#include "core/randomstream.h"
+#include "core/vectoralu.h"
+#include "machinelearning/ANNetwork.h"
+#include "machinelearning/model.h"
+
+namespace MachineLearning {
+
+    /*
+     * N networks of identical topology stored structure of arrays, lane i of every weight, activation and delta is
+     * member i. Tiny networks (1-8-1 etc.) can't fill a vector register on their own, across the members every
+     * kernel loop is full width, so a sweep or ensemble evaluates and trains all of them for roughly the cost of one.
+     * Each member has its own learning rate and momentum so a hyperparameter sweep can share the lock step.
+     */
+    class EnsembleNetwork {
+    public:
+        // topology, weights and hyperparameters come from a finalised prototype, every member starts as a copy.
+        // the prototype must be a plain layer chain
+        EnsembleNetwork( const ANNetwork &prototype, const size_t _memberCount );
+
+        ~EnsembleNetwork();
+
+        EnsembleNetwork( const EnsembleNetwork & ) = delete;
+
+        EnsembleNetwork &operator=( const EnsembleNetwork & ) = delete;
+
+        size_t getMemberCount() const { return memberCount; }
+
+        size_t getInputCount() const { return inputCount; }
+
+        size_t getOutputCount() const { return outputCount; }
+
+        size_t getTotalWeightCount() const { return totalWeightCount; }
+
+        // a different random set for every member
+        void setRandomWeights();
+
+        void setRandomWeights( Core::RandomStream &stream );
+
+        // exchanged in the ANNetwork public ordering, so members round trip with ordinary networks
+        void setMemberWeights( const size_t member, const std::vector<Core::real> &in );
+
+        std::vector<Core::real> getMemberWeights( const size_t member ) const;
+
+        void setLearningRate( const size_t member, const Core::real learningRate );
+
+        void setMomentum( const size_t member, const Core::real momentum );
+
+        // every member sees the same input, results are member major (member i's outputs at i * outputCount)
+        void evaluate( Core::VectorALU::const_real_array_ptr input, Core::VectorALU::real_array_ptr results );
+
+        // back propagate against the perfect answer for the last evaluate, accumulating every members gradients
+        void computeGradients( Core::VectorALU::const_real_array_ptr perfect );
+
+        // momentum step for every member with its own hyperparameters, averaged over the accumulated samples
+        void updateWeights();
+
+        // one pass over the training set in mini batches, returns each members training RMS
+        std::vector<Core::real> supervisedTrain( const std::vector<ANNetwork::MatchingPair> &trainingSet,
+                                                 const size_t batchSize );
+
+    private:
+        const size_t memberCount;
+
+        size_t inputCount;
+        size_t inputNeuronIndex;
+        size_t outputCount;
+        size_t outputNeuronIndex;
+        size_t totalNeuronCount;
+        size_t totalWeightCount;
+
+        std::vector<Model::Step> steps;
+        std::vector<int>         srcStep; // the step producing each steps source neurons, -1 for the input layer
+
+        // all lane interleaved, [ element * memberCount + member ]
+        Core::VectorALU::real_array_ptr weights;
+        Core::VectorALU::real_array_ptr gradients;
+        Core::VectorALU::real_array_ptr velocity;
+        Core::VectorALU::real_array_ptr activations;
+        Core::VectorALU::real_array_ptr sums;
+        Core::VectorALU::real_array_ptr deltas;
+
+        std::vector<Core::real> learningRates;
+        std::vector<Core::real> momentums;
+        size_t                  gradientSampleCount;
+    };
+}
@@ -0,0 +1,405 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <cassert>
+#include "core/core.h"
+#include "core/reduction.h"
+#include "core/trace.h"
+#include "machinelearning/gradienttape.h"
+
+namespace MachineLearning {
+
+    GradientTape::GradientTape( const size_t _maxBatchSize ) :
+            maxBatchSize( _maxBatchSize ),
+            batchSize( 0 ),
+            panelWidth( Core::VectorALUFactory( )->preferredPanelWidth( ) ),
+            arena( nullptr ),
+            arenaSize( 0 ),
+            parameterGradientBegin( 0 ),
+            parameterGradientEnd( 0 ),
+            adjointEnd( 0 ) {
+        assert( maxBatchSize > 0 );
+    }
+
+    GradientTape::~GradientTape() {
+        if( arena != nullptr ) {
+            Core::VectorALUFactory( )->deleteRealVector( arena );
+        }
+    }
+
+    GradientTape::Var GradientTape::addVar( const size_t rows, const size_t cols, const size_t stride,
+                                            const bool batched, const bool isParameter,
+                                            const bool requiresGradient ) {
+        assert( arena == nullptr );
+        vars.push_back( VarInfo{ rows, cols, stride, batched, isParameter, requiresGradient, 0, 0 } );
+        return Var{ vars.size( ) - 1 };
+    }
+
+    GradientTape::Var GradientTape::input( const size_t cols ) {
+        return addVar( maxBatchSize, cols, cols + 1, true, false, false );
+    }
+
+    GradientTape::Var GradientTape::parameter( const size_t count ) {
+        return addVar( 1, count, count, false, true, true );
+    }
+
+    GradientTape::Var GradientTape::dense( const Var x, const Var weights, const size_t n,
+                                           const Core::ActivationKernel act, const Core::real param0,
+                                           const Core::real param1 ) {
+        const auto &xi = vars[ x.index ];
+        const auto &wi = vars[ weights.index ];
+        assert( xi.batched );
+        assert( !wi.batched );
+        assert( wi.cols == (xi.cols + 1) * n );
+
+        const bool requiresGradient = xi.requiresGradient || wi.requiresGradient;
+        const Var  out              = addVar( maxBatchSize, n, n + 1, true, false, requiresGradient );
+        ops.push_back( Op{ OpType::Dense, act, param0, param1, x.index, weights.index, out.index, 0, 0, 0 } );
+        return out;
+    }
+
+    GradientTape::Var GradientTape::convolution( const Var x, const Var weights, const Convolution &geometry,
+                                                 const Core::ActivationKernel act, const Core::real param0,
+                                                 const Core::real param1 ) {
+        const auto &xi = vars[ x.index ];
+        const auto &wi = vars[ weights.index ];
+        assert( xi.batched );
+        assert( xi.cols == geometry.getInputSize( ) );
+        assert( !wi.batched );
+        assert( wi.cols == geometry.getWeightCount( ) );
+
+        const bool requiresGradient = xi.requiresGradient || wi.requiresGradient;
+        const auto n                = geometry.getOutputSize( );
+        const Var  out              = addVar( maxBatchSize, n, n + 1, true, false, requiresGradient );
+        convolutions.push_back( geometry );
+        ops.push_back( Op{ OpType::Convolution, act, param0, param1, x.index, weights.index, out.index, 0,
+                           convolutions.size( ) - 1, 0 } );
+        return out;
+    }
+
+    GradientTape::Var GradientTape::activate( const Var x, const Core::ActivationKernel act,
+                                              const Core::real param0, const Core::real param1 ) {
+        const auto xi  = vars[ x.index ];
+        const Var  out = addVar( xi.rows, xi.cols, xi.stride, xi.batched, false, xi.requiresGradient );
+        ops.push_back( Op{ OpType::Activate, act, param0, param1, x.index, x.index, out.index, 0, 0, 0 } );
+        return out;
+    }
+
+    GradientTape::Var GradientTape::elementwise( const OpType type, const Var a, const Var b ) {
+        const auto ai  = vars[ a.index ];
+        const auto &bi = vars[ b.index ];
+        assert( ai.cols == bi.cols && ai.batched == bi.batched && ai.rows == bi.rows );
+
+        const Var out = addVar( ai.rows, ai.cols, ai.stride, ai.batched, false,
+                                ai.requiresGradient || bi.requiresGradient );
+        ops.push_back( Op{ type, Core::ActivationKernel::Identity, Core::real( 0 ), Core::real( 0 ),
+                           a.index, b.index, out.index, 0, 0, 0 } );
+        return out;
+    }
+
+    GradientTape::Var GradientTape::add( const Var a, const Var b ) {
+        return elementwise( OpType::Add, a, b );
+    }
+
+    GradientTape::Var GradientTape::sub( const Var a, const Var b ) {
+        return elementwise( OpType::Sub, a, b );
+    }
+
+    GradientTape::Var GradientTape::mul( const Var a, const Var b ) {
+        return elementwise( OpType::Mul, a, b );
+    }
+
+    GradientTape::Var GradientTape::sumSquaredError( const Var y, const Var target ) {
+        const auto &yi = vars[ y.index ];
+        const auto &ti = vars[ target.index ];
+        assert( yi.cols == ti.cols && yi.batched == ti.batched && yi.stride == ti.stride );
+
+        const Var out = addVar( 1, 1, 1, false, false, yi.requiresGradient || ti.requiresGradient );
+        ops.push_back( Op{ OpType::SumSquaredError, Core::ActivationKernel::Identity, Core::real( 0 ),
+                           Core::real( 0 ), y.index, target.index, out.index, 0, 0, 0 } );
+        return out;
+    }
+
+    void GradientTape::finalise() {
+        assert( arena == nullptr );
+        auto alu = Core::VectorALUFactory( );
+
+        size_t offset = 0;
+        for( auto &&v : vars ) {
+            v.valueOffset = offset;
+            offset += v.rows * v.stride;
+        }
+
+        // parameter gradients persist across backward calls, the intermediates after them are cleared each time
+        parameterGradientBegin = offset;
+        for( auto &&v : vars ) {
+            if( v.isParameter ) {
+                v.gradientOffset = offset;
+                offset += v.rows * v.stride;
+            }
+        }
+        parameterGradientEnd = offset;
+        for( auto &&v : vars ) {
+            if( v.requiresGradient && !v.isParameter ) {
+                v.gradientOffset = offset;
+                offset += v.rows * v.stride;
+            }
+        }
+        adjointEnd = offset;
+
+        for( auto &&op : ops ) {
+            if( op.type == OpType::Dense || op.type == OpType::Convolution ) {
+                op.sumsOffset = offset;
+                offset += maxBatchSize * vars[ op.out ].cols;
+            }
+            if( op.type == OpType::Convolution ) {
+                const auto &geometry = convolutions[ op.geometry ];
+                op.colsOffset = offset;
+                offset += (maxBatchSize + 1) * geometry.getPositionCount( ) * (geometry.getPatchSize( ) + 1);
+            }
+        }
+
+        arenaSize = offset;
+        arena     = alu->newRealVector( arenaSize );
+        alu->set( arenaSize, Core::real( 0 ), arena );
+
+        // the bias slots hold 1 for good, no op ever writes past a rows cols
+        for( auto &&v : vars ) {
+            if( v.stride != v.cols ) {
+                for( size_t r = 0; r < v.rows; ++r ) {
+                    arena[ v.valueOffset + (r * v.stride) + v.cols ] = Core::real( 1 );
+                }
+            }
+        }
+        for( auto &&op : ops ) {
+            if( op.type == OpType::Convolution ) {
+                const auto &geometry = convolutions[ op.geometry ];
+                const auto k         = geometry.getPatchSize( );
+                for( size_t r = 0; r < maxBatchSize * geometry.getPositionCount( ); ++r ) {
+                    arena[ op.colsOffset + (r * (k + 1)) + k ] = Core::real( 1 );
+                }
+            }
+        }
+    }
+
+    void GradientTape::forward( const size_t _batchSize ) {
+        CORE_TRACE_SCOPE_ARG( "GradientTape::forward", _batchSize );
+        assert( arena != nullptr );
+        assert( _batchSize > 0 && _batchSize <= maxBatchSize );
+        batchSize = _batchSize;
+
+        for( auto &&op : ops ) { forwardOp( op ); }
+    }
+
+    void GradientTape::backward( const Var loss ) {
+        CORE_TRACE_SCOPE( "GradientTape::backward" );
+        assert( batchSize > 0 );
+        assert( vars[ loss.index ].requiresGradient );
+        assert( vars[ loss.index ].rows == 1 && vars[ loss.index ].cols == 1 );
+
+        auto alu = Core::VectorALUFactory( );
+        alu->set( adjointEnd - parameterGradientEnd, Core::real( 0 ), arena + parameterGradientEnd );
+        grad( loss.index )[ 0 ] = Core::real( 1 );
+
+        for( size_t i = ops.size( ) - 1; i < ops.size( ); i-- ) {
+            if( vars[ ops[ i ].out ].requiresGradient ) {
+                backwardOp( ops[ i ] );
+            }
+        }
+    }
+
+    void GradientTape::zeroGradients() {
+        assert( arena != nullptr );
+        Core::VectorALUFactory( )->set( parameterGradientEnd - parameterGradientBegin, Core::real( 0 ),
+                                        arena + parameterGradientBegin );
+    }
+
+    Core::VectorALU::real_array_ptr GradientTape::value( const Var v ) {
+        assert( arena != nullptr );
+        return val( v.index );
+    }
+
+    const Core::real *GradientTape::gradient( const Var v ) const {
+        assert( arena != nullptr );
+        assert( vars[ v.index ].requiresGradient );
+        return arena + vars[ v.index ].gradientOffset;
+    }
+
+    void GradientTape::setRows( const Var v, const size_t rows, Core::VectorALU::const_real_array_ptr in ) {
+        const auto &vi = vars[ v.index ];
+        assert( rows <= vi.rows );
+        auto alu = Core::VectorALUFactory( );
+        for( size_t r = 0; r < rows; ++r ) {
+            alu->copy( vi.cols, in + (r * vi.cols), val( v.index ) + (r * vi.stride) );
+        }
+    }
+
+    void GradientTape::getRows( const Var v, const size_t rows, Core::VectorALU::real_array_ptr out ) const {
+        const auto &vi = vars[ v.index ];
+        assert( rows <= vi.rows );
+        auto alu = Core::VectorALUFactory( );
+        for( size_t r = 0; r < rows; ++r ) {
+            alu->copy( vi.cols, arena + vi.valueOffset + (r * vi.stride), out + (r * vi.cols) );
+        }
+    }
+
+    void GradientTape::forwardOp( const Op &op ) {
+        auto       alu  = Core::VectorALUFactory( );
+        const auto &ai  = vars[ op.a ];
+        const auto &oi  = vars[ op.out ];
+        const auto rows = rowsOf( oi );
+
+        switch( op.type ) {
+            case OpType::Dense:
+                alu->packedDenseActivate( rows, oi.cols, ai.cols + 1, val( op.a ), ai.stride, val( op.b ), panelWidth,
+                                          op.act, op.param0, op.param1, arena + op.sumsOffset, oi.cols,
+                                          val( op.out ), oi.stride );
+                break;
+            case OpType::Convolution: {
+                // each sample is its own little matrix multiply, the rows of a batch are not evenly spaced
+                const auto &geometry = convolutions[ op.geometry ];
+                const auto positions = geometry.getPositionCount( );
+                const auto channels  = geometry.getOutputChannels( );
+                const auto k         = geometry.getPatchSize( ) + 1;
+                for( size_t r = 0; r < rows; ++r ) {
+                    const auto cols = arena + op.colsOffset + (r * positions * k);
+                    geometry.im2col( val( op.a ) + (r * ai.stride), cols, k );
+                    alu->packedDenseActivate( positions, channels, k, cols, k, val( op.b ), panelWidth,
+                                              op.act, op.param0, op.param1, arena + op.sumsOffset + (r * oi.cols),
+                                              channels, val( op.out ) + (r * oi.stride), channels );
+                }
+            }
+                break;
+            case OpType::Activate:
+                for( size_t r = 0; r < rows; ++r ) {
+                    alu->activate( ai.cols, op.act, op.param0, op.param1, val( op.a ) + (r * ai.stride),
+                                   val( op.out ) + (r * oi.stride) );
+                }
+                break;
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+                // row by row so the bias slots are left alone
+                for( size_t r = 0; r < rows; ++r ) {
+                    const auto a = val( op.a ) + (r * ai.stride);
+                    const auto b = val( op.b ) + (r * ai.stride);
+                    const auto o = val( op.out ) + (r * oi.stride);
+                    if( op.type == OpType::Add ) {
+                        alu->add( ai.cols, a, b, o );
+                    } else if( op.type == OpType::Sub ) {
+                        alu->sub( ai.cols, a, b, o );
+                    } else {
+                        alu->mul( ai.cols, a, b, o );
+                    }
+                }
+                break;
+            case OpType::SumSquaredError: {
+                Core::NeumaierSum sum;
+                for( size_t r = 0; r < rowsOf( ai ); ++r ) {
+                    sum.add( Core::Reduction::sumSquaredDifference( ai.cols, val( op.a ) + (r * ai.stride),
+                                                                    val( op.b ) + (r * ai.stride) ) );
+                }
+                val( op.out )[ 0 ] = Core::real( 0.5 ) * sum.result( );
+            }
+                break;
+        }
+    }
+
+    void GradientTape::backwardOp( const Op &op ) {
+        auto       alu  = Core::VectorALUFactory( );
+        const auto &ai  = vars[ op.a ];
+        const auto &bi  = vars[ op.b ];
+        const auto &oi  = vars[ op.out ];
+        const auto rows = rowsOf( oi );
+
+        // adjoints of batched vars are updated as one span, the bias slots in between just collect junk nobody reads
+        const auto span = [ this ]( const VarInfo &v ) { return ((rowsOf( v ) - 1) * v.stride) + v.cols; };
+
+        switch( op.type ) {
+            case OpType::Dense: {
+                // delta = dy . act'( sums ), in place as this op is the only reader of its outputs adjoint
+                const auto delta = grad( op.out );
+                if( op.act != Core::ActivationKernel::Identity ) {
+                    for( size_t r = 0; r < rows; ++r ) {
+                        alu->mulActivationDerivative( oi.cols, op.act, op.param0, arena + op.sumsOffset + (r * oi.cols),
+                                                      delta + (r * oi.stride) );
+                    }
+                }
+                // dW += x^T * delta, the bias slot of x supplies the 1 for the bias row
+                if( bi.requiresGradient ) {
+                    alu->packedOuterAccumulate( rows, ai.cols + 1, oi.cols, val( op.a ), ai.stride, delta, oi.stride,
+                                                panelWidth, grad( op.b ) );
+                }
+                // dx += delta * W^T over the non bias rows
+                if( ai.requiresGradient ) {
+                    alu->packedGemmTransposed( rows, ai.cols, oi.cols, delta, oi.stride, val( op.b ), ai.cols + 1,
+                                               panelWidth, Core::real( 1 ), grad( op.a ), ai.stride );
+                }
+            }
+                break;
+            case OpType::Convolution: {
+                const auto &geometry = convolutions[ op.geometry ];
+                const auto positions = geometry.getPositionCount( );
+                const auto channels  = geometry.getOutputChannels( );
+                const auto k         = geometry.getPatchSize( ) + 1;
+                const auto patches   = arena + op.colsOffset + (maxBatchSize * positions * k);
+                for( size_t r = 0; r < rows; ++r ) {
+                    const auto delta = grad( op.out ) + (r * oi.stride);
+                    const auto cols  = arena + op.colsOffset + (r * positions * k);
+                    alu->mulActivationDerivative( oi.cols, op.act, op.param0, arena + op.sumsOffset + (r * oi.cols),
+                                                  delta );
+                    // shared weights, every position adds its patch^T * delta
+                    if( bi.requiresGradient ) {
+                        alu->packedOuterAccumulate( positions, k, channels, cols, k, delta, channels, panelWidth,
+                                                    grad( op.b ) );
+                    }
+                    // patch adjoints = delta * W^T, scattered back over the overlapping input elements
+                    if( ai.requiresGradient ) {
+                        alu->packedGemmTransposed( positions, k - 1, channels, delta, channels, val( op.b ), k,
+                                                   panelWidth, Core::real( 0 ), patches, k );
+                        geometry.col2imAccumulate( patches, k, grad( op.a ) + (r * ai.stride) );
+                    }
+                }
+            }
+                break;
+            case OpType::Activate:
+                if( ai.requiresGradient ) {
+                    alu->mulActivationDerivative( span( oi ), op.act, op.param0, val( op.a ), grad( op.out ) );
+                    alu->accumulate( span( oi ), grad( op.out ), Core::real( 1 ), grad( op.a ) );
+                }
+                break;
+            case OpType::Add:
+            case OpType::Sub:
+                if( ai.requiresGradient ) {
+                    alu->accumulate( span( oi ), grad( op.out ), Core::real( 1 ), grad( op.a ) );
+                }
+                if( bi.requiresGradient ) {
+                    alu->accumulate( span( oi ), grad( op.out ),
+                                     (op.type == OpType::Add) ? Core::real( 1 ) : Core::real( -1 ), grad( op.b ) );
+                }
+                break;
+            case OpType::Mul:
+                if( ai.requiresGradient ) {
+                    alu->accumulateProduct( span( oi ), grad( op.out ), val( op.b ), grad( op.a ) );
+                }
+                if( bi.requiresGradient ) {
+                    alu->accumulateProduct( span( oi ), grad( op.out ), val( op.a ), grad( op.b ) );
+                }
+                break;
+            case OpType::SumSquaredError: {
+                // d/dy = g ( y - target ), the bias slots cancel
+                const Core::real g = grad( op.out )[ 0 ];
+                if( ai.requiresGradient ) {
+                    alu->accumulate( span( ai ), val( op.a ), g, grad( op.a ) );
+                    alu->accumulate( span( ai ), val( op.b ), -g, grad( op.a ) );
+                }
+                if( bi.requiresGradient ) {
+                    alu->accumulate( span( bi ), val( op.b ), g, grad( op.b ) );
+                    alu->accumulate( span( bi ), val( op.a ), -g, grad( op.b ) );
+                }
+            }
+                break;
+        }
+    }
+}
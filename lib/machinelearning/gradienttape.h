@@ -0,0 +1,169 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <vector>
+#include "core/core.h"
+#include "core/vectoralu.h"
+#include "machinelearning/convolution.h"
+
+namespace MachineLearning {
+
+    /*
+     * Reverse mode automatic differentiation over VectorALU operations. The graph is recorded once, finalise lays
+     * every value, adjoint and saved intermediate out in a single arena and from then on forward and backward just
+     * replay the recorded ops, so a static graph costs no allocation or bookkeeping per iteration.
+     * Activation vars are up to maxBatchSize rows of cols values with a trailing bias slot that always holds 1, the
+     * same layout as a networks neuron rows, so any var can feed a dense op directly. Parameters are flat arrays,
+     * dense weights are k x n panel packed (getPanelWidth) with the bias weights as the last row, as ANNetwork
+     * stores each connection.
+     * Each op knows its own adjoint kernel (dense backward is the fused derivative, outer product and transposed
+     * product), new layer types only need an op here rather than hand written loops in every trainer.
+     */
+    class GradientTape {
+    public:
+        struct Var {
+            size_t index;
+        };
+
+        GradientTape( const size_t maxBatchSize = 1 );
+
+        ~GradientTape();
+
+        GradientTape( const GradientTape & ) = delete;
+
+        GradientTape &operator=( const GradientTape & ) = delete;
+
+        // recording, only before finalise
+
+        // fed by the caller every iteration, never differentiated
+        Var input( const size_t cols );
+
+        // trainable, gradients accumulate across backward calls until zeroGradients
+        Var parameter( const size_t count );
+
+        // act( x * weights ), weights is a ( x cols + 1 ) x n packed parameter
+        Var dense( const Var x, const Var weights, const size_t n,
+                   const Core::ActivationKernel act = Core::ActivationKernel::Identity,
+                   const Core::real param0 = Core::real( 0 ), const Core::real param1 = Core::real( 0 ) );
+
+        // act( conv( x ) ) per sample, x has geometry.getInputSize( ) cols and weights is a packed
+        // geometry.getWeightCount( ) parameter shared by every output position
+        Var convolution( const Var x, const Var weights, const Convolution &geometry,
+                         const Core::ActivationKernel act = Core::ActivationKernel::Identity,
+                         const Core::real param0 = Core::real( 0 ), const Core::real param1 = Core::real( 0 ) );
+
+        Var activate( const Var x, const Core::ActivationKernel act, const Core::real param0 = Core::real( 0 ),
+                      const Core::real param1 = Core::real( 0 ) );
+
+        Var add( const Var a, const Var b );
+
+        Var sub( const Var a, const Var b );
+
+        Var mul( const Var a, const Var b );
+
+        // scalar 1/2 sum ( y - target )^2 over the batch
+        Var sumSquaredError( const Var y, const Var target );
+
+        // allocates the arena, the tape is fixed after this
+        void finalise();
+
+        // running
+
+        void forward( const size_t batchSize = 1 );
+
+        // accumulates d loss / d parameter for the last forward. intermediate adjoints are consumed on the way back
+        // so only the parameter gradients are meaningful afterwards
+        void backward( const Var loss );
+
+        void zeroGradients();
+
+        // row r of a var starts at value( v ) + r * getStride( v )
+        Core::VectorALU::real_array_ptr value( const Var v );
+
+        const Core::real *gradient( const Var v ) const;
+
+        size_t getStride( const Var v ) const { return vars[ v.index ].stride; }
+
+        size_t getColumnCount( const Var v ) const { return vars[ v.index ].cols; }
+
+        // copy batchSize rows packed one after another in or out of a var
+        void setRows( const Var v, const size_t batchSize, Core::VectorALU::const_real_array_ptr in );
+
+        void getRows( const Var v, const size_t batchSize, Core::VectorALU::real_array_ptr out ) const;
+
+        size_t getPanelWidth() const { return panelWidth; }
+
+        size_t getArenaSize() const { return arenaSize; }
+
+        size_t getOpCount() const { return ops.size( ); }
+
+    private:
+        enum class OpType : uint8_t {
+            Dense,
+            Convolution,
+            Activate,
+            Add,
+            Sub,
+            Mul,
+            SumSquaredError
+        };
+
+        struct VarInfo {
+            size_t rows;        // maxBatchSize for activations, 1 for parameters and scalars
+            size_t cols;
+            size_t stride;      // cols + 1 for activations (bias slot)
+            bool   batched;     // rows follow the batch size
+            bool   isParameter;
+            bool   requiresGradient;
+            size_t valueOffset;
+            size_t gradientOffset;
+        };
+
+        struct Op {
+            OpType                 type;
+            Core::ActivationKernel act;
+            Core::real             param0;
+            Core::real             param1;
+            size_t                 a;
+            size_t                 b;
+            size_t                 out;
+            size_t                 sumsOffset; // pre activation values saved for the backward pass
+            size_t                 geometry;   // convolution only, index into convolutions
+            size_t                 colsOffset; // convolution only, im2col rows per sample then the adjoint patches
+        };
+
+        Var addVar( const size_t rows, const size_t cols, const size_t stride, const bool batched,
+                    const bool isParameter, const bool requiresGradient );
+
+        Var elementwise( const OpType type, const Var a, const Var b );
+
+        void forwardOp( const Op &op );
+
+        void backwardOp( const Op &op );
+
+        size_t rowsOf( const VarInfo &v ) const { return v.batched ? batchSize : v.rows; }
+
+        Core::VectorALU::real_array_ptr grad( const size_t index ) { return arena + vars[ index ].gradientOffset; }
+
+        Core::VectorALU::real_array_ptr val( const size_t index ) { return arena + vars[ index ].valueOffset; }
+
+        size_t maxBatchSize;
+        size_t batchSize;    // of the last forward
+        size_t panelWidth;
+
+        std::vector<VarInfo>     vars;
+        std::vector<Op>          ops;
+        std::vector<Convolution> convolutions;
+
+        // one allocation for everything: values, then parameter gradients, then the intermediate adjoints backward
+        // clears each time, then the saved sums
+        Core::VectorALU::real_array_ptr arena;
+        size_t                          arenaSize;
+        size_t                          parameterGradientBegin;
+        size_t                          parameterGradientEnd;
+        size_t                          adjointEnd;
+    };
+}
@@ -2,6 +2,10 @@
 // Created by Dean Calver on 14/04/2016.
 //
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include "core/core.h"
 #include "machinelearning/hiddenlayer.h"
 
@@ -9,7 +13,55 @@ namespace MachineLearning {
 
     static ActivationFunction sActFunc( ActivationFunctionType::Sigmoid );
 
+    // layers hold a reference to their activation function so each type gets one shared instance
+    static const ActivationFunction &SharedActivationFunc( const ActivationFunctionType type ) {
+        static ActivationFunction sLinear( ActivationFunctionType::Linear );
+        static ActivationFunction sStep( ActivationFunctionType::Step );
+        static ActivationFunction sTanh( ActivationFunctionType::HyperbolicTangent );
+        static ActivationFunction sReLU( ActivationFunctionType::ReLU );
+        switch( type ) {
+            case ActivationFunctionType::Linear:
+                return sLinear;
+            case ActivationFunctionType::Step:
+                return sStep;
+            case ActivationFunctionType::HyperbolicTangent:
+                return sTanh;
+            case ActivationFunctionType::ReLU:
+                return sReLU;
+            case ActivationFunctionType::Sigmoid:
+            default:
+                return sActFunc;
+        }
+    }
+
+    // other parameters are made on first use and, like the defaults, live for the process
+    static const ActivationFunction &SharedActivationFunc( const ActivationFunctionType type, const Core::real param0,
+                                                           const Core::real param1 ) {
+        if( param0 == Core::real( 0 ) && param1 == Core::real( 0 ) ) {
+            return SharedActivationFunc( type );
+        }
+        using Key = std::tuple<ActivationFunctionType, Core::real, Core::real>;
+        static std::mutex                                         mutex;
+        static std::map<Key, std::unique_ptr<ActivationFunction>> functions;
+
+        std::lock_guard<std::mutex> lock( mutex );
+        auto                        &func = functions[ Key( type, param0, param1 ) ];
+        if( !func ) {
+            func.reset( new ActivationFunction( type, param0, param1 ) );
+        }
+        return *func;
+    }
+
     HiddenLayer::HiddenLayer( const size_t _neuronCount ) :
             Layer( LayerType::HiddenLayer, _neuronCount, sActFunc, true ) {
     }
+
+    HiddenLayer::HiddenLayer( const size_t _neuronCount, const ActivationFunctionType _activation ) :
+            Layer( LayerType::HiddenLayer, _neuronCount, SharedActivationFunc( _activation ), true ) {
+    }
+
+    HiddenLayer::HiddenLayer( const size_t _neuronCount, const ActivationFunctionType _activation,
+                              const Core::real _param0, const Core::real _param1 ) :
+            Layer( LayerType::HiddenLayer, _neuronCount, SharedActivationFunc( _activation, _param0, _param1 ), true ) {
+    }
 }
\ No newline at end of file
@@ -13,5 +13,11 @@ namespace MachineLearning {
 
     public:
         HiddenLayer( const size_t _neuronCount );
+
+        HiddenLayer( const size_t _neuronCount, const ActivationFunctionType _activation );
+
+        // activation parameters other than the defaults, e.g. the ReLU threshold and the value below it
+        HiddenLayer( const size_t _neuronCount, const ActivationFunctionType _activation, const Core::real _param0,
+                     const Core::real _param1 );
     };
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include "core/core.h"
+#include "core/randomstream.h"
+#include "core/threadpool.h"
+#include "core/trace.h"
+#include "machinelearning/inputlayer.h"
+#include "machinelearning/hiddenlayer.h"
+#include "machinelearning/outputlayer.h"
+#include "machinelearning/connections.h"
+#include "machinelearning/hyperparametersearch.h"
+
+namespace MachineLearning {
+
+    namespace {
+        const char *ActivationName( const ActivationFunctionType type ) {
+            switch( type ) {
+                case ActivationFunctionType::Linear:
+                    return "linear";
+                case ActivationFunctionType::Step:
+                    return "step";
+                case ActivationFunctionType::Sigmoid:
+                    return "sigmoid";
+                case ActivationFunctionType::HyperbolicTangent:
+                    return "tanh";
+                case ActivationFunctionType::ReLU:
+                    return "relu";
+            }
+            return "?";
+        }
+
+        std::string LayoutName( const std::vector<size_t> &layout ) {
+            std::ostringstream out;
+            for( size_t i = 0; i < layout.size( ); ++i ) {
+                out << ((i > 0) ? "-" : "") << layout[ i ];
+            }
+            return out.str( );
+        }
+
+        // a diverged run has a nan RMS, which must rank last rather than compare false with everything
+        Core::real RankKey( const Core::real rms ) {
+            return std::isfinite( rms ) ? rms : std::numeric_limits<Core::real>::max( );
+        }
+    }
+
+    struct HyperParameterSearch::Trial {
+        std::unique_ptr<ANNetwork> network;
+        SearchTrialResult          result;
+    };
+
+    HyperParameterSearch::HyperParameterSearch( const size_t _inputCount, const size_t _outputCount,
+                                                const std::vector<ANNetwork::MatchingPair> &_trainingSet,
+                                                const std::vector<ANNetwork::MatchingPair> &_testSet,
+                                                const Config &_config ) :
+            inputCount( _inputCount ),
+            outputCount( _outputCount ),
+            trainingSet( _trainingSet ),
+            testSet( _testSet ),
+            config( _config ) {
+        assert( !trainingSet.empty( ) );
+        assert( !testSet.empty( ) );
+        assert( config.halvingFactor >= 2 );
+    }
+
+    std::vector<HyperParameters> HyperParameterSearch::grid( const SearchSpace &space ) {
+        std::vector<HyperParameters> candidates;
+        for( auto &&lr : space.learningRates ) {
+            for( auto &&momentum : space.momentums ) {
+                for( auto &&layout : space.hiddenLayouts ) {
+                    for( auto &&activation : space.hiddenActivations ) {
+                        candidates.push_back( HyperParameters{ lr, momentum, layout, activation } );
+                    }
+                }
+            }
+        }
+        return candidates;
+    }
+
+    std::vector<HyperParameters> HyperParameterSearch::random( const SearchSpace &space, const size_t count,
+                                                               const uint32_t seed ) {
+        assert( !space.learningRates.empty( ) && !space.momentums.empty( ) );
+        assert( !space.hiddenLayouts.empty( ) && !space.hiddenActivations.empty( ) );
+
+        const auto lr       = std::minmax_element( space.learningRates.begin( ), space.learningRates.end( ) );
+        const auto momentum = std::minmax_element( space.momentums.begin( ), space.momentums.end( ) );
+        assert( *lr.first > 0 );
+
+        Core::RandomStream stream( seed, 0 );
+        const double       logLo = std::log( *lr.first ), logHi = std::log( *lr.second );
+        const auto         pick  = [ &stream ]( const size_t n ) {
+            return std::min( n - 1, size_t( stream.nextUniform( ) * Core::real( n ) ) );
+        };
+
+        std::vector<HyperParameters> candidates;
+        for( size_t i = 0; i < count; ++i ) {
+            const double u  = stream.nextUniform( );
+            const double um = stream.nextUniform( );
+            candidates.push_back( HyperParameters{ Core::real( std::exp( logLo + ((logHi - logLo) * u) ) ),
+                                                   Core::real( *momentum.first +
+                                                               ((*momentum.second - *momentum.first) * um) ),
+                                                   space.hiddenLayouts[ pick( space.hiddenLayouts.size( ) ) ],
+                                                   space.hiddenActivations[ pick( space.hiddenActivations.size( ) ) ] } );
+        }
+        return candidates;
+    }
+
+    std::unique_ptr<ANNetwork> HyperParameterSearch::buildNetwork( const HyperParameters &params,
+                                                                   const size_t trialIndex ) const {
+        std::unique_ptr<ANNetwork> ann( new ANNetwork( ) );
+
+        Layer::shared_ptr prev = std::make_shared<InputLayer>( inputCount );
+        ann->addLayer( prev );
+        for( auto &&width : params.hiddenLayers ) {
+            Layer::shared_ptr hidden = std::make_shared<HiddenLayer>( width, params.hiddenActivation );
+            ann->addLayer( hidden );
+            ann->connectLayers( std::make_shared<Connections>( prev, hidden ) );
+            prev = hidden;
+        }
+        Layer::shared_ptr out = std::make_shared<OutputLayer>( outputCount );
+        ann->addLayer( out );
+        ann->connectLayers( std::make_shared<Connections>( prev, out ) );
+
+        ann->setLearningRate( params.learningRate );
+        ann->setMomentum( params.momentum );
+        ann->finalise( true, config.batchSize );
+
+        // each trial is its own stream of the search seed, so results don't depend on which thread ran it
+        Core::RandomStream      stream( config.seed, trialIndex );
+        std::vector<Core::real> weights( ann->getTotalWeightCount( ) );
+        stream.fillUniform( weights.size( ), -config.weightRange, config.weightRange, weights.data( ) );
+        ann->setWeights( weights );
+
+        return ann;
+    }
+
+    std::vector<SearchTrialResult> HyperParameterSearch::run( const std::vector<HyperParameters> &candidates ) {
+        CORE_TRACE_SCOPE_ARG( "HyperParameterSearch::run", candidates.size( ) );
+
+        // test RMS of every run at each epoch, for the median stopping rule
+        std::mutex                           historyMutex;
+        std::vector<std::vector<Core::real>> history( config.maxEpochs );
+
+        std::vector<SearchTrialResult> results( candidates.size( ) );
+        {
+            Core::ThreadPool pool( config.threadCount );
+            for( size_t t = 0; t < candidates.size( ); ++t ) {
+                pool.submit( [ &, t ]() {
+                    CORE_TRACE_SCOPE_ARG( "HyperParameterSearch.trial", t );
+                    auto network = buildNetwork( candidates[ t ], t );
+                    auto &result = results[ t ];
+                    result = SearchTrialResult{ candidates[ t ], Core::real( 0 ), Core::real( 0 ), 0, false };
+
+                    for( size_t epoch = 0; epoch < config.maxEpochs; ++epoch ) {
+                        result.trainRMS = network->trainEpoch( trainingSet );
+                        result.testRMS  = network->testError( testSet );
+                        result.epochs   = epoch + 1;
+
+                        if( !std::isfinite( result.testRMS ) ) {
+                            result.stoppedEarly = (epoch + 1) < config.maxEpochs;
+                            break;
+                        }
+
+                        std::vector<Core::real> others;
+                        {
+                            std::lock_guard<std::mutex> lock( historyMutex );
+                            others = history[ epoch ];
+                            history[ epoch ].push_back( result.testRMS );
+                        }
+                        if( result.epochs >= config.gracePeriod && others.size( ) >= config.minRunsForMedian &&
+                            result.epochs < config.maxEpochs ) {
+                            std::nth_element( others.begin( ), others.begin( ) + (others.size( ) / 2), others.end( ) );
+                            if( result.testRMS > others[ others.size( ) / 2 ] ) {
+                                result.stoppedEarly = true;
+                                break;
+                            }
+                        }
+                    }
+                } );
+            }
+            pool.wait( );
+        }
+        return rank( results );
+    }
+
+    std::vector<SearchTrialResult> HyperParameterSearch::successiveHalving(
+            const std::vector<HyperParameters> &candidates ) {
+        CORE_TRACE_SCOPE_ARG( "HyperParameterSearch::successiveHalving", candidates.size( ) );
+
+        std::vector<Trial> trials( candidates.size( ) );
+        for( size_t t = 0; t < candidates.size( ); ++t ) {
+            trials[ t ].result = SearchTrialResult{ candidates[ t ], Core::real( 0 ), Core::real( 0 ), 0, false };
+        }
+
+        std::vector<size_t> alive( candidates.size( ) );
+        for( size_t t = 0; t < alive.size( ); ++t ) { alive[ t ] = t; }
+
+        Core::ThreadPool pool( config.threadCount );
+        size_t           budget = std::min( config.halvingMinEpochs, config.maxEpochs );
+        while( !alive.empty( ) ) {
+            // each survivor continues from where it got to, the widest networks take longest so stealing matters
+            for( auto &&t : alive ) {
+                pool.submit( [ &, t, budget ]() {
+                    CORE_TRACE_SCOPE_ARG( "HyperParameterSearch.trial", t );
+                    auto &trial = trials[ t ];
+                    if( !trial.network ) { trial.network = buildNetwork( trial.result.params, t ); }
+                    while( trial.result.epochs < budget && std::isfinite( trial.result.trainRMS ) ) {
+                        trial.result.trainRMS = trial.network->trainEpoch( trainingSet );
+                        trial.result.epochs++;
+                    }
+                    trial.result.testRMS = trial.network->testError( testSet );
+                } );
+            }
+            pool.wait( );
+
+            if( alive.size( ) == 1 || budget >= config.maxEpochs ) {
+                break;
+            }
+
+            std::stable_sort( alive.begin( ), alive.end( ), [ &trials ]( const size_t a, const size_t b ) {
+                return RankKey( trials[ a ].result.testRMS ) < RankKey( trials[ b ].result.testRMS );
+            } );
+            const size_t keep = (alive.size( ) + config.halvingFactor - 1) / config.halvingFactor;
+            for( size_t i = keep; i < alive.size( ); ++i ) {
+                trials[ alive[ i ] ].result.stoppedEarly = true;
+                trials[ alive[ i ] ].network.reset( );
+            }
+            alive.resize( keep );
+            budget = std::min( budget * config.halvingFactor, config.maxEpochs );
+        }
+
+        std::vector<SearchTrialResult> results;
+        for( auto &&trial : trials ) { results.push_back( trial.result ); }
+        return rank( results );
+    }
+
+    std::vector<SearchTrialResult> HyperParameterSearch::rank( std::vector<SearchTrialResult> results ) {
+        // runs that went the distance first, then by test RMS
+        std::stable_sort( results.begin( ), results.end( ), []( const SearchTrialResult &a,
+                                                                 const SearchTrialResult &b ) {
+            if( a.stoppedEarly != b.stoppedEarly ) { return !a.stoppedEarly; }
+            return RankKey( a.testRMS ) < RankKey( b.testRMS );
+        } );
+        return results;
+    }
+
+    void HyperParameterSearch::writeTable( std::ostream &out, const std::vector<SearchTrialResult> &results ) {
+        // left aligned columns, the callers stream goes back as it came
+        const auto oldFlags = out.flags( );
+
+        out << std::left << std::setw( 6 ) << "rank" << std::setw( 12 ) << "lr" << std::setw( 12 ) << "momentum"
+            << std::setw( 14 ) << "hidden" << std::setw( 10 ) << "act" << std::setw( 8 ) << "epochs"
+            << std::setw( 14 ) << "train RMS" << std::setw( 14 ) << "test RMS" << "stopped\n";
+        for( size_t i = 0; i < results.size( ); ++i ) {
+            const auto &r = results[ i ];
+            out << std::left << std::setw( 6 ) << (i + 1) << std::setw( 12 ) << r.params.learningRate
+                << std::setw( 12 ) << r.params.momentum << std::setw( 14 ) << LayoutName( r.params.hiddenLayers )
+                << std::setw( 10 ) << ActivationName( r.params.hiddenActivation ) << std::setw( 8 ) << r.epochs
+                << std::setw( 14 ) << r.trainRMS << std::setw( 14 ) << r.testRMS
+                << (r.stoppedEarly ? "early" : "") << "\n";
+        }
+
+        out.flags( oldFlags );
+    }
+}
@@ -0,0 +1,96 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/ActivationFunction.h"
+#include "machinelearning/ANNetwork.h"
+
+namespace MachineLearning {
+
+    struct HyperParameters {
+        Core::real             learningRate     = Core::real( 0.7 );
+        Core::real             momentum         = Core::real( 0.3 );
+        std::vector<size_t>    hiddenLayers     = { 8 };
+        ActivationFunctionType hiddenActivation = ActivationFunctionType::Sigmoid;
+    };
+
+    struct SearchTrialResult {
+        HyperParameters params;
+        Core::real      trainRMS;
+        Core::real      testRMS;
+        size_t          epochs;
+        bool            stoppedEarly;
+    };
+
+    /*
+     * Trains many ANNetwork configurations concurrently on a work stealing pool, one task per run, against shared
+     * read only training and test sets. Runs are ranked by their final test set RMS.
+     */
+    class HyperParameterSearch {
+    public:
+        // grid search takes the cartesian product, random search samples the learning rate log uniformly and the
+        // momentum uniformly between the smallest and largest listed and picks layouts and activations from the lists
+        struct SearchSpace {
+            std::vector<Core::real>             learningRates;
+            std::vector<Core::real>             momentums;
+            std::vector<std::vector<size_t>>    hiddenLayouts;
+            std::vector<ActivationFunctionType> hiddenActivations;
+        };
+
+        struct Config {
+            size_t     maxEpochs   = 50;
+            size_t     batchSize   = 16;
+            size_t     threadCount = 0; // 0 is every hardware thread
+            Core::real weightRange = Core::real( 1 );
+            uint32_t   seed        = 0xDEA0DEA0;
+
+            // median stopping for run(): once past the grace period a run whose test RMS is worse than the median
+            // of the other runs at the same epoch is stopped (needs minRunsForMedian results to compare against)
+            size_t gracePeriod      = 5;
+            size_t minRunsForMedian = 4;
+
+            // successiveHalving(): every survivor trains to the rung's epoch budget then the best 1 / halvingFactor
+            // go on to a halvingFactor times larger budget
+            size_t halvingMinEpochs = 4;
+            size_t halvingFactor    = 3;
+        };
+
+        HyperParameterSearch( const size_t _inputCount, const size_t _outputCount,
+                              const std::vector<ANNetwork::MatchingPair> &_trainingSet,
+                              const std::vector<ANNetwork::MatchingPair> &_testSet, const Config &_config );
+
+        static std::vector<HyperParameters> grid( const SearchSpace &space );
+
+        static std::vector<HyperParameters> random( const SearchSpace &space, const size_t count, const uint32_t seed );
+
+        // every candidate trains to maxEpochs unless median stopping cuts it short. which runs stop depends on how
+        // the runs interleave, so unlike successiveHalving this isn't repeatable run to run
+        std::vector<SearchTrialResult> run( const std::vector<HyperParameters> &candidates );
+
+        std::vector<SearchTrialResult> successiveHalving( const std::vector<HyperParameters> &candidates );
+
+        // the ranked results table, best first
+        static void writeTable( std::ostream &out, const std::vector<SearchTrialResult> &results );
+
+    private:
+        struct Trial;
+
+        std::unique_ptr<ANNetwork> buildNetwork( const HyperParameters &params, const size_t trialIndex ) const;
+
+        static std::vector<SearchTrialResult> rank( std::vector<SearchTrialResult> results );
+
+        const size_t                               inputCount;
+        const size_t                               outputCount;
+        const std::vector<ANNetwork::MatchingPair> &trainingSet;
+        const std::vector<ANNetwork::MatchingPair> &testSet;
+        const Config                               config;
+    };
+}
@@ -12,11 +12,13 @@ namespace MachineLearning {
     InputLayer::InputLayer( const size_t _neuronCount ) :
             Layer( LayerType::InputLayer, _neuronCount, linearAF, true ),
             inputData( neuronCount, 0 ) {
+        if( isBiased( ) ) { inputData.push_back( Core::real( 1.0 ) ); } // bias neuron
     }
 
     InputLayer::InputLayer( const size_t _neuronCount, const Core::real *_inputData ) :
             Layer( LayerType::InputLayer, _neuronCount, linearAF, true ),
             inputData( _inputData, _inputData + neuronCount ) {
+        if( isBiased( ) ) { inputData.push_back( Core::real( 1.0 ) ); } // bias neuron
     }
 
 }
\ No newline at end of file
@@ -27,10 +27,23 @@ namespace MachineLearning {
      */
     class LayerView {
     public:
+        LayerView() = default;
+
+        // outermost dimension first, the last dimension is contiguous
+        LayerView( const std::vector<size_t> &_sizeOfDims ) : sizeOfDims( _sizeOfDims ) { }
+
+        virtual ~LayerView() = default;
+
         virtual size_t numberOfDimensions() const { return sizeOfDims.size( ); }
 
         virtual size_t sizeOfDimension( const size_t d ) const { return sizeOfDims.at( d ); }
 
+        size_t elementCount() const {
+            size_t count = 1;
+            for( auto &&d : sizeOfDims ) { count *= d; }
+            return count;
+        }
+
     protected:
         std::vector<size_t> sizeOfDims;         // each dimension has N elements
     };
@@ -0,0 +1,265 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/lbfgstrainer.h"
+
+namespace MachineLearning {
+
+    namespace {
+        // minimiser of the cubic through both ends loss and slope, kept away from the ends or bisection if the
+        // cubic is no use (no minimum, an infinite loss)
+        Core::real Interpolate( const double lo, const double loLoss, const double loSlope,
+                                const double hi, const double hiLoss, const double hiSlope ) {
+            const double mid  = 0.5 * (lo + hi);
+            const double d1   = loSlope + hiSlope - (3.0 * (loLoss - hiLoss) / (lo - hi));
+            const double disc = (d1 * d1) - (loSlope * hiSlope);
+            if( !std::isfinite( d1 ) || !std::isfinite( disc ) || disc < 0.0 ) {
+                return Core::real( mid );
+            }
+
+            const double d2 = std::copysign( std::sqrt( disc ), hi - lo );
+            const double a  = hi - ((hi - lo) * (hiSlope + d2 - d1) / (hiSlope - loSlope + (2.0 * d2)));
+
+            const double left = std::min( lo, hi ), right = std::max( lo, hi ), margin = 0.1 * (right - left);
+            return Core::real( (a >= left + margin && a <= right - margin) ? a : mid );
+        }
+    }
+
+    LBFGSTrainer::LBFGSTrainer( ANNetwork &_network, const Config &_config ) :
+            network( _network ),
+            config( _config ),
+            weightCount( _network.getTotalWeightCount( ) ),
+            historyHead( 0 ),
+            historyCount( 0 ),
+            gamma( Core::real( 1 ) ),
+            evaluations( 0 ) {
+        assert( network.gradients != nullptr );
+        assert( config.historySize > 0 );
+        assert( config.sufficientDecrease > Core::real( 0 ) && config.sufficientDecrease < config.curvature );
+        assert( config.curvature < Core::real( 1 ) );
+
+        auto alu = Core::VectorALUFactory( );
+        position      = alu->newRealVector( weightCount );
+        gradient      = alu->newRealVector( weightCount );
+        trialGradient = alu->newRealVector( weightCount );
+        direction     = alu->newRealVector( weightCount );
+        scratch       = alu->newRealVector( weightCount );
+        alu->set( weightCount, Core::real( 0 ), direction );
+
+        steps.resize( config.historySize );
+        changes.resize( config.historySize );
+        for( size_t i = 0; i < config.historySize; ++i ) {
+            steps[ i ]   = alu->newRealVector( weightCount );
+            changes[ i ] = alu->newRealVector( weightCount );
+        }
+        rho.resize( config.historySize, Core::real( 0 ) );
+        alphas.resize( config.historySize, Core::real( 0 ) );
+    }
+
+    LBFGSTrainer::~LBFGSTrainer() {
+        auto alu = Core::VectorALUFactory( );
+        alu->deleteRealVector( position );
+        alu->deleteRealVector( gradient );
+        alu->deleteRealVector( trialGradient );
+        alu->deleteRealVector( direction );
+        alu->deleteRealVector( scratch );
+        for( size_t i = 0; i < config.historySize; ++i ) {
+            alu->deleteRealVector( steps[ i ] );
+            alu->deleteRealVector( changes[ i ] );
+        }
+    }
+
+    LBFGSTrainer::Result LBFGSTrainer::train( const std::vector<ANNetwork::MatchingPair> &trainingSet ) {
+        assert( trainingSet.size( ) > 0 );
+        CORE_TRACE_SCOPE( "LBFGSTrainer::train" );
+
+        auto alu = Core::VectorALUFactory( );
+        evaluations = 0;
+
+        Result result;
+        alu->copy( weightCount, network.weights, position );
+        Core::real loss = evaluateAt( trainingSet, Core::real( 0 ) );
+        std::swap( gradient, trialGradient );
+
+        while( result.iterations < config.maxIterations ) {
+            if( alu->normInfinite( weightCount, gradient ) <= config.gradientTolerance ) {
+                result.converged = true;
+                break;
+            }
+
+            computeDirection( );
+            Core::real slope = alu->dot( weightCount, gradient, direction );
+            if( !(slope < Core::real( 0 )) ) {
+                // the history has gone bad, start again from steepest descent
+                clearHistory( );
+                computeDirection( );
+                slope = alu->dot( weightCount, gradient, direction );
+            }
+
+            // without curvature information the first step is scaled to a unit move
+            const Core::real alpha0 = (historyCount == 0)
+                                      ? std::min( Core::real( 1 ),
+                                                  Core::real( 1 ) / alu->norm2( weightCount, gradient ) )
+                                      : Core::real( 1 );
+            Core::real newLoss;
+            if( !lineSearch( trainingSet, loss, slope, alpha0, newLoss ) ) {
+                alu->copy( weightCount, position, network.weights );
+                network.refreshBackpropWeights( );
+                if( historyCount > 0 ) {
+                    clearHistory( );
+                    continue;
+                }
+                break;
+            }
+            ++result.iterations;
+
+            // the network and trialGradient are at the accepted step, s = x+ - x and y = g+ - g. when the ring is
+            // full the head slot is the oldest live pair, so build the new pair in scratch and the spent direction
+            // and only swap it in once accepted
+            alu->sub( weightCount, network.weights, position, scratch );
+            alu->sub( weightCount, trialGradient, gradient, direction );
+            const Core::real sy = alu->dot( weightCount, scratch, direction );
+            const Core::real yy = alu->dot( weightCount, direction, direction );
+            // the Wolfe curvature condition makes s.y positive, rounding can still spoil a pair so skip those
+            if( sy > std::numeric_limits<Core::real>::epsilon( ) * yy && yy > Core::real( 0 ) ) {
+                const size_t slot = historyHead;
+                std::swap( steps[ slot ], scratch );
+                std::swap( changes[ slot ], direction );
+                rho[ slot ]  = Core::real( 1 ) / sy;
+                gamma        = sy / yy;
+                historyHead  = (historyHead + 1) % config.historySize;
+                historyCount = std::min( historyCount + 1, config.historySize );
+            }
+
+            alu->copy( weightCount, network.weights, position );
+            std::swap( gradient, trialGradient );
+
+            const Core::real decrease = loss - newLoss;
+            loss = newLoss;
+            if( decrease <= config.lossTolerance * std::max( Core::real( 1 ), std::fabs( loss ) ) ) {
+                result.converged = true;
+                break;
+            }
+        }
+
+        const auto outCount = network.getOutputCount( );
+        result.evaluations = evaluations;
+        result.loss        = loss;
+        result.rms         = std::sqrt( Core::real( 2 ) * loss / Core::real( outCount ) );
+        return result;
+    }
+
+    Core::real LBFGSTrainer::evaluateAt( const std::vector<ANNetwork::MatchingPair> &set, const Core::real alpha ) {
+        auto alu = Core::VectorALUFactory( );
+
+        alu->copy( weightCount, position, network.weights );
+        if( alpha != Core::real( 0 ) ) {
+            alu->accumulate( weightCount, direction, alpha, network.weights );
+        }
+        network.refreshBackpropWeights( );
+
+        // the network sums gradients over the set, the loss and trialGradient are means
+        const Core::real sse      = network.accumulateGradients( set );
+        const Core::real invCount = Core::real( 1 ) / Core::real( set.size( ) );
+        alu->mul( weightCount, network.gradients, invCount, trialGradient );
+        alu->set( weightCount, Core::real( 0 ), network.gradients );
+        network.gradientSampleCount = 0;
+
+        ++evaluations;
+        return Core::real( 0.5 ) * sse * invCount;
+    }
+
+    Core::real LBFGSTrainer::directionalDerivative() const {
+        return Core::VectorALUFactory( )->dot( weightCount, trialGradient, direction );
+    }
+
+    bool LBFGSTrainer::lineSearch( const std::vector<ANNetwork::MatchingPair> &set, const Core::real loss0,
+                                   const Core::real slope0, Core::real alpha, Core::real &loss ) {
+        CORE_TRACE_SCOPE( "LBFGSTrainer::lineSearch" );
+        assert( slope0 < Core::real( 0 ) );
+
+        const Core::real c1 = config.sufficientDecrease;
+        const Core::real c2 = config.curvature;
+        size_t           evaluationsLeft = config.maxLineSearchSteps;
+
+        // bracket, growing the step until it overshoots the minimum along the direction
+        Core::real prevAlpha = Core::real( 0 ), prevLoss = loss0, prevSlope = slope0;
+        Core::real lo, loLoss, loSlope, hi, hiLoss, hiSlope;
+        for( bool first = true;; first = false ) {
+            if( evaluationsLeft-- == 0 ) {
+                return false;
+            }
+            const Core::real f = evaluateAt( set, alpha );
+            const Core::real d = directionalDerivative( );
+            if( !std::isfinite( f ) || f > loss0 + (c1 * alpha * slope0) || (!first && f >= prevLoss) ) {
+                lo = prevAlpha, loLoss = prevLoss, loSlope = prevSlope;
+                hi = alpha, hiLoss = f, hiSlope = d;
+                break;
+            }
+            if( std::fabs( d ) <= -c2 * slope0 ) {
+                loss = f;
+                return true;
+            }
+            if( d >= Core::real( 0 ) ) {
+                lo = alpha, loLoss = f, loSlope = d;
+                hi = prevAlpha, hiLoss = prevLoss, hiSlope = prevSlope;
+                break;
+            }
+            prevAlpha = alpha, prevLoss = f, prevSlope = d;
+            alpha *= Core::real( 2 );
+        }
+
+        // zoom, lo always satisfies sufficient decrease and has the lowest loss seen so far
+        while( evaluationsLeft-- > 0 ) {
+            if( std::fabs( hi - lo ) <= std::numeric_limits<Core::real>::epsilon( ) * std::fabs( lo ) ) {
+                return false;
+            }
+            alpha = Interpolate( lo, loLoss, loSlope, hi, hiLoss, hiSlope );
+            const Core::real f = evaluateAt( set, alpha );
+            const Core::real d = directionalDerivative( );
+            if( !std::isfinite( f ) || f > loss0 + (c1 * alpha * slope0) || f >= loLoss ) {
+                hi = alpha, hiLoss = f, hiSlope = d;
+            } else {
+                if( std::fabs( d ) <= -c2 * slope0 ) {
+                    loss = f;
+                    return true;
+                }
+                if( d * (hi - lo) >= Core::real( 0 ) ) {
+                    hi = lo, hiLoss = loLoss, hiSlope = loSlope;
+                }
+                lo = alpha, loLoss = f, loSlope = d;
+            }
+        }
+        return false;
+    }
+
+    void LBFGSTrainer::computeDirection() {
+        auto         alu = Core::VectorALUFactory( );
+        const size_t m   = config.historySize;
+
+        // newest to oldest, q = gradient less the projections on each y
+        alu->copy( weightCount, gradient, scratch );
+        for( size_t k = 0; k < historyCount; ++k ) {
+            const size_t i = (historyHead + m - 1 - k) % m;
+            alphas[ i ] = rho[ i ] * alu->dot( weightCount, steps[ i ], scratch );
+            alu->accumulate( weightCount, changes[ i ], -alphas[ i ], scratch );
+        }
+
+        // direction holds -r throughout, starting from the scaled identity
+        const Core::real scale = (historyCount > 0) ? gamma : Core::real( 1 );
+        alu->mul( weightCount, scratch, -scale, direction );
+        for( size_t k = historyCount; k-- > 0; ) {
+            const size_t     i    = (historyHead + m - 1 - k) % m;
+            const Core::real beta = -rho[ i ] * alu->dot( weightCount, changes[ i ], direction );
+            alu->accumulate( weightCount, steps[ i ], beta - alphas[ i ], direction );
+        }
+    }
+}
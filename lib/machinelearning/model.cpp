@@ -0,0 +1,338 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/model.h"
+
+namespace MachineLearning {
+
+    Model::Model() :
+            alu( Core::VectorALUFactory( ) ),
+            inputCount( 0 ),
+            inputNeuronIndex( 0 ),
+            outputCount( 0 ),
+            outputNeuronIndex( 0 ),
+            totalNeuronCount( 0 ),
+            totalWeightCount( 0 ),
+            panelWidth( 1 ),
+            weights( nullptr ) {
+    }
+
+    Model::~Model() {
+        if( weights != nullptr ) { alu->deleteRealVector( weights ); }
+    }
+
+    void Model::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                          Core::VectorALU::real_array_ptr activations,
+                          Core::VectorALU::real_array_ptr results ) const {
+        CORE_TRACE_SCOPE_ARG( "Model::evaluate", batchSize );
+
+        for( size_t b = 0; b < batchSize; ++b ) {
+            alu->copy( inputCount, inputs + (b * inputCount),
+                       activations + (b * totalNeuronCount) + inputNeuronIndex );
+        }
+
+        // the fused kernels never read the bias neurons so the activations need no bias setup
+        for( auto &&step : steps ) {
+            switch( step.kind ) {
+                case StepKind::Dense:
+                    alu->packedDenseActivate( batchSize, step.dstNeuronCount, step.srcNeuronCount,
+                                              activations + step.srcNeuronIndex, totalNeuronCount,
+                                              weights + step.weightIndex, panelWidth,
+                                              step.activation, step.param0, step.param1,
+                                              nullptr, 0,
+                                              activations + step.dstNeuronIndex, totalNeuronCount );
+                    break;
+                case StepKind::Accumulate:
+                    alu->packedDenseAccumulate( batchSize, step.dstNeuronCount, step.srcNeuronCount,
+                                                activations + step.srcNeuronIndex, totalNeuronCount,
+                                                weights + step.weightIndex, panelWidth,
+                                                activations + step.dstNeuronIndex, totalNeuronCount );
+                    break;
+                case StepKind::Activate:
+                    for( size_t b = 0; b < batchSize; ++b ) {
+                        const auto row = activations + (b * totalNeuronCount) + step.dstNeuronIndex;
+                        alu->activate( step.dstNeuronCount, step.activation, step.param0, step.param1, row, row );
+                    }
+                    break;
+            }
+        }
+
+        for( size_t b = 0; b < batchSize; ++b ) {
+            alu->copy( outputCount, activations + (b * totalNeuronCount) + outputNeuronIndex,
+                       results + (b * outputCount) );
+        }
+    }
+
+    bool Model::isChain() const {
+        for( size_t s = 0; s < steps.size( ); ++s ) {
+            if( steps[ s ].kind != StepKind::Dense ) { return false; }
+            if( s > 0 && steps[ s ].srcNeuronIndex != steps[ s - 1 ].dstNeuronIndex ) { return false; }
+        }
+        return true;
+    }
+
+    std::vector<Core::real> Model::getStepWeights( const Step &step ) const {
+        if( step.kind == StepKind::Activate ) {
+            return { };
+        }
+        std::vector<Core::real> unpacked( step.srcNeuronCount * step.dstNeuronCount );
+        alu->unpackPanels( step.srcNeuronCount, step.dstNeuronCount, weights + step.weightIndex, panelWidth,
+                           unpacked.data( ), step.dstNeuronCount );
+        return unpacked;
+    }
+
+    namespace {
+        const char     modelFileMagic[4] = { 'F', 'A', 'M', 'D' };
+        const uint32_t modelFileVersion  = 2; // 2 added the step kind
+
+        template<typename T>
+        void writePod( std::ostream &out, const T &value ) {
+            out.write( reinterpret_cast<const char *>( &value ), sizeof( T ) );
+        }
+
+        template<typename T>
+        bool readPod( std::istream &in, T &value ) {
+            return static_cast<bool>( in.read( reinterpret_cast<char *>( &value ), sizeof( T ) ) );
+        }
+
+        // false rather than wrapping, the sizes in a file can't be trusted
+        bool checkedAdd( const uint64_t a, const uint64_t b, uint64_t &sum ) {
+            if( a > std::numeric_limits<uint64_t>::max( ) - b ) { return false; }
+            sum = a + b;
+            return true;
+        }
+
+        bool checkedMul( const uint64_t a, const uint64_t b, uint64_t &product ) {
+            if( a != 0 && b > std::numeric_limits<uint64_t>::max( ) / a ) { return false; }
+            product = a * b;
+            return true;
+        }
+
+        bool withinCount( const uint64_t index, const uint64_t count, const uint64_t total ) {
+            uint64_t end;
+            return checkedAdd( index, count, end ) && end <= total;
+        }
+
+        // bytes left in the stream or max when it can't seek
+        uint64_t remainingBytes( std::istream &in ) {
+            const auto here = in.tellg( );
+            if( here < 0 || !in.seekg( 0, std::ios::end ) ) {
+                in.clear( );
+                return std::numeric_limits<uint64_t>::max( );
+            }
+            const auto end = in.tellg( );
+            in.seekg( here );
+            return (end < here) ? 0 : uint64_t( end - here );
+        }
+    }
+
+    bool Model::save( std::ostream &out ) const {
+        out.write( modelFileMagic, sizeof( modelFileMagic ) );
+        writePod( out, modelFileVersion );
+        writePod( out, uint32_t( sizeof( Core::real ) ) );
+        writePod( out, uint64_t( inputCount ) );
+        writePod( out, uint64_t( inputNeuronIndex ) );
+        writePod( out, uint64_t( outputCount ) );
+        writePod( out, uint64_t( outputNeuronIndex ) );
+        writePod( out, uint64_t( totalNeuronCount ) );
+        writePod( out, uint64_t( totalWeightCount ) );
+        writePod( out, uint64_t( steps.size( ) ) );
+
+        for( auto &&step : steps ) {
+            writePod( out, uint64_t( step.srcNeuronIndex ) );
+            writePod( out, uint64_t( step.srcNeuronCount ) );
+            writePod( out, uint64_t( step.dstNeuronIndex ) );
+            writePod( out, uint64_t( step.dstNeuronCount ) );
+            writePod( out, uint64_t( step.weightIndex ) );
+            writePod( out, uint32_t( step.activation ) );
+            writePod( out, step.param0 );
+            writePod( out, step.param1 );
+            writePod( out, uint32_t( step.kind ) );
+
+            const auto unpacked = getStepWeights( step );
+            out.write( reinterpret_cast<const char *>( unpacked.data( ) ), unpacked.size( ) * sizeof( Core::real ) );
+        }
+        return static_cast<bool>( out );
+    }
+
+    bool Model::save( const std::string &filename ) const {
+        std::ofstream out( filename, std::ios::binary | std::ios::trunc );
+        return out && save( out );
+    }
+
+    Model::shared_ptr Model::load( std::istream &in ) {
+        char     magic[4];
+        uint32_t version, realSize;
+        uint64_t counts[7];
+        if( !in.read( magic, sizeof( magic ) ) || std::memcmp( magic, modelFileMagic, sizeof( magic ) ) != 0 ) {
+            return nullptr;
+        }
+        if( !readPod( in, version ) || version < 1 || version > modelFileVersion ||
+            !readPod( in, realSize ) || realSize != sizeof( Core::real ) ) {
+            return nullptr;
+        }
+        for( auto &&count : counts ) {
+            if( !readPod( in, count ) ) { return nullptr; }
+        }
+
+        auto model = std::shared_ptr<Model>( new Model( ) );
+        model->inputCount        = counts[ 0 ];
+        model->inputNeuronIndex  = counts[ 1 ];
+        model->outputCount       = counts[ 2 ];
+        model->outputNeuronIndex = counts[ 3 ];
+        model->totalNeuronCount  = counts[ 4 ];
+        model->totalWeightCount  = counts[ 5 ];
+        model->panelWidth        = model->alu->preferredPanelWidth( );
+        if( !withinCount( counts[ 1 ], counts[ 0 ], counts[ 4 ] ) ||
+            !withinCount( counts[ 3 ], counts[ 2 ], counts[ 4 ] ) ) {
+            return nullptr;
+        }
+
+        // every step header and weight must be there before anything is allocated from the counts, a stream that
+        // cant seek reports max and is caught by the reads instead
+        const uint64_t stepHeaderBytes = (5 * sizeof( uint64_t )) + sizeof( uint32_t ) + (2 * sizeof( Core::real )) +
+                                         ((version >= 2) ? sizeof( uint32_t ) : 0);
+        uint64_t       headerBytes, weightBytes, payloadBytes;
+        if( !checkedMul( counts[ 6 ], stepHeaderBytes, headerBytes ) ||
+            !checkedMul( counts[ 5 ], sizeof( Core::real ), weightBytes ) ||
+            !checkedAdd( headerBytes, weightBytes, payloadBytes ) ) {
+            return nullptr;
+        }
+        const uint64_t remaining = remainingBytes( in );
+        if( remaining < payloadBytes ) {
+            return nullptr;
+        }
+
+        model->weights = model->alu->newRealVector( model->totalWeightCount );
+
+        std::vector<Core::real>                    unpacked;
+        std::vector<std::pair<uint64_t, uint64_t>> ranges; // where each steps weights start and how many
+        for( uint64_t i = 0; i < counts[ 6 ]; ++i ) {
+            uint64_t   fields[5];
+            uint32_t   activation, kind = uint32_t( StepKind::Dense );
+            Core::real param0, param1;
+            for( auto &&field : fields ) {
+                if( !readPod( in, field ) ) { return nullptr; }
+            }
+            if( !readPod( in, activation ) || !readPod( in, param0 ) || !readPod( in, param1 ) ||
+                (version >= 2 && !readPod( in, kind )) ) {
+                return nullptr;
+            }
+
+            // a matrix step needs at least the bias row and one destination, the kernels count down from them
+            const bool activate    = kind == uint32_t( StepKind::Activate );
+            uint64_t   weightCount = 0;
+            if( (!activate && (fields[ 1 ] < 1 || fields[ 3 ] < 1)) ||
+                (!activate && !checkedMul( fields[ 1 ], fields[ 3 ], weightCount )) ||
+                !withinCount( fields[ 0 ], fields[ 1 ], counts[ 4 ] ) ||
+                !withinCount( fields[ 2 ], fields[ 3 ], counts[ 4 ] ) ||
+                !withinCount( fields[ 4 ], weightCount, counts[ 5 ] ) ) {
+                return nullptr;
+            }
+
+            Model::Step step{ fields[ 0 ], fields[ 1 ], fields[ 2 ], fields[ 3 ], fields[ 4 ],
+                              Core::ActivationKernel( activation ), param0, param1 };
+            step.kind = StepKind( kind );
+            if( activation > uint32_t( Core::ActivationKernel::ReLU ) ||
+                kind > uint32_t( StepKind::Activate ) ||
+                (activate && (step.srcNeuronIndex != step.dstNeuronIndex ||
+                              step.srcNeuronCount != step.dstNeuronCount)) ) {
+                return nullptr;
+            }
+            if( activate ) {
+                model->steps.push_back( step );
+                continue;
+            }
+
+            unpacked.resize( weightCount );
+            if( !in.read( reinterpret_cast<char *>( unpacked.data( ) ), weightCount * sizeof( Core::real ) ) ) {
+                return nullptr;
+            }
+            model->alu->packPanels( step.srcNeuronCount, step.dstNeuronCount, unpacked.data( ), step.dstNeuronCount,
+                                    false, model->panelWidth, model->weights + step.weightIndex );
+            model->steps.push_back( step );
+            ranges.emplace_back( fields[ 4 ], weightCount );
+        }
+
+        // the steps weights must tile the buffer, no overlap and none left uninitialised
+        std::sort( ranges.begin( ), ranges.end( ) );
+        uint64_t covered = 0;
+        for( auto &&range : ranges ) {
+            if( range.first != covered ) { return nullptr; }
+            covered += range.second;
+        }
+        return (covered == counts[ 5 ]) ? model : nullptr;
+    }
+
+    Model::shared_ptr Model::load( const std::string &filename ) {
+        std::ifstream in( filename, std::ios::binary );
+        return in ? load( in ) : nullptr;
+    }
+
+    InferenceSession::InferenceSession( const Model::shared_ptr _model, const size_t _maxBatchSize ) :
+            model( _model ),
+            maxBatchSize( _maxBatchSize ),
+            capacity( 0 ),
+            activations( nullptr ) {
+        assert( model );
+        assert( maxBatchSize > 0 );
+        reserve( model->getTotalNeuronCount( ) );
+    }
+
+    InferenceSession::InferenceSession( const size_t _maxBatchSize ) :
+            model( nullptr ),
+            maxBatchSize( _maxBatchSize ),
+            capacity( 0 ),
+            activations( nullptr ) {
+        assert( maxBatchSize > 0 );
+    }
+
+    InferenceSession::~InferenceSession() {
+        auto alu = Core::VectorALUFactory( );
+        if( activations != nullptr ) { alu->deleteRealVector( activations ); }
+    }
+
+    void InferenceSession::reserve( const size_t neuronCount ) {
+        if( neuronCount <= capacity ) {
+            return;
+        }
+
+        auto alu = Core::VectorALUFactory( );
+        if( activations != nullptr ) { alu->deleteRealVector( activations ); }
+        capacity    = neuronCount;
+        activations = alu->newRealVector( capacity * maxBatchSize );
+        alu->set( capacity * maxBatchSize, Core::real( 0 ), activations );
+    }
+
+    void InferenceSession::evaluate( Core::VectorALU::const_real_array_ptr input,
+                                     Core::VectorALU::real_array_ptr results ) {
+        assert( model ); // a model less session only has evaluate( const Model &... )
+        model->evaluate( 1, input, activations, results );
+    }
+
+    void InferenceSession::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                                     Core::VectorALU::real_array_ptr results ) {
+        assert( model );
+        assert( batchSize <= maxBatchSize );
+        model->evaluate( batchSize, inputs, activations, results );
+    }
+
+    void InferenceSession::evaluate( const Model &other, const size_t batchSize,
+                                     Core::VectorALU::const_real_array_ptr inputs,
+                                     Core::VectorALU::real_array_ptr results ) {
+        assert( batchSize <= maxBatchSize );
+        reserve( other.getTotalNeuronCount( ) );
+        other.evaluate( batchSize, inputs, activations, results );
+    }
+}
@@ -0,0 +1,154 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/core.h"
+#include "core/vectoralu.h"
+
+namespace MachineLearning {
+
+    /*
+     * An immutable snapshot of a finalised network, just its topology and packed weights. Once created nothing
+     * writes to it so any number of threads can evaluate against the one copy of the weights, each through its own
+     * InferenceSession which owns the activation buffers.
+     */
+    class Model {
+    public:
+        friend class ANNetwork;
+
+        using shared_ptr = std::shared_ptr<const Model>;
+
+        // Dense sets dst = act( src * weights + bias ) through the fused panel kernel, Accumulate adds
+        // src * weights + bias to dst (a layer with several inbound connections) and Activate applies act to dst in
+        // place once they're all summed. Activate has src == dst and no weights
+        enum class StepKind : uint8_t {
+            Dense,
+            Accumulate,
+            Activate
+        };
+
+        struct Step {
+            size_t                 srcNeuronIndex;
+            size_t                 srcNeuronCount;  // including the bias neuron
+            size_t                 dstNeuronIndex;
+            size_t                 dstNeuronCount;
+            size_t                 weightIndex;
+            Core::ActivationKernel activation;
+            Core::real             param0;
+            Core::real             param1;
+            StepKind               kind = StepKind::Dense;
+        };
+
+        ~Model();
+
+        Model( const Model & ) = delete;
+
+        Model &operator=( const Model & ) = delete;
+
+        size_t getInputCount() const { return inputCount; }
+
+        size_t getInputNeuronIndex() const { return inputNeuronIndex; }
+
+        size_t getOutputCount() const { return outputCount; }
+
+        size_t getOutputNeuronIndex() const { return outputNeuronIndex; }
+
+        size_t getTotalNeuronCount() const { return totalNeuronCount; }
+
+        size_t getTotalWeightCount() const { return totalWeightCount; }
+
+        const std::vector<Step> &getSteps() const { return steps; }
+
+        // every step Dense and each reading the one before, a plain layer chain
+        bool isChain() const;
+
+        // what one more resident model costs, the packed weights and the step list
+        size_t getMemoryBytes() const {
+            return sizeof( Model ) + (totalWeightCount * sizeof( Core::real )) + (steps.capacity( ) * sizeof( Step ));
+        }
+
+        // a steps weights unpacked to the public ordering, srcNeuronCount x dstNeuronCount with the bias row last.
+        // empty for Activate steps
+        std::vector<Core::real> getStepWeights( const Step &step ) const;
+
+        // activations is a session owned scratch of batchSize rows of totalNeuronCount
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr activations, Core::VectorALU::real_array_ptr results ) const;
+
+        // binary model file. weights are stored in the public ordering (per step, source neuron major with the bias
+        // row last) so files don't depend on the panel width of the ALU that wrote them. loads version 1 files too
+        bool save( std::ostream &out ) const;
+
+        bool save( const std::string &filename ) const;
+
+        // returns nullptr if the stream isn't a valid model file
+        static shared_ptr load( std::istream &in );
+
+        static shared_ptr load( const std::string &filename );
+
+    private:
+        Model();
+
+        std::shared_ptr<Core::VectorALU> alu;
+
+        size_t inputCount;
+        size_t inputNeuronIndex;
+        size_t outputCount;
+        size_t outputNeuronIndex;
+        size_t totalNeuronCount;
+        size_t totalWeightCount;
+        size_t panelWidth;
+
+        std::vector<Step>               steps;
+        Core::VectorALU::real_array_ptr weights; // packed exactly as the source ANNetwork packs them
+    };
+
+    /*
+     * Per thread evaluation state for a shared Model, memory is maxBatchSize * the models neuron count
+     */
+    class InferenceSession {
+    public:
+        InferenceSession( const Model::shared_ptr _model, const size_t _maxBatchSize = 1 );
+
+        // a session not tied to a model, only usable with evaluate( const Model &... )
+        InferenceSession( const size_t _maxBatchSize = 1 );
+
+        ~InferenceSession();
+
+        InferenceSession( const InferenceSession & ) = delete;
+
+        InferenceSession &operator=( const InferenceSession & ) = delete;
+
+        // these two need the session's own model
+        void evaluate( Core::VectorALU::const_real_array_ptr input, Core::VectorALU::real_array_ptr results );
+
+        // inputs and results are packed one sample after another
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results );
+
+        // evaluate against another model, e.g. the latest one from a ModelPublisher. the activation buffer grows if
+        // that model is bigger, so a serving thread keeps one session across model swaps
+        void evaluate( const Model &other, const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results );
+
+        const Model::shared_ptr &getModel() const { return model; }
+
+        size_t getMaxBatchSize() const { return maxBatchSize; }
+
+        size_t getMemoryBytes() const { return capacity * maxBatchSize * sizeof( Core::real ); }
+
+    private:
+        void reserve( const size_t neuronCount );
+
+        const Model::shared_ptr         model;
+        const size_t                    maxBatchSize;
+        size_t                          capacity; // in neurons per sample
+        Core::VectorALU::real_array_ptr activations;
+    };
+}
@@ -0,0 +1,109 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/ANNetwork.h"
+#include "machinelearning/modelpublisher.h"
+
+namespace MachineLearning {
+
+    // readers store their pinned epoch then load the current snapshot, the publisher swaps the snapshot, bumps the
+    // epoch and then scans the reader slots. All of these are seq_cst so either the scan sees a reader pinned at (or
+    // before) the retire epoch and keeps the snapshot alive, or that reader's load is ordered after the swap and
+    // can only see the new snapshot.
+
+    const Model *ModelPublisher::Reader::acquire() {
+        assert( slot.epoch.load( std::memory_order_relaxed ) == idleEpoch );
+        slot.epoch.store( publisher.globalEpoch.load( ) );
+        const auto snapshot = publisher.current.load( );
+        return (snapshot != nullptr) ? snapshot->model.get( ) : nullptr;
+    }
+
+    void ModelPublisher::Reader::release() {
+        slot.epoch.store( idleEpoch, std::memory_order_release );
+    }
+
+    ModelPublisher::Reader::~Reader() {
+        assert( slot.epoch.load( std::memory_order_relaxed ) == idleEpoch );
+        std::lock_guard<std::mutex> lock( publisher.writerMutex );
+        slot.inUse = false;
+    }
+
+    ModelPublisher::ModelPublisher( const Model::shared_ptr initial ) :
+            current( (initial != nullptr) ? new Snapshot{ initial, 0 } : nullptr ),
+            globalEpoch( 1 ) {
+    }
+
+    ModelPublisher::~ModelPublisher() {
+        assert( std::none_of( slots.begin( ), slots.end( ), []( const std::unique_ptr<ReaderSlot> &slot ) {
+            return slot->inUse;
+        } ) );
+        for( auto &&snapshot : retired ) {
+            delete snapshot;
+        }
+        delete current.load( );
+    }
+
+    std::unique_ptr<ModelPublisher::Reader> ModelPublisher::createReader() {
+        std::lock_guard<std::mutex> lock( writerMutex );
+
+        auto it = std::find_if( slots.begin( ), slots.end( ), []( const std::unique_ptr<ReaderSlot> &slot ) {
+            return !slot->inUse;
+        } );
+        if( it == slots.end( ) ) {
+            slots.push_back( std::unique_ptr<ReaderSlot>( new ReaderSlot( ) ) );
+            it = slots.end( ) - 1;
+        }
+        (*it)->inUse = true;
+        return std::unique_ptr<Reader>( new Reader( *this, **it ) );
+    }
+
+    void ModelPublisher::publish( const Model::shared_ptr model ) {
+        CORE_TRACE_SCOPE( "ModelPublisher::publish" );
+        std::lock_guard<std::mutex> lock( writerMutex );
+
+        auto old = current.exchange( new Snapshot{ model, 0 } );
+        if( old != nullptr ) {
+            old->retireEpoch = globalEpoch.fetch_add( 1 );
+            retired.push_back( old );
+        } else {
+            globalEpoch.fetch_add( 1 );
+        }
+        reclaimLocked( );
+    }
+
+    void ModelPublisher::publish( const ANNetwork &network ) {
+        publish( network.createModel( ) );
+    }
+
+    size_t ModelPublisher::reclaim() {
+        std::lock_guard<std::mutex> lock( writerMutex );
+        return reclaimLocked( );
+    }
+
+    size_t ModelPublisher::getPendingCount() const {
+        std::lock_guard<std::mutex> lock( writerMutex );
+        return retired.size( );
+    }
+
+    size_t ModelPublisher::reclaimLocked() {
+        // the oldest epoch any reader is pinned at, readers pinned after a retire can't have seen that snapshot
+        uint64_t    oldestPinned = idleEpoch;
+        for( auto &&slot : slots ) {
+            oldestPinned = std::min( oldestPinned, slot->epoch.load( ) );
+        }
+
+        auto keep = std::partition( retired.begin( ), retired.end( ), [ oldestPinned ]( const Snapshot *snapshot ) {
+            return snapshot->retireEpoch >= oldestPinned;
+        } );
+        for( auto it = keep; it != retired.end( ); ++it ) {
+            delete *it;
+        }
+        retired.erase( keep, retired.end( ) );
+        return retired.size( );
+    }
+}
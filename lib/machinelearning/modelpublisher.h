@@ -0,0 +1,119 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/model.h"
+
+namespace MachineLearning {
+
+    class ANNetwork;
+
+    /*
+     * RCU style publication of Model snapshots from a trainer to serving threads.
+     * Readers pin the current epoch and load the newest model with no locks, no reference count traffic and no
+     * retry loop, so acquiring is wait free. Publishing swaps the pointer and retires the old snapshot, which is only
+     * released once every reader that could have seen it has moved on (epoch based reclamation).
+     */
+    class ModelPublisher {
+    private:
+        struct alignas( 64 ) ReaderSlot {
+            std::atomic<uint64_t> epoch{ idleEpoch };
+            bool                  inUse = false; // only touched under the publishers mutex
+        };
+
+        struct Snapshot {
+            Model::shared_ptr model;
+            uint64_t          retireEpoch;
+        };
+
+        static constexpr uint64_t idleEpoch = UINT64_MAX;
+
+    public:
+        // each serving thread registers once and reuses its reader for every request
+        class Reader {
+        public:
+            friend class ModelPublisher;
+
+            ~Reader();
+
+            Reader( const Reader & ) = delete;
+
+            Reader &operator=( const Reader & ) = delete;
+
+            // the returned model stays valid until release, acquires don't nest
+            const Model *acquire();
+
+            void release();
+
+        private:
+            Reader( ModelPublisher &_publisher, ReaderSlot &_slot ) : publisher( _publisher ), slot( _slot ) { }
+
+            ModelPublisher &publisher;
+            ReaderSlot     &slot;
+        };
+
+        class ReadGuard {
+        public:
+            ReadGuard( Reader &_reader ) : reader( _reader ), model( _reader.acquire( ) ) { }
+
+            ~ReadGuard() { reader.release( ); }
+
+            ReadGuard( const ReadGuard & ) = delete;
+
+            ReadGuard &operator=( const ReadGuard & ) = delete;
+
+            const Model *get() const { return model; }
+
+            const Model &operator*() const { return *model; }
+
+            const Model *operator->() const { return model; }
+
+            explicit operator bool() const { return model != nullptr; }
+
+        private:
+            Reader      &reader;
+            const Model *model;
+        };
+
+        ModelPublisher( const Model::shared_ptr initial = nullptr );
+
+        // all readers must have been destroyed first
+        ~ModelPublisher();
+
+        ModelPublisher( const ModelPublisher & ) = delete;
+
+        ModelPublisher &operator=( const ModelPublisher & ) = delete;
+
+        std::unique_ptr<Reader> createReader();
+
+        void publish( const Model::shared_ptr model );
+
+        // snapshot the networks current weights and publish them
+        void publish( const ANNetwork &network );
+
+        // releases every retired snapshot no reader can still see, returns how many are still pending
+        size_t reclaim();
+
+        size_t getPendingCount() const;
+
+        uint64_t getEpoch() const { return globalEpoch.load( std::memory_order_relaxed ); }
+
+    private:
+        size_t reclaimLocked();
+
+        std::atomic<Snapshot *>  current;
+        std::atomic<uint64_t>    globalEpoch;
+
+        mutable std::mutex                       writerMutex; // publishers and reader (un)registration only
+        std::vector<std::unique_ptr<ReaderSlot>> slots;
+        std::vector<Snapshot *>                  retired;
+    };
+}
@@ -0,0 +1,87 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/optimizer.h"
+
+namespace MachineLearning {
+
+    Optimizer::~Optimizer() {
+        releaseState( );
+    }
+
+    void Optimizer::allocate( const size_t _weightCount ) {
+        auto alu = Core::VectorALUFactory( );
+
+        releaseState( );
+        weightCount = _weightCount;
+        for( size_t i = 0; i < getStateBufferCount( ); ++i ) {
+            auto buffer = alu->newRealVector( weightCount );
+            alu->set( weightCount, Core::real( 0 ), buffer );
+            stateBuffers.push_back( buffer );
+        }
+    }
+
+    void Optimizer::releaseState() {
+        auto alu = Core::VectorALUFactory( );
+
+        for( auto &&buffer : stateBuffers ) {
+            alu->deleteRealVector( buffer );
+        }
+        stateBuffers.clear( );
+    }
+
+    void MomentumOptimizer::step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                                  const Core::real learningRate, const Core::real gradScale ) {
+        CORE_TRACE_SCOPE( "MomentumOptimizer::step" );
+        assert( stateBuffers.size( ) == 1 );
+
+        auto alu = Core::VectorALUFactory( );
+        alu->momentumStep( weightCount, learningRate, momentum, nesterov, gradScale, weights, gradients,
+                           stateBuffers[ 0 ] );
+    }
+
+    void RMSPropOptimizer::step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                                 const Core::real learningRate, const Core::real gradScale ) {
+        CORE_TRACE_SCOPE( "RMSPropOptimizer::step" );
+        assert( stateBuffers.size( ) == 1 );
+
+        auto alu = Core::VectorALUFactory( );
+        alu->rmsPropStep( weightCount, learningRate, decay, epsilon, gradScale, weights, gradients,
+                          stateBuffers[ 0 ] );
+    }
+
+    void AdamOptimizer::step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                              const Core::real learningRate, const Core::real gradScale ) {
+        CORE_TRACE_SCOPE( "AdamOptimizer::step" );
+        assert( stateBuffers.size( ) == 2 );
+
+        ++timestep;
+        // fold both bias corrections into the step size so the kernel stays a single pass
+        const auto t          = static_cast<Core::real>(timestep);
+        const auto correction = std::sqrt( Core::real( 1 ) - std::pow( beta2, t ) ) /
+                                (Core::real( 1 ) - std::pow( beta1, t ));
+
+        auto alu = Core::VectorALUFactory( );
+        alu->adamStep( weightCount, learningRate * correction, beta1, beta2, epsilon, gradScale, weights, gradients,
+                       stateBuffers[ 0 ], stateBuffers[ 1 ] );
+    }
+
+    Optimizer::shared_ptr OptimizerFactory( const OptimizerType type, const Core::real momentum ) {
+        switch( type ) {
+            case OptimizerType::Momentum:
+                return std::make_shared<MomentumOptimizer>( momentum, false );
+            case OptimizerType::Nesterov:
+                return std::make_shared<MomentumOptimizer>( momentum, true );
+            case OptimizerType::RMSProp:
+                return std::make_shared<RMSPropOptimizer>( );
+            case OptimizerType::Adam:
+                return std::make_shared<AdamOptimizer>( );
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,134 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "core/core.h"
+#include "core/vectoralu.h"
+
+namespace MachineLearning {
+
+    enum class OptimizerType : uint8_t {
+        Momentum,
+        Nesterov,
+        RMSProp,
+        Adam
+    };
+
+    /*
+     * An optimizer turns the accumulated gradients into a weight update. Each step is a single fused pass over the
+     * flat weight array, the gradients and whatever per weight state the optimizer keeps (velocity, moments...).
+     * State is allocated by ANNetwork::finalise( true ) via allocate.
+     */
+    class Optimizer {
+    public:
+        using shared_ptr = std::shared_ptr<Optimizer>;
+
+        virtual ~Optimizer();
+
+        // the state buffers are owned, a copy would free them twice
+        Optimizer( const Optimizer & ) = delete;
+
+        Optimizer &operator=( const Optimizer & ) = delete;
+
+        virtual OptimizerType getOptimizerType() const = 0;
+
+        // how many weight sized state arrays this optimizer needs
+        virtual size_t getStateBufferCount() const = 0;
+
+        void allocate( const size_t _weightCount );
+
+        // gradScale is applied to the gradients as they are read (1/sample count for an averaged batch)
+        // the gradients are zeroed by the step ready for the next accumulation
+        virtual void step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                           const Core::real learningRate, const Core::real gradScale ) = 0;
+
+        size_t getWeightCount() const { return weightCount; }
+
+        size_t getStateBytes() const { return stateBuffers.size( ) * weightCount * sizeof( Core::real ); }
+
+        // frees the per weight state, allocate again before the next step
+        void releaseState();
+
+    protected:
+        Optimizer() = default;
+
+        size_t                                       weightCount = 0;
+        std::vector<Core::VectorALU::real_array_ptr> stateBuffers;
+    };
+
+    // classic and Nesterov momentum, v = mu * v - eta * g
+    class MomentumOptimizer : public Optimizer {
+    public:
+        MomentumOptimizer( const Core::real _momentum, const bool _nesterov = false ) :
+                momentum( _momentum ),
+                nesterov( _nesterov ) {
+        }
+
+        OptimizerType getOptimizerType() const override {
+            return nesterov ? OptimizerType::Nesterov : OptimizerType::Momentum;
+        }
+
+        size_t getStateBufferCount() const override { return 1; }
+
+        void step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                   const Core::real learningRate, const Core::real gradScale ) override;
+
+        Core::real getMomentum() const { return momentum; }
+
+        void setMomentum( const Core::real _momentum ) { momentum = _momentum; }
+
+    private:
+        Core::real momentum;
+        const bool nesterov;
+    };
+
+    class RMSPropOptimizer : public Optimizer {
+    public:
+        RMSPropOptimizer( const Core::real _decay = Core::real( 0.9 ), const Core::real _epsilon = Core::real( 1e-7 ) ) :
+                decay( _decay ),
+                epsilon( _epsilon ) {
+        }
+
+        OptimizerType getOptimizerType() const override { return OptimizerType::RMSProp; }
+
+        size_t getStateBufferCount() const override { return 1; }
+
+        void step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                   const Core::real learningRate, const Core::real gradScale ) override;
+
+    private:
+        const Core::real decay;
+        const Core::real epsilon;
+    };
+
+    class AdamOptimizer : public Optimizer {
+    public:
+        AdamOptimizer( const Core::real _beta1 = Core::real( 0.9 ), const Core::real _beta2 = Core::real( 0.999 ),
+                       const Core::real _epsilon = Core::real( 1e-7 ) ) :
+                beta1( _beta1 ),
+                beta2( _beta2 ),
+                epsilon( _epsilon ) {
+        }
+
+        OptimizerType getOptimizerType() const override { return OptimizerType::Adam; }
+
+        size_t getStateBufferCount() const override { return 2; }
+
+        void step( Core::VectorALU::real_array_ptr weights, Core::VectorALU::real_array_ptr gradients,
+                   const Core::real learningRate, const Core::real gradScale ) override;
+
+    private:
+        const Core::real beta1;
+        const Core::real beta2;
+        const Core::real epsilon;
+        uint64_t         timestep = 0;
+    };
+
+    // optimizer with the default hyper parameters for its type, momentum only applies to Momentum and Nesterov
+    Optimizer::shared_ptr OptimizerFactory( const OptimizerType type, const Core::real momentum = Core::real( 0.9 ) );
+}
@@ -0,0 +1,213 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include "core/core.h"
+#include "machinelearning/piecewiselinearapproximator.h"
+
+namespace MachineLearning {
+
+    namespace {
+        // an interval of the input over which every neuron is an affine function of it
+        struct AffineSegment {
+            double              lo;
+            double              hi;
+            std::vector<double> slope;      // per neuron
+            std::vector<double> intercept;
+        };
+
+        bool IsPiecewiseLinear( const Core::ActivationKernel act ) {
+            return act == Core::ActivationKernel::Identity || act == Core::ActivationKernel::ReLU ||
+                   act == Core::ActivationKernel::Step;
+        }
+
+        bool SameLine( const double a, const double b ) {
+            return std::fabs( a - b ) <= 1e-12 * std::max( 1.0, std::max( std::fabs( a ), std::fabs( b ) ) );
+        }
+    }
+
+    PiecewiseLinearApproximator::shared_ptr PiecewiseLinearApproximator::fromModel( const Model &model,
+                                                                                    const Core::real lo,
+                                                                                    const Core::real hi,
+                                                                                    const size_t maxSegments ) {
+        assert( hi > lo );
+        const auto &steps = model.getSteps( );
+        if( model.getInputCount( ) != 1 || model.getOutputCount( ) != 1 || steps.empty( ) || !model.isChain( ) ) {
+            return nullptr;
+        }
+
+        const size_t               neuronCount = model.getTotalNeuronCount( );
+        std::vector<AffineSegment> segments{ AffineSegment{ lo, hi, std::vector<double>( neuronCount, 0.0 ),
+                                                            std::vector<double>( neuronCount, 0.0 ) } };
+        segments[ 0 ].slope[ model.getInputNeuronIndex( ) ] = 1.0;
+
+        for( size_t s = 0; s < steps.size( ); ++s ) {
+            const auto &step = steps[ s ];
+            // the output activation is applied at evaluation time, so it can be anything
+            const bool  last = (s == steps.size( ) - 1);
+            if( !last && !IsPiecewiseLinear( step.activation ) ) {
+                return nullptr;
+            }
+
+            const auto                 w = model.getStepWeights( step );
+            const size_t               k = step.srcNeuronCount, n = step.dstNeuronCount;
+            std::vector<AffineSegment> next;
+            std::vector<double>        preSlope( n ), preIntercept( n ), cuts;
+            for( auto &&seg : segments ) {
+                // pre activation of every destination as a line in x, the bias row adds to the intercept
+                for( size_t j = 0; j < n; ++j ) {
+                    double a = 0, b = w[ ((k - 1) * n) + j ];
+                    for( size_t i = 0; i < k - 1; ++i ) {
+                        a += w[ (i * n) + j ] * seg.slope[ step.srcNeuronIndex + i ];
+                        b += w[ (i * n) + j ] * seg.intercept[ step.srcNeuronIndex + i ];
+                    }
+                    preSlope[ j ]     = a;
+                    preIntercept[ j ] = b;
+                }
+
+                // split wherever a threshold is crossed inside the segment
+                cuts.assign( 1, seg.lo );
+                if( !last && step.activation != Core::ActivationKernel::Identity ) {
+                    for( size_t j = 0; j < n; ++j ) {
+                        if( preSlope[ j ] != 0.0 ) {
+                            const double x = (double( step.param0 ) - preIntercept[ j ]) / preSlope[ j ];
+                            if( x > seg.lo && x < seg.hi ) { cuts.push_back( x ); }
+                        }
+                    }
+                    std::sort( cuts.begin( ) + 1, cuts.end( ) );
+                }
+                cuts.push_back( seg.hi );
+
+                for( size_t c = 0; c + 1 < cuts.size( ); ++c ) {
+                    if( !(cuts[ c + 1 ] > cuts[ c ]) ) { continue; }
+                    AffineSegment piece{ cuts[ c ], cuts[ c + 1 ], seg.slope, seg.intercept };
+
+                    // which side of every threshold this piece is on, from its midpoint
+                    const double mid = 0.5 * (piece.lo + piece.hi);
+                    for( size_t j = 0; j < n; ++j ) {
+                        const double v = preIntercept[ j ] + (preSlope[ j ] * mid);
+                        double       a = preSlope[ j ], b = preIntercept[ j ];
+                        if( !last && step.activation == Core::ActivationKernel::ReLU && v < step.param0 ) {
+                            a = 0.0;
+                            b = step.param1;
+                        } else if( !last && step.activation == Core::ActivationKernel::Step ) {
+                            a = 0.0;
+                            b = (v > step.param0) ? 1.0 : 0.0;
+                        }
+                        piece.slope[ step.dstNeuronIndex + j ]     = a;
+                        piece.intercept[ step.dstNeuronIndex + j ] = b;
+                    }
+                    next.push_back( std::move( piece ) );
+                }
+                if( next.size( ) > maxSegments ) {
+                    return nullptr;
+                }
+            }
+            segments = std::move( next );
+        }
+
+        // neighbouring pieces on the same line (inactive units etc) become one
+        auto         approx = std::shared_ptr<PiecewiseLinearApproximator>( new PiecewiseLinearApproximator( ) );
+        const size_t out    = model.getOutputNeuronIndex( );
+        for( auto &&seg : segments ) {
+            const double a = seg.slope[ out ], b = seg.intercept[ out ];
+            if( !approx->starts.empty( ) ) {
+                const size_t prev = approx->starts.size( ) - 1;
+                if( SameLine( approx->pieces[ (2 * prev) + 1 ], a ) && SameLine( approx->pieces[ 2 * prev ], b ) ) {
+                    continue;
+                }
+            }
+            approx->starts.push_back( approx->starts.empty( ) ? std::numeric_limits<Core::real>::lowest( )
+                                                              : Core::real( seg.lo ) );
+            approx->pieces.push_back( Core::real( b ) );
+            approx->pieces.push_back( Core::real( a ) );
+        }
+
+        const auto &outStep = steps.back( );
+        approx->outputActivation = outStep.activation;
+        approx->outputParam0     = outStep.param0;
+        approx->outputParam1     = outStep.param1;
+        return approx;
+    }
+
+    void PiecewiseLinearApproximator::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                                                Core::VectorALU::real_array_ptr results ) {
+        auto alu = Core::VectorALUFactory( );
+
+        // branchless binary search, every sample of a slice takes the same steps so the inner loops vectorise
+        constexpr size_t slice = 256;
+        uint32_t         index[slice];
+        const size_t     count = starts.size( );
+        for( size_t first = 0; first < batchSize; first += slice ) {
+            const size_t     n = std::min( slice, batchSize - first );
+            const Core::real *x = inputs + first;
+            for( size_t i = 0; i < n; ++i ) { index[ i ] = 0; }
+            for( size_t len = count; len > 1; ) {
+                const size_t half = len / 2;
+                for( size_t i = 0; i < n; ++i ) {
+                    index[ i ] = (starts[ index[ i ] + half ] <= x[ i ]) ? uint32_t( index[ i ] + half ) : index[ i ];
+                }
+                len -= half;
+            }
+            for( size_t i = 0; i < n; ++i ) {
+                results[ first + i ] = pieces[ 2 * index[ i ] ] + (pieces[ (2 * index[ i ]) + 1 ] * x[ i ]);
+            }
+            alu->activate( n, outputActivation, outputParam0, outputParam1, results + first, results + first );
+        }
+    }
+
+    LookupTableApproximator::shared_ptr LookupTableApproximator::tabulate( Approximator &source,
+                                                                           const Core::real lo,
+                                                                           const Core::real hi,
+                                                                           const Core::real tolerance,
+                                                                           const size_t maxIntervals ) {
+        assert( hi > lo );
+        assert( tolerance > Core::real( 0 ) );
+        assert( source.getInputCount( ) == 1 && source.getOutputCount( ) == 1 );
+
+        std::vector<Core::real> xs, ys;
+        for( size_t intervals = 16; intervals <= maxIntervals; intervals *= 2 ) {
+            xs.resize( intervals + 1 );
+            ys.resize( intervals + 1 );
+            for( size_t i = 0; i <= intervals; ++i ) {
+                xs[ i ] = lo + ((hi - lo) * Core::real( i ) / Core::real( intervals ));
+            }
+            source.evaluate( xs.size( ), xs.data( ), ys.data( ) );
+
+            auto approx = std::shared_ptr<LookupTableApproximator>( new LookupTableApproximator( lo, hi, ys ) );
+            if( approx->maxError( source, lo, hi, std::max( size_t( 4096 ), (8 * intervals) + 1 ) ) <= tolerance ) {
+                return approx;
+            }
+        }
+        return nullptr;
+    }
+
+    LookupTableApproximator::LookupTableApproximator( const Core::real _lo, const Core::real hi,
+                                                      const std::vector<Core::real> &samples ) :
+            lo( _lo ),
+            invStep( Core::real( samples.size( ) - 1 ) / (hi - _lo) ),
+            maxPosition( Core::real( samples.size( ) - 1 ) ) {
+        assert( samples.size( ) >= 2 );
+        table.resize( 2 * (samples.size( ) - 1) );
+        for( size_t i = 0; i + 1 < samples.size( ); ++i ) {
+            table[ 2 * i ]       = samples[ i ];
+            table[ (2 * i) + 1 ] = samples[ i + 1 ] - samples[ i ];
+        }
+    }
+
+    void LookupTableApproximator::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                                            Core::VectorALU::real_array_ptr results ) {
+        const Core::real lastInterval = maxPosition - Core::real( 1 );
+        for( size_t i = 0; i < batchSize; ++i ) {
+            const Core::real s        = std::min( std::max( (inputs[ i ] - lo) * invStep, Core::real( 0 ) ),
+                                                  maxPosition );
+            const Core::real interval = std::min( std::floor( s ), lastInterval );
+            const Core::real *entry   = table.data( ) + (2 * size_t( interval ));
+            results[ i ] = entry[ 0 ] + (entry[ 1 ] * (s - interval));
+        }
+    }
+}
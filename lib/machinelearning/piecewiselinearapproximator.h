@@ -0,0 +1,97 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "core/core.h"
+#include "core/vectoralu.h"
+#include "machinelearning/approximator.h"
+#include "machinelearning/model.h"
+
+namespace MachineLearning {
+
+    /*
+     * The exact form of a 1 input 1 output network whose hidden layers are all ReLU, Step or Linear: every such
+     * network is piecewise linear in its input before the output activation. fromModel walks the steps splitting
+     * [lo, hi] wherever a neurons pre activation crosses its threshold, so the result is a sorted breakpoint list
+     * with one affine piece per segment and the output kernel applied on top. The whole forward pass becomes a
+     * branchless binary search, a multiply add and the output activation.
+     * Outside [lo, hi] the end pieces are extended.
+     */
+    class PiecewiseLinearApproximator : public Approximator {
+    public:
+        using shared_ptr = std::shared_ptr<PiecewiseLinearApproximator>;
+
+        // nullptr if a hidden activation isn't piecewise linear, the model isn't a 1D chain or it has over maxSegments
+        static shared_ptr fromModel( const Model &model, const Core::real lo, const Core::real hi,
+                                     const size_t maxSegments = 1 << 20 );
+
+        size_t getInputCount() const override { return 1; }
+
+        size_t getOutputCount() const override { return 1; }
+
+        size_t getParameterCount() const override { return starts.size( ) * 3; }
+
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results ) override;
+
+        using Approximator::evaluate;
+
+        size_t getSegmentCount() const { return starts.size( ); }
+
+        // the interior breakpoints, where one piece ends and the next begins
+        std::vector<Core::real> getBreakpoints() const {
+            return std::vector<Core::real>( starts.begin( ) + 1, starts.end( ) );
+        }
+
+    private:
+        PiecewiseLinearApproximator() = default;
+
+        std::vector<Core::real> starts;  // segment i covers [starts[ i ], starts[ i + 1 ]), starts[ 0 ] is -inf
+        std::vector<Core::real> pieces;  // interleaved intercept, slope per segment
+
+        Core::ActivationKernel outputActivation;
+        Core::real             outputParam0;
+        Core::real             outputParam1;
+    };
+
+    /*
+     * A uniform table of source samples over [lo, hi] with linear interpolation between them, for sources that
+     * aren't exactly piecewise linear. The entry count doubles until sampling between the entries meets the
+     * tolerance, lookups are O(1): one index computation and a value, delta pair load per sample.
+     * Inputs outside [lo, hi] are clamped.
+     */
+    class LookupTableApproximator : public Approximator {
+    public:
+        using shared_ptr = std::shared_ptr<LookupTableApproximator>;
+
+        // source must be 1 input 1 output, nullptr if maxIntervals can't reach the tolerance
+        static shared_ptr tabulate( Approximator &source, const Core::real lo, const Core::real hi,
+                                    const Core::real tolerance, const size_t maxIntervals = 1 << 20 );
+
+        size_t getInputCount() const override { return 1; }
+
+        size_t getOutputCount() const override { return 1; }
+
+        size_t getParameterCount() const override { return table.size( ); }
+
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results ) override;
+
+        using Approximator::evaluate;
+
+        size_t getIntervalCount() const { return table.size( ) / 2; }
+
+    private:
+        LookupTableApproximator( const Core::real lo, const Core::real hi, const std::vector<Core::real> &samples );
+
+        Core::real lo;
+        Core::real invStep;
+        Core::real maxPosition; // the interval count, inputs clamp to [0, maxPosition] in table units
+
+        std::vector<Core::real> table; // interleaved value, delta to the next value per interval
+    };
+}
@@ -0,0 +1,369 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/pipelinetrainer.h"
+
+namespace MachineLearning {
+
+    PipelineTrainer::PipelineTrainer( ANNetwork &_network, const Config &_config ) :
+            network( _network ),
+            config( _config ),
+            microBatchSize( (_config.microBatchSize > 0) ? _config.microBatchSize : _network.maxBatchSize ),
+            stepMicroBatches( 0 ),
+            generation( 0 ),
+            running( 0 ),
+            stopping( false ) {
+        assert( network.gradients != nullptr );
+        assert( config.stageCount > 0 && config.microBatchCount > 0 );
+
+        // the chain in order, each level one layer fed by the one before
+        const auto          &connections = network.connections;
+        std::vector<size_t> chain;
+        for( auto &&level : network.levels ) {
+            assert( level.size( ) == 1 && network.inbound[ level.front( ) ].size( ) == 1 );
+            const auto c = network.inbound[ level.front( ) ].front( );
+            assert( connections[ c ]->from == (chain.empty( ) ? network.layers.front( ) :
+                                               connections[ chain.back( ) ]->to) );
+            chain.push_back( c );
+        }
+        assert( config.stageCount <= chain.size( ) );
+
+        // contiguous runs of roughly equal weight count, that's what the forward and backward work scales with. a
+        // connection goes to the stage holding most of it and every stage gets at least one
+        double total = 0.0;
+        for( auto &&c : chain ) { total += double( connections[ c ]->weightCount ); }
+
+        auto   alu        = Core::VectorALUFactory( );
+        size_t next       = 0;
+        double cumulative = 0.0;
+        for( size_t s = 0; s < config.stageCount; ++s ) {
+            const double target = total * double( s + 1 ) / double( config.stageCount );
+            auto         stage  = std::make_unique<Stage>( );
+            do {
+                cumulative += double( connections[ chain[ next ] ]->weightCount );
+                stage->connections.push_back( chain[ next++ ] );
+            } while( next < chain.size( ) - (config.stageCount - s - 1) &&
+                     ((s == config.stageCount - 1) ||
+                      (cumulative + (double( connections[ chain[ next ] ]->weightCount ) / 2.0) <= target)) );
+
+            // local rows hold the source of every connection then the last destination
+            stage->rowStride = 0;
+            for( auto &&c : stage->connections ) {
+                stage->layerIndex.push_back( stage->rowStride );
+                stage->rowStride += connections[ c ]->from->countOfNeurons( );
+            }
+            stage->layerIndex.push_back( stage->rowStride );
+            stage->rowStride += connections[ stage->connections.back( ) ]->to->countOfNeurons( );
+
+            // 1F1B keeps the warm up plus the one being worked on in flight
+            stage->slotCount = std::min( config.stageCount - s, config.microBatchCount );
+            const size_t rows = stage->slotCount * microBatchSize;
+            stage->outputs = alu->newRealVector( rows * stage->rowStride );
+            stage->sums    = alu->newRealVector( rows * stage->rowStride );
+            stage->deltas  = alu->newRealVector( microBatchSize * stage->rowStride );
+            alu->set( rows * stage->rowStride, Core::real( 0 ), stage->outputs );
+            alu->set( rows * stage->rowStride, Core::real( 0 ), stage->sums );
+            alu->set( microBatchSize * stage->rowStride, Core::real( 0 ), stage->deltas );
+
+            // bias neurons always output 1
+            for( size_t j = 0; j < stage->layerIndex.size( ); ++j ) {
+                const auto &layer = (j < stage->connections.size( )) ? connections[ stage->connections[ j ] ]->from :
+                                    connections[ stage->connections.back( ) ]->to;
+                if( !layer->isBiased( ) ) { continue; }
+                for( size_t r = 0; r < rows; ++r ) {
+                    stage->outputs[ (r * stage->rowStride) + stage->layerIndex[ j ] + layer->getActualNeuronCount( ) ] =
+                            Core::real( 1 );
+                }
+            }
+
+            // the next stage can be at most this many micro batches behind in either direction
+            if( s + 1 < config.stageCount ) {
+                const size_t boundary = connections[ stage->connections.back( ) ]->to->getActualNeuronCount( );
+                stage->down = std::make_unique<Queue>( config.stageCount - s );
+                stage->up   = std::make_unique<Queue>( config.stageCount - s );
+                for( auto &&queue : { stage->down.get( ), stage->up.get( ) } ) {
+                    queue->forEachElement( [ & ]( Message &message ) {
+                        message.values.assign( microBatchSize * boundary, Core::real( 0 ) );
+                    } );
+                }
+            }
+            stage->error = 0.0;
+            stages.push_back( std::move( stage ) );
+        }
+
+        stepSizes.assign( config.microBatchCount, 0 );
+        stepInputs.assign( config.microBatchCount * microBatchSize * network.getInputCount( ), Core::real( 0 ) );
+        stepPerfect.assign( config.microBatchCount * microBatchSize * network.getOutputCount( ), Core::real( 0 ) );
+
+        const size_t cores = std::max( std::thread::hardware_concurrency( ), 1u );
+        for( size_t s = 0; s < stages.size( ); ++s ) {
+            stages[ s ]->thread = std::thread( [ this, s ]() { stageLoop( s ); } );
+#ifdef __linux__
+            // best effort, a restricted cpu set just leaves the scheduler to it
+            if( config.pinThreads ) {
+                cpu_set_t cpus;
+                CPU_ZERO( &cpus );
+                CPU_SET( s % cores, &cpus );
+                pthread_setaffinity_np( stages[ s ]->thread.native_handle( ), sizeof( cpus ), &cpus );
+            }
+#else
+            (void) cores;
+#endif
+        }
+    }
+
+    PipelineTrainer::~PipelineTrainer() {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            stopping = true;
+        }
+        start.notify_all( );
+
+        auto alu = Core::VectorALUFactory( );
+        for( auto &&stage : stages ) {
+            stage->thread.join( );
+            alu->deleteRealVector( stage->outputs );
+            alu->deleteRealVector( stage->sums );
+            alu->deleteRealVector( stage->deltas );
+        }
+    }
+
+    size_t PipelineTrainer::getStageMemoryBytes( const size_t stage ) const {
+        const auto &s = *stages[ stage ];
+        return ((2 * s.slotCount) + 1) * microBatchSize * s.rowStride * sizeof( Core::real );
+    }
+
+    void PipelineTrainer::stageLoop( const size_t stage ) {
+        CORE_TRACE_THREAD_NAME( "PipelineStage" );
+
+        size_t seen = 0;
+        for( ;; ) {
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                start.wait( lock, [ this, seen ]() { return stopping || generation != seen; } );
+                if( stopping ) {
+                    return;
+                }
+                seen = generation;
+            }
+
+            runStep( stage );
+
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                --running;
+            }
+            done.notify_one( );
+        }
+    }
+
+    void PipelineTrainer::runStep( const size_t stage ) {
+        CORE_TRACE_SCOPE_ARG( "PipelineTrainer.stage", stage );
+
+        // the last stage alternates from the start, each one before it runs one more forward ahead to fill the pipe
+        const size_t count  = stepMicroBatches;
+        const size_t warmUp = std::min( stages.size( ) - stage - 1, count );
+        stages[ stage ]->error = 0.0;
+        for( size_t i = 0; i < warmUp; ++i ) { forward( stage, i ); }
+        for( size_t i = 0; i + warmUp < count; ++i ) {
+            forward( stage, i + warmUp );
+            backward( stage, i );
+        }
+        for( size_t i = count - warmUp; i < count; ++i ) { backward( stage, i ); }
+    }
+
+    void PipelineTrainer::forward( const size_t stage, const size_t microBatch ) {
+        CORE_TRACE_SCOPE_ARG( "PipelineTrainer.forward", microBatch );
+        auto alu = Core::VectorALUFactory( );
+
+        auto         &s          = *stages[ stage ];
+        const auto   &connects   = network.connections;
+        const size_t batchSize   = stepSizes[ microBatch ];
+        const size_t slot        = microBatch % s.slotCount;
+        const auto   outputs     = s.outputs + (slot * microBatchSize * s.rowStride);
+        const auto   sums        = s.sums + (slot * microBatchSize * s.rowStride);
+        const size_t sourceCount = connects[ s.connections.front( ) ]->from->getActualNeuronCount( );
+
+        // the first layers outputs are the inputs or come down from the stage before
+        if( stage == 0 ) {
+            const auto inputs = stepInputs.data( ) + (microBatch * microBatchSize * sourceCount);
+            for( size_t b = 0; b < batchSize; ++b ) {
+                alu->copy( sourceCount, inputs + (b * sourceCount), outputs + (b * s.rowStride) );
+            }
+        } else {
+            auto message = stages[ stage - 1 ]->down->beginPop( );
+            assert( message->microBatch == microBatch );
+            for( size_t b = 0; b < batchSize; ++b ) {
+                alu->copy( sourceCount, message->values.data( ) + (b * sourceCount), outputs + (b * s.rowStride) );
+            }
+            stages[ stage - 1 ]->down->endPop( );
+        }
+
+        for( size_t j = 0; j < s.connections.size( ); ++j ) {
+            const auto &connect = connects[ s.connections[ j ] ];
+            const auto &af      = connect->to->getActivationFunc( );
+            alu->packedDenseActivate( batchSize, connect->to->getActualNeuronCount( ), connect->from->countOfNeurons( ),
+                                      outputs + s.layerIndex[ j ], s.rowStride,
+                                      network.weights + connect->weightIndex, network.panelWidth,
+                                      af.getKernel( ), af.getKernelParam0( ), af.getKernelParam1( ),
+                                      sums + s.layerIndex[ j + 1 ], s.rowStride,
+                                      outputs + s.layerIndex[ j + 1 ], s.rowStride );
+        }
+
+        if( s.down ) {
+            const size_t boundary = connects[ s.connections.back( ) ]->to->getActualNeuronCount( );
+            auto         message  = s.down->beginPush( );
+            message->microBatch = microBatch;
+            for( size_t b = 0; b < batchSize; ++b ) {
+                alu->copy( boundary, outputs + (b * s.rowStride) + s.layerIndex.back( ),
+                           message->values.data( ) + (b * boundary) );
+            }
+            s.down->endPush( );
+        }
+    }
+
+    void PipelineTrainer::backward( const size_t stage, const size_t microBatch ) {
+        CORE_TRACE_SCOPE_ARG( "PipelineTrainer.backward", microBatch );
+        auto alu = Core::VectorALUFactory( );
+
+        auto         &s        = *stages[ stage ];
+        const auto   &connects = network.connections;
+        const size_t batchSize = stepSizes[ microBatch ];
+        const size_t slot      = microBatch % s.slotCount;
+        const auto   outputs   = s.outputs + (slot * microBatchSize * s.rowStride);
+        const auto   sums      = s.sums + (slot * microBatchSize * s.rowStride);
+        const auto   &last     = connects[ s.connections.back( ) ]->to;
+        const size_t lastCount = last->getActualNeuronCount( );
+
+        // the last layers deltas before f', against perfect at the end of the pipe else from the stage after
+        if( !s.up ) {
+            const auto perfect = stepPerfect.data( ) + (microBatch * microBatchSize * lastCount);
+            for( size_t b = 0; b < batchSize; ++b ) {
+                const auto delta = s.deltas + (b * s.rowStride) + s.layerIndex.back( );
+                alu->sub( lastCount, outputs + (b * s.rowStride) + s.layerIndex.back( ), perfect + (b * lastCount),
+                          delta );
+                s.error += double( alu->dot( lastCount, delta, delta ) );
+            }
+        } else {
+            auto message = s.up->beginPop( );
+            assert( message->microBatch == microBatch );
+            for( size_t b = 0; b < batchSize; ++b ) {
+                alu->copy( lastCount, message->values.data( ) + (b * lastCount),
+                           s.deltas + (b * s.rowStride) + s.layerIndex.back( ) );
+            }
+            s.up->endPop( );
+        }
+        for( size_t b = 0; b < batchSize; ++b ) {
+            const auto row = (b * s.rowStride) + s.layerIndex.back( );
+            alu->mulActivationDerivative( lastCount, last->getActivationFunc( ).getKernel( ),
+                                          last->getActivationFunc( ).getKernelParam0( ), sums + row, s.deltas + row );
+        }
+
+        for( size_t j = s.connections.size( ) - 1; j < s.connections.size( ); --j ) {
+            const auto   &connect  = connects[ s.connections[ j ] ];
+            const auto   &src      = connect->from;
+            const size_t srcCount  = src->getActualNeuronCount( );
+            const size_t dstCount  = connect->to->getActualNeuronCount( );
+            const auto   dstDeltas = s.deltas + s.layerIndex[ j + 1 ];
+
+            // this stages share of the step's gradients, no other stage touches these weights
+            alu->packedOuterAccumulate( batchSize, src->countOfNeurons( ), dstCount,
+                                        outputs + s.layerIndex[ j ], s.rowStride,
+                                        dstDeltas, s.rowStride,
+                                        network.panelWidth, network.gradients + connect->weightIndex );
+
+            // W^T deltas into the layer below, or up to the stage before. nothing needs the inputs deltas
+            Message                         *message = nullptr;
+            Core::VectorALU::real_array_ptr target;
+            size_t                          ldTarget;
+            if( j > 0 ) {
+                target   = s.deltas + s.layerIndex[ j ];
+                ldTarget = s.rowStride;
+            } else if( stage > 0 ) {
+                message             = stages[ stage - 1 ]->up->beginPush( );
+                message->microBatch = microBatch;
+                target              = message->values.data( );
+                ldTarget            = srcCount;
+            } else {
+                break;
+            }
+
+            if( network.backpropWeights != nullptr ) {
+                alu->packedGemm( batchSize, srcCount, dstCount, dstDeltas, s.rowStride,
+                                 network.backpropWeights + connect->weightIndex, network.panelWidth,
+                                 Core::real( 0 ), target, ldTarget );
+            } else {
+                alu->packedGemmTransposed( batchSize, srcCount, dstCount, dstDeltas, s.rowStride,
+                                           network.weights + connect->weightIndex, src->countOfNeurons( ),
+                                           network.panelWidth, Core::real( 0 ), target, ldTarget );
+            }
+
+            if( message != nullptr ) {
+                stages[ stage - 1 ]->up->endPush( );
+            } else {
+                for( size_t b = 0; b < batchSize; ++b ) {
+                    const auto row = (b * s.rowStride) + s.layerIndex[ j ];
+                    alu->mulActivationDerivative( srcCount, src->getActivationFunc( ).getKernel( ),
+                                                  src->getActivationFunc( ).getKernelParam0( ), sums + row,
+                                                  s.deltas + row );
+                }
+            }
+        }
+    }
+
+    PipelineTrainer::Result PipelineTrainer::trainEpoch( const std::vector<ANNetwork::MatchingPair> &set ) {
+        CORE_TRACE_SCOPE_ARG( "PipelineTrainer::trainEpoch", set.size( ) );
+        auto alu = Core::VectorALUFactory( );
+
+        const size_t inCount  = network.getInputCount( );
+        const size_t outCount = network.getOutputCount( );
+        const size_t stepSize = microBatchSize * config.microBatchCount;
+
+        Result result;
+        double err = 0.0;
+        for( size_t first = 0; first < set.size( ); first += stepSize ) {
+            const size_t samples = std::min( stepSize, set.size( ) - first );
+            stepMicroBatches = (samples + microBatchSize - 1) / microBatchSize;
+            for( size_t i = 0; i < samples; ++i ) {
+                alu->copy( inCount, set[ first + i ].first, stepInputs.data( ) + (i * inCount) );
+                alu->copy( outCount, set[ first + i ].second, stepPerfect.data( ) + (i * outCount) );
+            }
+            for( size_t m = 0; m < stepMicroBatches; ++m ) {
+                stepSizes[ m ] = std::min( microBatchSize, samples - (m * microBatchSize) );
+            }
+
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                ++generation;
+                running = stages.size( );
+            }
+            start.notify_all( );
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                done.wait( lock, [ this ]() { return running == 0; } );
+            }
+
+            // every stage has its gradients in, one update for the whole step
+            network.gradientSampleCount += samples;
+            network.updateWeights( );
+            err += stages.back( )->error;
+            result.samples += samples;
+            ++result.steps;
+        }
+
+        if( result.samples > 0 ) {
+            result.rms = Core::real( std::sqrt( err / double( result.samples * outCount ) ) );
+        }
+        return result;
+    }
+}
@@ -0,0 +1,116 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/core.h"
+#include "core/spscqueue.h"
+#include "machinelearning/ANNetwork.h"
+
+namespace MachineLearning {
+
+    /*
+     * Pipeline parallel SGD within one process. The layer chain is cut into stageCount contiguous stages of roughly
+     * equal weight count, each run by its own thread (pinned to its own core where the OS allows) with activation
+     * buffers for just its own layers. A step is microBatchCount micro batches: activations flow down the pipeline
+     * and deltas back up through bounded single producer single consumer queues, and every stage runs one forward
+     * one backward (1F1B) once it is full, so stage s never holds more than stageCount - s micro batches in flight.
+     * Each stage accumulates the gradients of its own connections over the step, then the weights are updated once,
+     * so a step is exactly one batch of microBatchSize * microBatchCount samples up to summation order.
+     * The network must be a plain chain finalised for training.
+     */
+    class PipelineTrainer {
+    public:
+        struct Config {
+            size_t stageCount      = 2;
+            size_t microBatchSize  = 0;    // 0 is the network's maxBatchSize
+            size_t microBatchCount = 4;    // per step, more hides the fill and drain bubbles better
+            bool   pinThreads      = true; // stage s on core s, wrapping
+        };
+
+        struct Result {
+            size_t     steps   = 0;
+            size_t     samples = 0;
+            Core::real rms     = Core::real( 0 );
+        };
+
+        PipelineTrainer( ANNetwork &network, const Config &config );
+
+        ~PipelineTrainer();
+
+        PipelineTrainer( const PipelineTrainer & ) = delete;
+
+        PipelineTrainer &operator=( const PipelineTrainer & ) = delete;
+
+        // one pass over the set in order, steps of up to microBatchSize * microBatchCount samples
+        Result trainEpoch( const std::vector<ANNetwork::MatchingPair> &set );
+
+        size_t getStageCount() const { return stages.size( ); }
+
+        // how many connections of the chain a stage runs, from the input end
+        size_t getStageConnectionCount( const size_t stage ) const { return stages[ stage ]->connections.size( ); }
+
+        // a stages activation, pre activation and delta buffers
+        size_t getStageMemoryBytes( const size_t stage ) const;
+
+    private:
+        // a micro batch crossing between two stages, the boundary layers outputs going down or deltas coming up
+        struct Message {
+            size_t                  microBatch;
+            std::vector<Core::real> values;
+        };
+
+        using Queue = Core::SpscQueue<Message>;
+
+        struct Stage {
+            std::vector<size_t> connections; // network connection indices, in chain order
+            std::vector<size_t> layerIndex;  // local neuron index of the source of each connection, then the last dst
+            size_t              rowStride;   // local neurons per sample, bias neurons included
+            size_t              slotCount;   // micro batches in flight at most
+
+            Core::VectorALU::real_array_ptr outputs; // slotCount * microBatchSize rows
+            Core::VectorALU::real_array_ptr sums;    // slotCount * microBatchSize rows
+            Core::VectorALU::real_array_ptr deltas;  // microBatchSize rows, a backward pass runs start to finish
+
+            std::unique_ptr<Queue> down; // activations to the next stage, nullptr on the last
+            std::unique_ptr<Queue> up;   // deltas back from the next stage, nullptr on the last
+
+            double      error; // sum of squares over the step, last stage only
+            std::thread thread;
+        };
+
+        void stageLoop( const size_t stage );
+
+        // this stages share of the current step in 1F1B order
+        void runStep( const size_t stage );
+
+        void forward( const size_t stage, const size_t microBatch );
+
+        void backward( const size_t stage, const size_t microBatch );
+
+        ANNetwork    &network;
+        const Config config;
+        size_t       microBatchSize;
+
+        std::vector<std::unique_ptr<Stage>> stages;
+
+        // the current step, written before it starts and only read by the stages
+        size_t                  stepMicroBatches;
+        std::vector<size_t>     stepSizes;   // samples in each micro batch
+        std::vector<Core::real> stepInputs;  // microBatchCount * microBatchSize rows of the network's inputs
+        std::vector<Core::real> stepPerfect; // likewise of its outputs
+
+        std::mutex              mutex;
+        std::condition_variable start;      // a new step or stopping
+        std::condition_variable done;       // a stage finished its step
+        size_t                  generation; // under mutex, bumped for every step
+        size_t                  running;    // under mutex, stages still in the step
+        bool                    stopping;   // under mutex
+    };
+}
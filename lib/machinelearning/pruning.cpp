@@ -0,0 +1,183 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include "core/core.h"
+#include "core/trace.h"
+#include "machinelearning/pruning.h"
+#include "machinelearning/inputlayer.h"
+#include "machinelearning/hiddenlayer.h"
+#include "machinelearning/outputlayer.h"
+
+namespace MachineLearning {
+
+    namespace {
+        // mean and score of every neuron of the model, indexed like its activations
+        struct NeuronStatistics {
+            std::vector<double> mean;
+            std::vector<double> score;
+        };
+
+        NeuronStatistics CollectStatistics( const Model &model,
+                                            const std::vector<ANNetwork::MatchingPair> &calibration ) {
+            assert( calibration.size( ) > 0 );
+            auto alu = Core::VectorALUFactory( );
+
+            const size_t neuronCount = model.getTotalNeuronCount( );
+            const size_t inCount     = model.getInputCount( );
+            const size_t outCount    = model.getOutputCount( );
+            const size_t slice       = 64;
+
+            std::vector<Core::real> inputs( slice * inCount ), results( slice * outCount );
+            std::vector<Core::real> activations( slice * neuronCount, Core::real( 0 ) );
+            std::vector<double>     sum( neuronCount, 0.0 ), sumSquares( neuronCount, 0.0 );
+            for( size_t first = 0; first < calibration.size( ); first += slice ) {
+                const size_t batchSize = std::min( slice, calibration.size( ) - first );
+                for( size_t b = 0; b < batchSize; ++b ) {
+                    alu->copy( inCount, calibration[ first + b ].first, inputs.data( ) + (b * inCount) );
+                }
+                model.evaluate( batchSize, inputs.data( ), activations.data( ), results.data( ) );
+
+                for( size_t b = 0; b < batchSize; ++b ) {
+                    const Core::real *row = activations.data( ) + (b * neuronCount);
+                    for( size_t i = 0; i < neuronCount; ++i ) {
+                        sum[ i ] += row[ i ];
+                        sumSquares[ i ] += double( row[ i ] ) * double( row[ i ] );
+                    }
+                }
+            }
+
+            NeuronStatistics stats;
+            stats.mean.resize( neuronCount );
+            stats.score.assign( neuronCount, 0.0 );
+            const double invCount = 1.0 / double( calibration.size( ) );
+            for( size_t i = 0; i < neuronCount; ++i ) { stats.mean[ i ] = sum[ i ] * invCount; }
+
+            // a source neurons score is its activation spread times the norm of its row of outgoing weights
+            for( auto &&step : model.getSteps( ) ) {
+                const auto w = model.getStepWeights( step );
+                for( size_t i = 0; i + 1 < step.srcNeuronCount; ++i ) {
+                    const size_t neuron   = step.srcNeuronIndex + i;
+                    const double variance = std::max( 0.0, (sumSquares[ neuron ] * invCount) -
+                                                           (stats.mean[ neuron ] * stats.mean[ neuron ]) );
+                    double       norm     = 0.0;
+                    for( size_t j = 0; j < step.dstNeuronCount; ++j ) {
+                        norm += double( w[ (i * step.dstNeuronCount) + j ] ) * w[ (i * step.dstNeuronCount) + j ];
+                    }
+                    stats.score[ neuron ] = std::sqrt( variance * norm );
+                }
+            }
+            return stats;
+        }
+    }
+
+    std::vector<std::vector<Core::real>>
+    NeuronPruning::scoreNeurons( const ANNetwork &network, const std::vector<ANNetwork::MatchingPair> &calibration ) {
+        const auto model = network.createModel( );
+        assert( model->isChain( ) );
+        const auto stats = CollectStatistics( *model, calibration );
+
+        // every step but the last has a hidden layer as its destination
+        std::vector<std::vector<Core::real>> scores;
+        const auto                           &steps = model->getSteps( );
+        for( size_t s = 0; s + 1 < steps.size( ); ++s ) {
+            scores.emplace_back( );
+            for( size_t j = 0; j < steps[ s ].dstNeuronCount; ++j ) {
+                scores.back( ).push_back( Core::real( stats.score[ steps[ s ].dstNeuronIndex + j ] ) );
+            }
+        }
+        return scores;
+    }
+
+    std::unique_ptr<ANNetwork> NeuronPruning::prune( const ANNetwork &network,
+                                                     const std::vector<ANNetwork::MatchingPair> &calibration,
+                                                     const Config &config ) {
+        CORE_TRACE_SCOPE( "NeuronPruning::prune" );
+        assert( config.keepFraction > Core::real( 0 ) && config.keepFraction <= Core::real( 1 ) );
+        assert( config.minNeurons > 0 );
+
+        const auto  model = network.createModel( );
+        assert( model->isChain( ) );
+        const auto  stats = CollectStatistics( *model, calibration );
+        const auto &steps = model->getSteps( );
+
+        // kept neurons of every layer in their original order, offsets within the layer
+        std::vector<std::vector<size_t>> kept( steps.size( ) + 1 );
+        kept[ 0 ].resize( model->getInputCount( ) );
+        std::iota( kept[ 0 ].begin( ), kept[ 0 ].end( ), size_t( 0 ) );
+        for( size_t s = 0; s < steps.size( ); ++s ) {
+            const size_t n     = steps[ s ].dstNeuronCount;
+            auto         &keep = kept[ s + 1 ];
+            keep.resize( n );
+            std::iota( keep.begin( ), keep.end( ), size_t( 0 ) );
+            if( s + 1 == steps.size( ) ) {
+                break;
+            }
+
+            const size_t target = std::min( n, std::max( config.minNeurons, size_t( std::ceil(
+                    double( config.keepFraction ) * double( n ) ) ) ) );
+            const size_t base   = steps[ s ].dstNeuronIndex;
+            std::stable_sort( keep.begin( ), keep.end( ), [ &stats, base ]( const size_t a, const size_t b ) {
+                return stats.score[ base + a ] > stats.score[ base + b ];
+            } );
+            keep.resize( target );
+            std::sort( keep.begin( ), keep.end( ) );
+        }
+
+        // the same layer types at the new widths
+        std::unique_ptr<ANNetwork>     pruned( new ANNetwork( ) );
+        std::vector<Layer::shared_ptr> layers( network.cbegin( ), network.cend( ) );
+        Layer::shared_ptr              prev = std::make_shared<InputLayer>( model->getInputCount( ) );
+        pruned->addLayer( prev );
+        for( size_t l = 1; l + 1 < layers.size( ); ++l ) {
+            const auto        &func  = layers[ l ]->getActivationFunc( );
+            Layer::shared_ptr hidden = std::make_shared<HiddenLayer>(
+                    kept[ l ].size( ), func.activationFunctionType, func.getParam0( ), func.getParam1( ) );
+            pruned->addLayer( hidden );
+            pruned->connectLayers( std::make_shared<Connections>( prev, hidden ) );
+            prev = hidden;
+        }
+        Layer::shared_ptr out = std::make_shared<OutputLayer>( model->getOutputCount( ) );
+        pruned->addLayer( out );
+        pruned->connectLayers( std::make_shared<Connections>( prev, out ) );
+
+        // the kept rows and columns of every step, each pruned source folds its mean into the bias row
+        std::vector<Core::real> weights;
+        for( size_t s = 0; s < steps.size( ); ++s ) {
+            const auto   &step = steps[ s ];
+            const auto   w     = model->getStepWeights( step );
+            const auto   &rows = kept[ s ];
+            const auto   &cols = kept[ s + 1 ];
+            const size_t n     = step.dstNeuronCount;
+            const size_t k     = step.srcNeuronCount - 1;
+
+            std::vector<double> bias( cols.size( ) );
+            for( size_t c = 0; c < cols.size( ); ++c ) { bias[ c ] = w[ (k * n) + cols[ c ] ]; }
+            for( size_t i = 0, r = 0; i < k; ++i ) {
+                if( r < rows.size( ) && rows[ r ] == i ) {
+                    for( size_t c = 0; c < cols.size( ); ++c ) { weights.push_back( w[ (i * n) + cols[ c ] ] ); }
+                    ++r;
+                } else {
+                    const double mean = stats.mean[ step.srcNeuronIndex + i ];
+                    for( size_t c = 0; c < cols.size( ); ++c ) { bias[ c ] += w[ (i * n) + cols[ c ] ] * mean; }
+                }
+            }
+            for( auto &&b : bias ) { weights.push_back( Core::real( b ) ); }
+        }
+
+        pruned->setLearningRate( network.getLearningRate( ) );
+        pruned->setMomentum( network.getMomentum( ) );
+        pruned->finalise( true, config.maxBatchSize );
+        assert( weights.size( ) == pruned->getTotalWeightCount( ) );
+        pruned->setWeights( weights );
+
+        for( size_t epoch = 0; epoch < config.fineTuneEpochs; ++epoch ) {
+            pruned->trainEpoch( calibration );
+        }
+        return pruned;
+    }
+}
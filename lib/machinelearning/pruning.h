@@ -0,0 +1,40 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/ANNetwork.h"
+
+namespace MachineLearning {
+
+    /*
+     * Structured pruning of whole hidden neurons. Removing neuron j and adding its mean activation times its outgoing
+     * weights into the next layers bias weights changes the next layers pre activations by w_j ( a_j - mean_j ), so
+     * std( a_j ) * | w_j | over a calibration set is how much a neuron matters. The lowest scoring neurons of each
+     * hidden layer go and what's left is rebuilt as a smaller dense network, so every backend gets the saving
+     * without sparse kernels. Inputs and outputs are never pruned. Plain layer chains only, not DAG networks.
+     */
+    class NeuronPruning {
+    public:
+        struct Config {
+            Core::real keepFraction   = Core::real( 0.5 ); // of each hidden layer, rounded up
+            size_t     minNeurons     = 1;                 // never prune a layer below this
+            size_t     fineTuneEpochs = 0;                 // trainEpochs over the calibration set after pruning
+            size_t     maxBatchSize   = 64;                // the pruned network is finalised for training with this
+        };
+
+        // per hidden layer in order, the score of each of its neurons
+        static std::vector<std::vector<Core::real>>
+        scoreNeurons( const ANNetwork &network, const std::vector<ANNetwork::MatchingPair> &calibration );
+
+        // a new network of the same layer types with the kept neurons, weights and compensated biases. the
+        // learning rate and momentum carry over, the optimizer is the default one
+        static std::unique_ptr<ANNetwork> prune( const ANNetwork &network,
+                                                 const std::vector<ANNetwork::MatchingPair> &calibration,
+                                                 const Config &config );
+    };
+}
@@ -0,0 +1,93 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/core.h"
+#include "machinelearning/splineapproximator.h"
+
+namespace MachineLearning {
+
+    SplineApproximator::shared_ptr SplineApproximator::fit( const ScalarFunction &f, const Core::real lo,
+                                                            const Core::real hi, const Core::real tolerance,
+                                                            const size_t maxIntervals ) {
+        assert( hi > lo );
+        assert( tolerance > Core::real( 0 ) );
+
+        for( size_t intervals = 8; intervals <= maxIntervals; intervals *= 2 ) {
+            const double        h = (double( hi ) - double( lo )) / double( intervals );
+            std::vector<double> y( intervals + 1 );
+            for( size_t i = 0; i <= intervals; ++i ) { y[ i ] = f( Core::real( double( lo ) + (h * double( i )) ) ); }
+
+            const double loSlope = ((-25 * y[ 0 ]) + (48 * y[ 1 ]) - (36 * y[ 2 ]) + (16 * y[ 3 ]) - (3 * y[ 4 ])) /
+                                   (12 * h);
+            const size_t n       = intervals;
+            const double hiSlope = ((25 * y[ n ]) - (48 * y[ n - 1 ]) + (36 * y[ n - 2 ]) - (16 * y[ n - 3 ]) +
+                                    (3 * y[ n - 4 ])) / (12 * h);
+
+            auto approx = std::make_shared<SplineApproximator>( lo, hi, y, loSlope, hiSlope );
+            // the knots are exact, the worst error sits between them
+            if( approx->maxError( f, lo, hi, std::max( size_t( 4096 ), 8 * intervals + 1 ) ) <= tolerance ) {
+                return approx;
+            }
+        }
+        return nullptr;
+    }
+
+    SplineApproximator::SplineApproximator( const Core::real _lo, const Core::real hi,
+                                            const std::vector<double> &y, const double loSlope,
+                                            const double hiSlope ) :
+            lo( _lo ),
+            intervalCount( y.size( ) - 1 ) {
+        assert( y.size( ) >= 5 );
+        const size_t n = intervalCount;
+        const double h = (double( hi ) - double( _lo )) / double( n );
+        invStep = Core::real( 1.0 / h );
+
+        // clamped spline knot slopes m_i, h ( m_i-1 + 4 m_i + m_i+1 ) = 3 ( y_i+1 - y_i-1 ) solved by the Thomas
+        // algorithm with m_0 and m_n fixed
+        std::vector<double> m( n + 1 ), diag( n + 1 ), rhs( n + 1 );
+        m[ 0 ] = loSlope;
+        m[ n ] = hiSlope;
+        for( size_t i = 1; i < n; ++i ) {
+            diag[ i ] = 4.0;
+            rhs[ i ]  = 3.0 * (y[ i + 1 ] - y[ i - 1 ]) / h;
+        }
+        rhs[ 1 ] -= m[ 0 ];
+        rhs[ n - 1 ] -= m[ n ];
+        for( size_t i = 2; i < n; ++i ) {
+            const double w = 1.0 / diag[ i - 1 ];
+            diag[ i ] -= w;
+            rhs[ i ] -= w * rhs[ i - 1 ];
+        }
+        m[ n - 1 ] = rhs[ n - 1 ] / diag[ n - 1 ];
+        for( size_t i = n - 2; i >= 1; --i ) { m[ i ] = (rhs[ i ] - m[ i + 1 ]) / diag[ i ]; }
+
+        // Hermite form over u = ( x - x_i ) / h
+        coefficients.resize( 4 * n );
+        for( size_t i = 0; i < n; ++i ) {
+            const double dy = y[ i + 1 ] - y[ i ];
+            const double s0 = m[ i ] * h, s1 = m[ i + 1 ] * h;
+            coefficients[ 4 * i + 0 ] = Core::real( y[ i ] );
+            coefficients[ 4 * i + 1 ] = Core::real( s0 );
+            coefficients[ 4 * i + 2 ] = Core::real( (3.0 * dy) - (2.0 * s0) - s1 );
+            coefficients[ 4 * i + 3 ] = Core::real( (-2.0 * dy) + s0 + s1 );
+        }
+    }
+
+    void SplineApproximator::evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                                       Core::VectorALU::real_array_ptr results ) {
+        const Core::real last = Core::real( intervalCount - 1 );
+        const Core::real *c   = coefficients.data( );
+        for( size_t i = 0; i < batchSize; ++i ) {
+            const Core::real s        = (inputs[ i ] - lo) * invStep;
+            // written so a NaN input lands in the first interval (and evaluates to NaN) instead of indexing with it
+            const Core::real interval = !(s >= Core::real( 0 )) ? Core::real( 0 ) : std::min( std::floor( s ), last );
+            const Core::real u        = s - interval;
+            const Core::real *k       = c + (4 * size_t( interval ));
+            results[ i ] = ((((k[ 3 ] * u) + k[ 2 ]) * u + k[ 1 ]) * u) + k[ 0 ];
+        }
+    }
+}
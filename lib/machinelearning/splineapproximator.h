@@ -0,0 +1,53 @@
+//
+// Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "core/core.h"
+#include "machinelearning/approximator.h"
+
+namespace MachineLearning {
+
+    /*
+     * Clamped cubic spline through f at evenly spaced knots, the end slopes come from a fourth order one sided
+     * difference. The knot count doubles until sampling between the knots meets the tolerance. Only needs f to be
+     * piecewise smooth, and evaluation is one cubic per sample whatever the knot count.
+     * Outside [lo, hi] the end cubics are extrapolated.
+     */
+    class SplineApproximator : public Approximator {
+    public:
+        using shared_ptr = std::shared_ptr<SplineApproximator>;
+
+        // nullptr if maxIntervals can't reach the tolerance
+        static shared_ptr fit( const ScalarFunction &f, const Core::real lo, const Core::real hi,
+                               const Core::real tolerance, const size_t maxIntervals = 1 << 16 );
+
+        // knotValues holds intervalCount + 1 samples of f, the slopes are f' at lo and hi
+        SplineApproximator( const Core::real lo, const Core::real hi, const std::vector<double> &knotValues,
+                            const double loSlope, const double hiSlope );
+
+        size_t getInputCount() const override { return 1; }
+
+        size_t getOutputCount() const override { return 1; }
+
+        size_t getParameterCount() const override { return coefficients.size( ); }
+
+        void evaluate( const size_t batchSize, Core::VectorALU::const_real_array_ptr inputs,
+                       Core::VectorALU::real_array_ptr results ) override;
+
+        using Approximator::evaluate;
+
+        size_t getIntervalCount() const { return intervalCount; }
+
+    private:
+        Core::real lo;
+        Core::real invStep;
+        size_t     intervalCount;
+
+        // per interval a + b u + c u^2 + d u^3 with u in [0, 1) across the interval, interleaved
+        std::vector<Core::real> coefficients;
+    };
+}
@@ -2,8 +2,19 @@
 // Created by Dean Calver on 15/04/2016.
 //
 #include "core/core.h"
+#include "core/random.h"
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "machinelearning/inputlayer.h"
+#include "machinelearning/hiddenlayer.h"
+#include "machinelearning/outputlayer.h"
+#include "machinelearning/connections.h"
+#include "machinelearning/ANNetwork.h"
+#include "machinelearning/modelpublisher.h"
 #include "gtest/gtest.h"
 #include "../bin/realfunc.h"
+#include "../bin/inferenceserver.h"
 
 TEST( RealFuncTests, IsSine ) {
     RealFunc f;
@@ -11,3 +22,145 @@ TEST( RealFuncTests, IsSine ) {
     EXPECT_FLOAT_EQ( f( 1.0 ), std::sin( 1.0 ) );
     EXPECT_FLOAT_EQ( f( -1.0 ), std::sin( -1.0 ) );
 }
+
+
+TEST( InferenceServerTests, BatchesConcurrentRequests ) {
+    using namespace Core;
+    using namespace MachineLearning;
+
+    auto inLayer  = std::make_shared<InputLayer>( 2 );
+    auto hidLayer = std::make_shared<HiddenLayer>( 8 );
+    auto outLayer = std::make_shared<OutputLayer>( 2 );
+
+    ANNetwork ann{ };
+    ann.addLayer( inLayer );
+    ann.addLayer( hidLayer );
+    ann.addLayer( outLayer );
+    ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+    ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+    ann.finalise( false );
+    Core::Random::seed( 0xDEA0DEA0 );
+    ann.setRandomWeights( );
+
+    // round trip through the model file the serve mode loads
+    std::stringstream file;
+    ASSERT_TRUE( ann.createModel( )->save( file ) );
+    auto model = Model::load( file );
+    ASSERT_TRUE( model != nullptr );
+
+    InferenceServer::Config config;
+    config.socketPath           = "/tmp/funcapprox_test_" + std::to_string( ::getpid( ) ) + ".sock";
+    config.maxBatchSize         = 8;
+    config.maxDelayMicroseconds = 20000;
+
+    ModelPublisher  publisher( model );
+    InferenceServer server( publisher, config );
+    ASSERT_TRUE( server.open( ) );
+    std::thread serverThread( [ &server ]() { server.run( ); } );
+
+    const size_t             clientCount = 4, requestCount = 32;
+    std::vector<int>         mismatches( clientCount, 0 );
+    std::vector<std::thread> clients;
+    for( size_t c = 0; c < clientCount; ++c ) {
+        clients.emplace_back( [ &, c ]() {
+            InferenceClient client;
+            if( !client.connect( config.socketPath ) ) {
+                mismatches[ c ] = int( requestCount );
+                return;
+            }
+
+            // the expected outputs come from this threads own session, the network's buffers aren't shareable
+            InferenceSession session( model );
+
+            // pipelined so the server sees several requests per wakeup
+            std::vector<std::vector<real>> inputs;
+            for( uint32_t r = 0; r < requestCount; ++r ) {
+                inputs.push_back( { real( c ) * real( 0.25 ) - real( 0.5 ), real( r ) * real( 0.05 ) - real( 0.8 ) } );
+                client.send( r, inputs.back( ) );
+            }
+            for( uint32_t r = 0; r < requestCount; ++r ) {
+                uint32_t          id;
+                std::vector<real> outputs, expected( 2 );
+                if( !client.receive( id, outputs ) || id >= requestCount || outputs.size( ) != 2 ) {
+                    mismatches[ c ]++;
+                    continue;
+                }
+                session.evaluate( inputs[ id ].data( ), expected.data( ) );
+                mismatches[ c ] += (std::fabs( outputs[ 0 ] - expected[ 0 ] ) > 1e-5f ||
+                                    std::fabs( outputs[ 1 ] - expected[ 1 ] ) > 1e-5f) ? 1 : 0;
+            }
+
+            // the wrong number of inputs is rejected rather than dropping the connection
+            std::vector<real> outputs;
+            mismatches[ c ] += (client.evaluate( { real( 1 ) }, outputs ) && outputs.empty( )) ? 0 : 1;
+        } );
+    }
+    for( auto &&client : clients ) { client.join( ); }
+    server.stop( );
+    serverThread.join( );
+
+    for( auto &&m : mismatches ) { EXPECT_EQ( m, 0 ); }
+
+    const auto stats = server.getStats( );
+    EXPECT_EQ( stats.requests, clientCount * (requestCount + 1) );
+    EXPECT_EQ( stats.rejected, clientCount );
+    EXPECT_LE( stats.largestBatch, config.maxBatchSize );
+    EXPECT_GT( stats.largestBatch, 1u );
+    EXPECT_LT( stats.batches, clientCount * requestCount );
+}
+
+TEST( InferenceServerTests, AnswersAfterHalfClose ) {
+    using namespace Core;
+    using namespace MachineLearning;
+
+    auto inLayer  = std::make_shared<InputLayer>( 2 );
+    auto outLayer = std::make_shared<OutputLayer>( 1 );
+
+    ANNetwork ann{ };
+    ann.addLayer( inLayer );
+    ann.addLayer( outLayer );
+    ann.connectLayers( std::make_shared<Connections>( inLayer, outLayer ) );
+    ann.finalise( false );
+    ann.setRandomWeights( );
+
+    // a long delay so the requests are still waiting for their batch when the EOF arrives
+    InferenceServer::Config config;
+    config.socketPath           = "/tmp/funcapprox_halfclose_" + std::to_string( ::getpid( ) ) + ".sock";
+    config.maxBatchSize         = 8;
+    config.maxDelayMicroseconds = 50000;
+
+    ModelPublisher  publisher( ann.createModel( ) );
+    InferenceServer server( publisher, config );
+    ASSERT_TRUE( server.open( ) );
+    std::thread serverThread( [ &server ]() { server.run( ); } );
+
+    InferenceClient client;
+    ASSERT_TRUE( client.connect( config.socketPath ) );
+    const uint32_t requestCount = 5;
+    for( uint32_t r = 0; r < requestCount; ++r ) {
+        EXPECT_TRUE( client.send( r, { real( r ) * real( 0.1 ), real( 0.5 ) } ) );
+    }
+    EXPECT_TRUE( client.send( requestCount, { real( 1 ) } ) ); // rejected, answered straight away
+    EXPECT_TRUE( client.finishSending( ) );
+
+    std::vector<bool> answered( requestCount + 1, false );
+    for( uint32_t r = 0; r <= requestCount; ++r ) {
+        uint32_t          id;
+        std::vector<real> outputs;
+        if( !client.receive( id, outputs ) || id > requestCount ) {
+            ADD_FAILURE( ) << "response " << r << " lost";
+            break;
+        }
+        EXPECT_EQ( outputs.size( ), (id == requestCount) ? 0u : 1u );
+        answered[ id ] = true;
+    }
+    for( auto &&a : answered ) { EXPECT_TRUE( a ); }
+
+    // then the server closes its side
+    uint32_t          id;
+    std::vector<real> outputs;
+    EXPECT_FALSE( client.receive( id, outputs ) );
+
+    server.stop( );
+    serverThread.join( );
+}
@@ -2,7 +2,24 @@
 // Created by Dean Calver on 15/04/2016.
 //
 
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
 #include "core/core.h"
+#include "core/random.h"
+#include "core/randomstream.h"
+#include "core/reduction.h"
+#include "core/ringallreduce.h"
+#include "core/ringtransport.h"
+#include "core/sobol.h"
+#include "core/spscqueue.h"
+#include "core/threadpool.h"
+#include "core/trace.h"
+#include "core/vectoralu.h"
 #include "gtest/gtest.h"
 
 TEST( CoreTests, AlmostEqual ) {
@@ -11,4 +28,408 @@ TEST( CoreTests, AlmostEqual ) {
     EXPECT_EQ( Core::almost_equal( 0.0, 0.0 + std::numeric_limits<double>::min( ) ), false );
     EXPECT_EQ( Core::almost_equal( 0.0, 0.0 + std::numeric_limits<double>::epsilon( ) ), false );
 
-}
\ No newline at end of file
+}
+TEST( CoreTests, TraceChromeJson ) {
+    Core::Trace::clear( );
+    {
+        Core::TraceScope scope( "outer" );
+        Core::TraceScope inner( "inner", 3 );
+    }
+    std::thread worker( [ ]() {
+        Core::Trace::setThreadName( "worker" );
+        Core::TraceScope scope( "task" );
+    } );
+    worker.join( );
+
+    EXPECT_EQ( Core::Trace::eventCount( ), 3 );
+
+    std::stringstream json;
+    Core::Trace::dumpChromeJson( json );
+    const auto str = json.str( );
+    EXPECT_NE( str.find( "\"traceEvents\"" ), std::string::npos );
+    EXPECT_NE( str.find( "\"name\":\"outer\",\"ph\":\"X\"" ), std::string::npos );
+    EXPECT_NE( str.find( "\"args\":{\"value\":3}" ), std::string::npos );
+    EXPECT_NE( str.find( "\"args\":{\"name\":\"worker\"}" ), std::string::npos );
+
+    Core::Trace::clear( );
+    EXPECT_EQ( Core::Trace::eventCount( ), 0 );
+
+    // a thread keeps only its newest events, and dumping while it records is fine
+    std::atomic<bool> dumped( false );
+    std::thread       flood( [ & ]() {
+        for( size_t i = 0; i < Core::Trace::eventsPerThread + 10 || !dumped.load( ); ++i ) {
+            Core::Trace::record( "flood", i, i + 1 );
+            if( i >= Core::Trace::eventsPerThread + 10 ) { std::this_thread::yield( ); }
+        }
+    } );
+    std::stringstream during;
+    Core::Trace::dumpChromeJson( during );
+    dumped.store( true );
+    flood.join( );
+    EXPECT_EQ( Core::Trace::eventCount( ), Core::Trace::eventsPerThread );
+    EXPECT_GE( Core::Trace::droppedCount( ), 10u );
+    std::stringstream after;
+    Core::Trace::dumpChromeJson( after );
+    EXPECT_EQ( after.str( ).find( "\"ts\":0.000," ), std::string::npos ); // the oldest went first
+
+    Core::Trace::clear( );
+    EXPECT_EQ( Core::Trace::droppedCount( ), 0 );
+}
+
+TEST( CoreTests, PackedPanelKernels ) {
+    using namespace Core;
+    auto alu = VectorALUFactory( );
+
+    // sizes straddle the panel width so full and partial panels are both covered
+    const size_t m = 5, k = 19, n = 21, pw = alu->preferredPanelWidth( );
+    std::vector<real> a( m * k ), b( k * n ), d( m * n );
+    for( size_t i = 0; i < a.size( ); ++i ) { a[ i ] = real( (int( i * 7 ) % 13) - 6 ) * real( 0.25 ); }
+    for( size_t i = 0; i < b.size( ); ++i ) { b[ i ] = real( (int( i * 5 ) % 11) - 5 ) * real( 0.5 ); }
+    for( size_t i = 0; i < d.size( ); ++i ) { d[ i ] = real( (int( i * 3 ) % 7) - 3 ); }
+
+    std::vector<real> packed( k * n ), unpacked( k * n );
+    alu->packPanels( k, n, b.data( ), n, false, pw, packed.data( ) );
+    alu->unpackPanels( k, n, packed.data( ), pw, unpacked.data( ), n );
+    EXPECT_EQ( unpacked, b );
+
+    // a * b
+    std::vector<real> expected( m * n ), actual( m * n );
+    alu->gemm( false, false, m, n, k, real( 1 ), a.data( ), k, b.data( ), n, real( 0 ), expected.data( ), n );
+    alu->packedGemm( m, n, k, a.data( ), k, packed.data( ), pw, real( 0 ), actual.data( ), n );
+    EXPECT_EQ( actual, expected );
+
+    // d * b^T via the packed b directly and via its packed transpose, using all but the last row of b
+    std::vector<real> expectedT( m * (k - 1) ), actualT( m * (k - 1) ), packedT( n * (k - 1) );
+    alu->gemm( false, true, m, k - 1, n, real( 1 ), d.data( ), n, b.data( ), n, real( 0 ), expectedT.data( ), k - 1 );
+    alu->packedGemmTransposed( m, k - 1, n, d.data( ), n, packed.data( ), k, pw, real( 0 ), actualT.data( ), k - 1 );
+    EXPECT_EQ( actualT, expectedT );
+    alu->transposePanels( k, n, packed.data( ), pw, k - 1, packedT.data( ) );
+    alu->packedGemm( m, k - 1, n, d.data( ), n, packedT.data( ), pw, real( 0 ), actualT.data( ), k - 1 );
+    EXPECT_EQ( actualT, expectedT );
+
+    // b += a^T * d
+    std::vector<real> outer( b );
+    alu->gemm( true, false, k, n, m, real( 1 ), a.data( ), k, d.data( ), n, real( 1 ), outer.data( ), n );
+    alu->packedOuterAccumulate( m, k, n, a.data( ), k, d.data( ), n, pw, packed.data( ) );
+    alu->unpackPanels( k, n, packed.data( ), pw, unpacked.data( ), n );
+    EXPECT_EQ( unpacked, outer );
+}
+
+TEST( CoreTests, PackedDenseActivate ) {
+    using namespace Core;
+    auto alu = VectorALUFactory( );
+
+    // 11 inputs + bias row feeding 10 outputs, 3 samples
+    const size_t m = 3, k = 12, n = 10, pw = alu->preferredPanelWidth( );
+    std::vector<real> a( m * k, real( 1 ) ), b( k * n ), packed( k * n );
+    for( size_t i = 0; i < a.size( ); ++i ) { if( (i % k) != (k - 1) ) { a[ i ] = real( int( i % 5 ) - 2 ) * 0.1f; }}
+    for( size_t i = 0; i < b.size( ); ++i ) { b[ i ] = real( int( i % 9 ) - 4 ) * 0.2f; }
+    alu->packPanels( k, n, b.data( ), n, false, pw, packed.data( ) );
+
+    std::vector<real> expectedSums( m * n ), expected( m * n ), sums( m * n ), out( m * n );
+    alu->gemm( false, false, m, n, k, real( 1 ), a.data( ), k, b.data( ), n, real( 0 ), expectedSums.data( ), n );
+    alu->sigmoid( m * n, expectedSums.data( ), expected.data( ) );
+
+    // the kernel never reads the implied bias input so poison it
+    for( size_t i = 0; i < m; ++i ) { a[ (i * k) + k - 1 ] = real( 1000 ); }
+
+    alu->packedDenseActivate( m, n, k, a.data( ), k, packed.data( ), pw, ActivationKernel::Sigmoid, real( 0 ),
+                              real( 0 ), sums.data( ), n, out.data( ), n );
+    for( size_t i = 0; i < out.size( ); ++i ) {
+        // bias first changes the summation order slightly
+        EXPECT_NEAR( sums[ i ], expectedSums[ i ], 1e-5 );
+        EXPECT_NEAR( out[ i ], expected[ i ], 1e-5 );
+    }
+
+    alu->packedDenseActivate( m, n, k, a.data( ), k, packed.data( ), pw, ActivationKernel::ReLU, real( 0 ),
+                              real( 0 ), nullptr, 0, out.data( ), n );
+    for( size_t i = 0; i < out.size( ); ++i ) {
+        EXPECT_NEAR( out[ i ], std::max( expectedSums[ i ], real( 0 ) ), 1e-5 );
+    }
+
+    // accumulating the same connection again doubles the sums
+    alu->packedDenseAccumulate( m, n, k, a.data( ), k, packed.data( ), pw, sums.data( ), n );
+    for( size_t i = 0; i < sums.size( ); ++i ) { EXPECT_NEAR( sums[ i ], real( 2 ) * expectedSums[ i ], 2e-5 ); }
+}
+
+TEST( CoreTests, ThreadPoolNestedSubmit ) {
+    using namespace Core;
+
+    ThreadPool pool( 4 );
+    EXPECT_EQ( pool.getThreadCount( ), 4u );
+
+    // tasks of very uneven sizes that spawn more work, everything must have run by the time wait returns
+    std::atomic<int>      leaves( 0 );
+    std::atomic<uint64_t> work( 0 );
+    for( int i = 0; i < 16; ++i ) {
+        pool.submit( [ &, i ]() {
+            for( int j = 0; j < 8; ++j ) {
+                pool.submit( [ &, i, j ]() {
+                    uint64_t acc = 0;
+                    for( int k = 0; k < (i + 1) * (j + 1) * 1000; ++k ) { acc += uint64_t( k ) ^ acc; }
+                    work.fetch_add( acc & 1 );
+                    leaves.fetch_add( 1 );
+                } );
+            }
+        } );
+    }
+    pool.wait( );
+    EXPECT_EQ( leaves.load( ), 16 * 8 );
+
+    // the pool is reusable after a wait
+    pool.submit( [ &leaves ]() { leaves.fetch_add( 1 ); } );
+    pool.wait( );
+    EXPECT_EQ( leaves.load( ), (16 * 8) + 1 );
+}
+
+TEST( CoreTests, SpscQueue ) {
+    using namespace Core;
+
+    SpscQueue<std::vector<int>> queue( 3 );
+    queue.forEachElement( []( std::vector<int> &element ) { element.resize( 2 ); } );
+    EXPECT_EQ( queue.tryBeginPop( ), nullptr );
+
+    // bounded, the fourth push has to wait for a pop
+    for( int i = 0; i < 3; ++i ) {
+        auto element = queue.tryBeginPush( );
+        ASSERT_NE( element, nullptr );
+        (*element)[ 0 ] = i;
+        queue.endPush( );
+    }
+    EXPECT_EQ( queue.tryBeginPush( ), nullptr );
+    EXPECT_EQ( (*queue.tryBeginPop( ))[ 0 ], 0 );
+    queue.endPop( );
+    EXPECT_NE( queue.tryBeginPush( ), nullptr );
+    for( int i = 1; i < 3; ++i ) {
+        EXPECT_EQ( (*queue.beginPop( ))[ 0 ], i );
+        queue.endPop( );
+    }
+
+    // a producer thread racing the consumer, everything arrives once and in order
+    const int count = 100000;
+    std::thread producer( [ &queue ]() {
+        for( int i = 0; i < count; ++i ) {
+            auto element = queue.beginPush( );
+            (*element)[ 0 ] = i;
+            (*element)[ 1 ] = -i;
+            queue.endPush( );
+        }
+    } );
+    bool ordered = true;
+    for( int i = 0; i < count; ++i ) {
+        const auto element = queue.beginPop( );
+        ordered = ordered && (*element)[ 0 ] == i && (*element)[ 1 ] == -i;
+        queue.endPop( );
+    }
+    producer.join( );
+    EXPECT_TRUE( ordered );
+    EXPECT_EQ( queue.tryBeginPop( ), nullptr );
+}
+
+TEST( CoreTests, PhiloxRandomStreams ) {
+    using namespace Core;
+
+    // Random123 known answers for philox4x32-10
+    EXPECT_EQ( Philox4x32::generate( { 0, 0, 0, 0 }, { 0, 0 } ),
+               (Philox4x32::Counter{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }) );
+    EXPECT_EQ( Philox4x32::generate( { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff } ),
+               (Philox4x32::Counter{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }) );
+    EXPECT_EQ( Philox4x32::generate( { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 } ),
+               (Philox4x32::Counter{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }) );
+
+    // the bulk fill is the scalar generator, whatever the lane blocking
+    RandomStream      a( 1234, 7 ), b( 1234, 7 );
+    std::vector<real> bulk( 37 );
+    a.fillUniform( bulk.size( ), real( 0 ), real( 1 ), bulk.data( ) );
+    for( size_t i = 0; i < bulk.size( ); ++i ) {
+        EXPECT_EQ( bulk[ i ], b.nextUniform( ) );
+    }
+
+    // a fill split in two at a block boundary matches one big fill
+    RandomStream      c( 1234, 7 );
+    std::vector<real> split( 36 );
+    c.fillUniform( 20, real( 0 ), real( 1 ), split.data( ) );
+    c.fillUniform( 16, real( 0 ), real( 1 ), split.data( ) + 20 );
+    for( size_t i = 0; i < split.size( ); ++i ) { EXPECT_EQ( split[ i ], bulk[ i ] ); }
+
+    // another stream id of the same seed is a different sequence
+    RandomStream      other( 1234, 8 );
+    std::vector<real> otherBulk( bulk.size( ) );
+    other.fillUniform( otherBulk.size( ), real( 0 ), real( 1 ), otherBulk.data( ) );
+    EXPECT_NE( otherBulk, bulk );
+
+    // moments of large fills
+    std::vector<real> uniform( 1 << 16 ), normal( 1 << 16 );
+    RandomStream      d( 99, 0 );
+    d.fillUniform( uniform.size( ), real( -2 ), real( 2 ), uniform.data( ) );
+    d.fillNormal( normal.size( ), real( 1 ), real( 3 ), normal.data( ) );
+    double uSum = 0, nSum = 0, nSq = 0;
+    for( auto &&u : uniform ) {
+        EXPECT_GE( u, real( -2 ) );
+        EXPECT_LT( u, real( 2 ) );
+        uSum += u;
+    }
+    for( auto &&n : normal ) {
+        nSum += n;
+        nSq += double( n ) * n;
+    }
+    const double nMean = nSum / normal.size( );
+    EXPECT_NEAR( uSum / uniform.size( ), 0.0, 0.02 );
+    EXPECT_NEAR( nMean, 1.0, 0.05 );
+    EXPECT_NEAR( std::sqrt( (nSq / normal.size( )) - (nMean * nMean) ), 3.0, 0.05 );
+
+    // re-seeding restarts the stream numbering
+    Random::seed( 42 );
+    auto first = Random::newStream( );
+    Random::seed( 42 );
+    auto again = Random::newStream( );
+    EXPECT_EQ( first.next( ), again.next( ) );
+}
+
+TEST( CoreTests, ReproducibleReductions ) {
+    using namespace Core;
+
+    // wide dynamic range and mixed signs so the naive loop drops bits
+    const size_t      count = 100003;
+    std::vector<real> data( count );
+    RandomStream      stream( 37, 0 );
+    stream.fillNormal( count, real( 0 ), real( 1 ), data.data( ));
+    for( size_t i = 0; i < count; i += 97 ) { data[ i ] *= real( 1e4 ); }
+
+    double reference = 0;
+    for( const real x : data ) { reference += double( x ); }
+
+    const real serial = Reduction::sum( count, data.data( ));
+    for( const size_t threads : { 1, 2, 3, 4 } ) {
+        ThreadPool pool( threads );
+        const real parallel = Reduction::sum( count, data.data( ), &pool );
+        EXPECT_EQ( std::memcmp( &serial, &parallel, sizeof( real )), 0 ) << threads << " threads";
+    }
+    EXPECT_NEAR( double( serial ), reference, std::abs( reference ) * 1e-6 );
+
+    // the ALU follows the process wide mode
+    auto alu = VectorALUFactory( );
+    setReductionMode( ReductionMode::Reproducible );
+    EXPECT_EQ( alu->horizSum( count, data.data( )), serial );
+    EXPECT_EQ( alu->norm2( count, data.data( )), std::sqrt( Reduction::sumSquares( count, data.data( ))));
+    EXPECT_EQ( alu->dot( count, data.data( ), data.data( )), Reduction::sumSquares( count, data.data( )));
+    EXPECT_EQ( alu->sumSquaredDifference( count - 1, data.data( ), data.data( ) + 1 ),
+               Reduction::sumSquaredDifference( count - 1, data.data( ), data.data( ) + 1 ));
+    setReductionMode( ReductionMode::Fast );
+
+    const real v[3] = { real( -1 ), real( 2 ), real( -2 ) };
+    const real u[3] = { real( 3 ), real( 0.5 ), real( 1 ) };
+    EXPECT_NEAR( alu->norm3( 3, v ), std::cbrt( real( 17 )), 1e-5 );
+    EXPECT_EQ( alu->dot( 3, u, v ), real( -4 ));
+    EXPECT_EQ( alu->sumSquaredDifference( 3, u, v ), real( 16 + 2.25 + 9 ));
+    EXPECT_EQ( Reduction::sum( 0, v ), real( 0 ));
+}
+
+TEST( CoreTests, SobolSequence ) {
+    using namespace Core;
+
+    // the first dimension is van der Corput in Gray code order
+    {
+        SobolSequence sobol( 1 );
+        real          x[8];
+        sobol.fill( 8, x );
+        const real expected[8] = { 0, 0.5, 0.75, 0.25, 0.375, 0.875, 0.625, 0.125 };
+        for( int i = 0; i < 8; ++i ) { EXPECT_EQ( x[ i ], expected[ i ] ) << i; }
+    }
+
+    // every 2^k prefix has one point in each of the 2^k slices of every dimension, shifted or not
+    for( const uint64_t seed : { uint64_t( 0 ), uint64_t( 46 ) } ) {
+        const size_t      dims = SobolSequence::maxDimensions;
+        SobolSequence     sobol( dims, seed );
+        std::vector<real> points( 1024 * dims );
+        sobol.fill( 1024, points.data( ));
+        for( size_t k = 1; k <= 10; ++k ) {
+            const size_t n = size_t( 1 ) << k;
+            for( size_t d = 0; d < dims; ++d ) {
+                std::vector<int> slices( n, 0 );
+                for( size_t i = 0; i < n; ++i ) {
+                    const real x = points[ (i * dims) + d ];
+                    ASSERT_GE( x, real( 0 ));
+                    ASSERT_LT( x, real( 1 ));
+                    ++slices[ size_t( x * real( n )) ];
+                }
+                for( size_t s = 0; s < n; ++s ) {
+                    ASSERT_EQ( slices[ s ], 1 ) << "seed " << seed << " k " << k << " d " << d;
+                }
+            }
+        }
+
+        // the first two dimensions are a ( 0, m, 2 ) net, one point in every 2^-a by 2^-( 6 - a ) box
+        for( size_t a = 0; a <= 6; ++a ) {
+            std::vector<int> boxes( 64, 0 );
+            for( size_t i = 0; i < 64; ++i ) {
+                const size_t bx = size_t( points[ i * dims ] * real( 1 << a ));
+                const size_t by = size_t( points[ (i * dims) + 1 ] * real( 1 << (6 - a)));
+                ++boxes[ (bx << (6 - a)) + by ];
+            }
+            for( auto &&b : boxes ) { EXPECT_EQ( b, 1 ); }
+        }
+
+        // seeking lands on the same point as stepping there
+        SobolSequence     jump( dims, seed );
+        std::vector<real> p( dims );
+        jump.seek( 777 );
+        EXPECT_EQ( jump.getIndex( ), 777u );
+        jump.next( p.data( ));
+        for( size_t d = 0; d < dims; ++d ) { EXPECT_EQ( p[ d ], points[ (777 * dims) + d ] ); }
+    }
+}
+
+namespace {
+    // every rank sums a pattern it can check exactly, big enough that each chunk wraps the inbox several times
+    int RingAllreduceRank( Core::RingTransport &transport ) {
+        using namespace Core;
+        if( !transport.open( ) ) { return 1; }
+
+        RingAllreduce     allreduce( transport );
+        const size_t      size = transport.getSize( );
+        std::vector<real> data( 10007 );
+        for( size_t i = 0; i < data.size( ); ++i ) { data[ i ] = real( (i % 64) * (transport.getRank( ) + 1) ); }
+        if( !allreduce.sum( data.size( ), data.data( ) ) ) { return 2; }
+
+        const auto rankSum = real( (size * (size + 1)) / 2 );
+        for( size_t i = 0; i < data.size( ); ++i ) {
+            if( data[ i ] != real( i % 64 ) * rankSum ) { return 3; }
+        }
+
+        // fewer values than ranks leaves some chunks empty
+        real one = real( 1 );
+        if( !allreduce.sum( 1, &one ) || one != real( size ) ) { return 4; }
+        return allreduce.barrier( ) ? 0 : 5;
+    }
+}
+
+TEST( CoreTests, RingAllreduce ) {
+    using namespace Core;
+    const std::string name = "funcapprox-check-" + std::to_string( ::getpid( ) );
+
+    for( const size_t size : { size_t( 1 ), size_t( 3 ) } ) {
+        EXPECT_TRUE( runRanks( size, [ & ]( const size_t rank ) {
+            SharedMemoryTransport::Config config;
+            config.rank     = rank;
+            config.size     = size;
+            config.name     = name;
+            config.capacity = 4096;
+            SharedMemoryTransport transport( config );
+            return RingAllreduceRank( transport );
+        } ) ) << size;
+    }
+
+    // the segments are gone once the ring is up
+    EXPECT_EQ( ::access( ("/dev/shm/" + name + ".0").c_str( ), F_OK ), -1 );
+
+    const auto basePort = uint16_t( 30000 + ((::getpid( ) % 1000) * 4) );
+    EXPECT_TRUE( runRanks( 3, [ basePort ]( const size_t rank ) {
+        TcpTransport::Config config;
+        config.rank     = rank;
+        config.size     = 3;
+        config.basePort = basePort;
+        TcpTransport transport( config );
+        return RingAllreduceRank( transport );
+    } ) );
+}
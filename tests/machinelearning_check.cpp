@@ -4,7 +4,16 @@
 
 #include "core/core.h"
 #include "core/random.h"
+#include "core/ringtransport.h"
+#include "core/threadpool.h"
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 #include <boost/generator_iterator.hpp>
 #include "machinelearning/machinelearning.h"
 #include "machinelearning/inputlayer.h"
@@ -12,6 +21,23 @@
 #include "machinelearning/outputlayer.h"
 #include "machinelearning/connections.h"
 #include "machinelearning/ANNetwork.h"
+#include "machinelearning/model.h"
+#include "machinelearning/modelpublisher.h"
+#include "machinelearning/ensemblenetwork.h"
+#include "machinelearning/hyperparametersearch.h"
+#include "machinelearning/gradienttape.h"
+#include "machinelearning/convolution.h"
+#include "machinelearning/approximator.h"
+#include "machinelearning/chebyshevapproximator.h"
+#include "machinelearning/splineapproximator.h"
+#include "machinelearning/piecewiselinearapproximator.h"
+#include "machinelearning/lbfgstrainer.h"
+#include "machinelearning/pruning.h"
+#include "machinelearning/datasetevaluator.h"
+#include "machinelearning/adaptivesampler.h"
+#include "machinelearning/dataparalleltrainer.h"
+#include "machinelearning/pipelinetrainer.h"
+#include "machinelearning/optimizer.h"
 #include "gtest/gtest.h"
 
 namespace MachineLearning {
@@ -235,4 +261,1426 @@ namespace MachineLearning {
         }
 
     }
-}
\ No newline at end of file
+
+    TEST( MachineLearningTests, Optimizers ) {
+        using namespace Core;
+
+        {
+            MomentumOptimizer opt( real( 0.5 ) );
+            opt.allocate( 2 );
+            std::array<real, 2> w{ real( 1.0 ), real( -1.0 ) };
+            std::array<real, 2> g{ real( 2.0 ), real( 4.0 ) };
+            opt.step( w.data( ), g.data( ), real( 0.1 ), real( 0.5 ) );
+            EXPECT_FLOAT_EQ( w[ 0 ], real( 0.9 ) );   // v = -0.1 * 1
+            EXPECT_FLOAT_EQ( w[ 1 ], real( -1.2 ) );  // v = -0.1 * 2
+            EXPECT_FLOAT_EQ( g[ 0 ], real( 0.0 ) );   // gradients consumed
+            EXPECT_FLOAT_EQ( g[ 1 ], real( 0.0 ) );
+            g = { real( 2.0 ), real( 0.0 ) };
+            opt.step( w.data( ), g.data( ), real( 0.1 ), real( 0.5 ) );
+            EXPECT_FLOAT_EQ( w[ 0 ], real( 0.75 ) );  // v = 0.5 * -0.1 - 0.1
+            EXPECT_FLOAT_EQ( w[ 1 ], real( -1.3 ) );  // v = 0.5 * -0.2
+            EXPECT_EQ( opt.getStateBytes( ), 2 * sizeof( real ) );
+        }
+        {
+            MomentumOptimizer opt( real( 0.5 ), true );
+            EXPECT_EQ( opt.getOptimizerType( ), OptimizerType::Nesterov );
+            opt.allocate( 1 );
+            std::array<real, 1> w{ real( 1.0 ) };
+            std::array<real, 1> g{ real( 1.0 ) };
+            opt.step( w.data( ), g.data( ), real( 0.1 ), real( 1.0 ) );
+            EXPECT_FLOAT_EQ( w[ 0 ], real( 0.85 ) ); // 1 + 0.5 * -0.1 - 0.1
+        }
+        {
+            // first adam step moves each weight by ~learning rate against the gradient sign
+            auto opt = OptimizerFactory( OptimizerType::Adam );
+            opt->allocate( 2 );
+            std::array<real, 2> w{ real( 0.0 ), real( 0.0 ) };
+            std::array<real, 2> g{ real( 3.0 ), real( -0.25 ) };
+            opt->step( w.data( ), g.data( ), real( 0.01 ), real( 1.0 ) );
+            EXPECT_NEAR( w[ 0 ], real( -0.01 ), 1e-5 );
+            EXPECT_NEAR( w[ 1 ], real( 0.01 ), 1e-5 );
+            EXPECT_EQ( opt->getStateBytes( ), 2 * 2 * sizeof( real ) );
+        }
+        {
+            auto opt = OptimizerFactory( OptimizerType::RMSProp );
+            opt->allocate( 1 );
+            std::array<real, 1> w{ real( 0.0 ) };
+            std::array<real, 1> g{ real( 2.0 ) };
+            opt->step( w.data( ), g.data( ), real( 0.01 ), real( 1.0 ) );
+            // ms = 0.1 * 4, w = -0.01 * 2 / sqrt( 0.4 )
+            EXPECT_NEAR( w[ 0 ], real( -0.0316228 ), 1e-5 );
+        }
+    }
+
+    TEST( MachineLearningTests, ANNetworkBackprop ) {
+        using namespace Core;
+
+        auto inLayer  = std::make_shared<InputLayer>( 2 );
+        auto hidLayer = std::make_shared<HiddenLayer>( 3 );
+        auto outLayer = std::make_shared<OutputLayer>( 2 );
+
+        ANNetwork ann{ };
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        ann.finalise( true, 3 );
+
+        std::vector<real> wts{
+                0.13, 0.63, -0.68, 0.89, 0.94, -0.86, -0.5, -0.4, 0.44,
+                0.2, -0.3, 0.7, 0.1, -0.9, 0.5, 0.25, 0.35
+        };
+        ASSERT_EQ( wts.size( ), ann.totalWeightCount );
+        ann.setWeights( wts );
+
+        const std::array<real, 6> inputs{ real( 0.0 ), real( 1.0 ), real( 0.5 ), real( -0.5 ), real( 1.0 ), real( 1.0 ) };
+        const std::array<real, 6> perfect{ real( 1.0 ), real( 0.0 ), real( 0.0 ), real( 1.0 ), real( 0.5 ), real( 0.5 ) };
+        std::array<real, 6>       results;
+
+        // E = 1/2 sum over the batch of |output - perfect|^2
+        auto loss = [ & ]() {
+            ann.evaluate( 3, inputs.data( ), results.data( ) );
+            double e = 0;
+            for( size_t i = 0; i < results.size( ); ++i ) {
+                e += 0.5 * (results[ i ] - perfect[ i ]) * (results[ i ] - perfect[ i ]);
+            }
+            return e;
+        };
+
+        loss( );
+        ann.computeGradients( 3, perfect.data( ) );
+        EXPECT_EQ( ann.gradientSampleCount, 3 );
+        const auto gradients = ann.getGradients( );
+
+        for( size_t w = 0; w < wts.size( ); ++w ) {
+            const real h     = real( 1e-2 );
+            auto       probe = wts;
+            probe[ w ] = wts[ w ] + h;
+            ann.setWeights( probe );
+            const auto ep = loss( );
+            probe[ w ] = wts[ w ] - h;
+            ann.setWeights( probe );
+            const auto em = loss( );
+            EXPECT_NEAR( gradients[ w ], (ep - em) / (2 * h), 2e-3 ) << "weight " << w;
+        }
+
+        // a single update should reduce the batch loss
+        ann.setWeights( wts );
+        EXPECT_EQ( ann.getWeights( ), wts );
+        const auto before = loss( );
+        ann.setLearningRate( real( 0.5 ) );
+        ann.updateWeights( );
+        EXPECT_LT( loss( ), before );
+    }
+
+    TEST( MachineLearningTests, ModelConcurrentInference ) {
+        using namespace Core;
+
+        auto inLayer  = std::make_shared<InputLayer>( 2 );
+        auto hidLayer = std::make_shared<HiddenLayer>( 12 );
+        auto outLayer = std::make_shared<OutputLayer>( 3 );
+
+        ANNetwork ann{ };
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        ann.finalise( false );
+        Core::Random::seed( 0xDEA0DEA0 );
+        ann.setRandomWeights( );
+
+        const size_t      samples = 64;
+        std::vector<real> inputs( samples * 2 ), expected( samples * 3 );
+        for( size_t i = 0; i < inputs.size( ); ++i ) { inputs[ i ] = real( i % 17 ) * real( 0.1 ) - real( 0.8 ); }
+        for( size_t i = 0; i < samples; ++i ) {
+            ann.evaluate( inputs.data( ) + (i * 2), expected.data( ) + (i * 3) );
+        }
+
+        const auto model = ann.createModel( );
+        EXPECT_EQ( model->getInputCount( ), 2 );
+        EXPECT_EQ( model->getOutputCount( ), 3 );
+
+        // the model is a snapshot, later changes to the network don't leak into it
+        ann.setWeights( std::vector<real>( ann.getTotalWeightCount( ), real( 0 ) ) );
+
+        std::vector<std::thread> threads;
+        std::vector<int>         mismatches( 4, 0 );
+        for( size_t t = 0; t < mismatches.size( ); ++t ) {
+            threads.emplace_back( [ &, t ]() {
+                InferenceSession  session( model, 8 );
+                std::vector<real> results( 8 * 3 );
+                for( int repeat = 0; repeat < 50; ++repeat ) {
+                    for( size_t first = 0; first < samples; first += 8 ) {
+                        session.evaluate( 8, inputs.data( ) + (first * 2), results.data( ) );
+                        for( size_t i = 0; i < results.size( ); ++i ) {
+                            mismatches[ t ] += (results[ i ] != expected[ (first * 3) + i ]) ? 1 : 0;
+                        }
+                    }
+                }
+            } );
+        }
+        for( auto &&thread : threads ) { thread.join( ); }
+        for( auto &&m : mismatches ) { EXPECT_EQ( m, 0 ); }
+    }
+
+    TEST( MachineLearningTests, ModelLoadRejectsMalformed ) {
+        using namespace Core;
+
+        // one input plus its bias neuron feeding one output, laid out by hand so the steps can be broken
+        struct FileStep {
+            uint64_t src, srcCount, dst, dstCount, weightIndex;
+        };
+        const auto file = []( const uint64_t totalWeights, const std::vector<FileStep> &steps ) {
+            std::string bytes( "FAMD" );
+            const auto  put = [ &bytes ]( const void *value, const size_t size ) {
+                bytes.append( static_cast<const char *>( value ), size );
+            };
+            const uint32_t version = 2, realSize = sizeof( real ), identity = 0, dense = 0;
+            const uint64_t counts[7] = { 1, 0, 1, 2, 3, totalWeights, steps.size( ) };
+            const real     zero      = real( 0 );
+            put( &version, sizeof( version ) );
+            put( &realSize, sizeof( realSize ) );
+            put( counts, sizeof( counts ) );
+            for( auto &&step : steps ) {
+                put( &step, sizeof( step ) );
+                put( &identity, sizeof( identity ) );
+                put( &zero, sizeof( zero ) );
+                put( &zero, sizeof( zero ) );
+                put( &dense, sizeof( dense ) );
+                for( uint64_t w = 0; w < step.srcCount * step.dstCount; ++w ) { put( &zero, sizeof( zero ) ); }
+            }
+            return bytes;
+        };
+        const auto load = []( const std::string &bytes ) {
+            std::stringstream in( bytes );
+            return Model::load( in );
+        };
+
+        EXPECT_NE( load( file( 2, { { 0, 2, 2, 1, 0 } } ) ), nullptr );
+        EXPECT_EQ( load( file( 0, { { 0, 0, 2, 1, 0 } } ) ), nullptr );                   // no bias row
+        EXPECT_EQ( load( file( 0, { { 0, 2, 2, 0, 0 } } ) ), nullptr );                   // no destinations
+        EXPECT_EQ( load( file( 4, { { 0, 2, 2, 1, 0 }, { 0, 2, 2, 1, 0 } } ) ), nullptr ); // the same weights twice
+        EXPECT_EQ( load( file( 3, { { 0, 2, 2, 1, 1 } } ) ), nullptr );                   // a gap at the start
+    }
+
+    TEST( MachineLearningTests, ModelPublisherHotSwap ) {
+        using namespace Core;
+
+        auto inLayer  = std::make_shared<InputLayer>( 1 );
+        auto outLayer = std::make_shared<OutputLayer>( 1 );
+
+        ANNetwork ann{ };
+        ann.addLayer( inLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, outLayer ) );
+        ann.finalise( false );
+
+        // each version only has a bias weight, so its output identifies which model a reader saw
+        const size_t      versionCount = 200;
+        std::vector<real> versionOutput( versionCount );
+        for( size_t v = 0; v < versionCount; ++v ) {
+            const real input = 0;
+            ann.setWeights( { real( 0 ), real( v ) * real( 0.01 ) } );
+            ann.evaluate( &input, &versionOutput[ v ] );
+        }
+
+        ann.setWeights( { real( 0 ), real( 0 ) } );
+        ModelPublisher publisher( ann.createModel( ) );
+        std::weak_ptr<const Model> firstModel;
+
+        std::atomic<bool>        done( false );
+        std::vector<std::thread> threads;
+        std::vector<int>         errors( 4, 0 );
+        for( size_t t = 0; t < errors.size( ); ++t ) {
+            threads.emplace_back( [ &, t ]() {
+                auto              reader = publisher.createReader( );
+                InferenceSession  session;
+                size_t            lastVersion = 0;
+                const real        input       = 0;
+                while( !done.load( ) ) {
+                    real result;
+                    {
+                        ModelPublisher::ReadGuard model( *reader );
+                        session.evaluate( *model, 1, &input, &result );
+                    }
+
+                    auto it = std::find( versionOutput.begin( ) + lastVersion, versionOutput.end( ), result );
+                    if( it == versionOutput.end( ) ) {
+                        errors[ t ]++;
+                    } else {
+                        lastVersion = size_t( it - versionOutput.begin( ) );
+                    }
+                }
+            } );
+        }
+
+        for( size_t v = 1; v < versionCount; ++v ) {
+            ann.setWeights( { real( 0 ), real( v ) * real( 0.01 ) } );
+            auto model = ann.createModel( );
+            if( v == 1 ) { firstModel = model; }
+            publisher.publish( model );
+        }
+        done.store( true );
+        for( auto &&thread : threads ) { thread.join( ); }
+        for( auto &&e : errors ) { EXPECT_EQ( e, 0 ); }
+
+        // with no reader pinned everything retired can go, the latest model is still current
+        EXPECT_EQ( publisher.reclaim( ), 0 );
+        EXPECT_TRUE( firstModel.expired( ) );
+
+        auto reader = publisher.createReader( );
+        {
+            ModelPublisher::ReadGuard model( *reader );
+            InferenceSession          session;
+            const real                input = 0;
+            real                      result;
+            session.evaluate( *model, 1, &input, &result );
+            EXPECT_EQ( result, versionOutput.back( ) );
+        }
+    }
+
+    TEST( MachineLearningTests, EnsembleMatchesSeparateNetworks ) {
+        using namespace Core;
+
+        const size_t members = 5;
+        const auto   build   = []( ANNetwork &ann ) {
+            auto inLayer  = std::make_shared<InputLayer>( 1 );
+            auto hidLayer = std::make_shared<HiddenLayer>( 8 );
+            auto outLayer = std::make_shared<OutputLayer>( 1 );
+            ann.addLayer( inLayer );
+            ann.addLayer( hidLayer );
+            ann.addLayer( outLayer );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+            ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+            ann.finalise( true );
+        };
+
+        ANNetwork prototype{ };
+        build( prototype );
+        EnsembleNetwork ensemble( prototype, members );
+        Core::Random::seed( 0xDEA0DEA0 );
+        ensemble.setRandomWeights( );
+
+        // each member gets a separate network with the same weights and hyperparameters to compare against
+        std::vector<std::unique_ptr<ANNetwork>> reference;
+        for( size_t m = 0; m < members; ++m ) {
+            reference.emplace_back( new ANNetwork( ) );
+            const auto lr       = real( 0.1 ) * real( m + 1 );
+            const auto momentum = real( 0.2 ) * real( m );
+            reference[ m ]->setLearningRate( lr );
+            reference[ m ]->setMomentum( momentum );
+            build( *reference[ m ] );
+            reference[ m ]->setWeights( ensemble.getMemberWeights( m ) );
+            ensemble.setLearningRate( m, lr );
+            ensemble.setMomentum( m, momentum );
+        }
+
+        std::vector<real> results( members ), expected( 1 );
+        for( int step = 0; step < 20; ++step ) {
+            for( int b = 0; b < 4; ++b ) {
+                const real input = real( (step * 4) + b ) * real( 0.05 ) - real( 2 );
+                const real target = real( 0.5 ) + (real( 0.4 ) * std::sin( input ));
+                VectorALU::const_real_array_ptr perfect = &target;
+
+                ensemble.evaluate( &input, results.data( ) );
+                ensemble.computeGradients( perfect );
+                for( size_t m = 0; m < members; ++m ) {
+                    reference[ m ]->evaluate( &input, expected.data( ) );
+                    reference[ m ]->computeGradients( perfect );
+                    EXPECT_NEAR( results[ m ], expected[ 0 ], 1e-4 );
+                }
+            }
+            ensemble.updateWeights( );
+            for( auto &&r : reference ) { r->updateWeights( ); }
+        }
+
+        for( size_t m = 0; m < members; ++m ) {
+            const auto got  = ensemble.getMemberWeights( m );
+            const auto want = reference[ m ]->getWeights( );
+            ASSERT_EQ( got.size( ), want.size( ) );
+            for( size_t i = 0; i < got.size( ); ++i ) {
+                EXPECT_NEAR( got[ i ], want[ i ], 1e-3 * std::max( real( 1 ), std::fabs( want[ i ] ) ) );
+            }
+        }
+    }
+
+    TEST( MachineLearningTests, HyperParameterSearch ) {
+        using namespace Core;
+
+        std::vector<real> xs( 64 ), ys( 64 );
+        std::vector<ANNetwork::MatchingPair> training, test;
+        for( size_t i = 0; i < xs.size( ); ++i ) {
+            xs[ i ] = (real( i ) / real( 63 ) * real( 6 )) - real( 3 );
+            ys[ i ] = real( 0.5 ) + (real( 0.4 ) * std::sin( xs[ i ] ));
+            ((i % 4) == 0 ? test : training).emplace_back( &xs[ i ], &ys[ i ] );
+        }
+
+        HyperParameterSearch::SearchSpace space;
+        space.learningRates     = { real( 0.05 ), real( 0.5 ), real( 2 ) };
+        space.momentums         = { real( 0 ), real( 0.5 ) };
+        space.hiddenLayouts     = { { 4 }, { 8, 4 } };
+        space.hiddenActivations = { ActivationFunctionType::Sigmoid, ActivationFunctionType::HyperbolicTangent };
+
+        const auto grid = HyperParameterSearch::grid( space );
+        EXPECT_EQ( grid.size( ), 3u * 2u * 2u * 2u );
+        const auto random = HyperParameterSearch::random( space, 10, 1234 );
+        ASSERT_EQ( random.size( ), 10u );
+        for( auto &&params : random ) {
+            EXPECT_GE( params.learningRate, real( 0.05 ) * real( 0.999 ) );
+            EXPECT_LE( params.learningRate, real( 2 ) * real( 1.001 ) );
+        }
+
+        HyperParameterSearch::Config config;
+        config.maxEpochs        = 12;
+        config.threadCount      = 4;
+        config.halvingMinEpochs = 2;
+        HyperParameterSearch search( 1, 1, training, test, config );
+
+        const auto run = search.run( grid );
+        ASSERT_EQ( run.size( ), grid.size( ) );
+        size_t stopped = 0;
+        for( size_t i = 0; i < run.size( ); ++i ) {
+            stopped += run[ i ].stoppedEarly ? 1 : 0;
+            EXPECT_LE( run[ i ].epochs, config.maxEpochs );
+            EXPECT_EQ( run[ i ].stoppedEarly, run[ i ].epochs < config.maxEpochs );
+            // full length runs are ranked first, each group by test RMS
+            if( i > 0 && run[ i ].stoppedEarly == run[ i - 1 ].stoppedEarly ) {
+                EXPECT_GE( run[ i ].testRMS, run[ i - 1 ].testRMS );
+            }
+        }
+        EXPECT_GT( stopped, 0u );
+        EXPECT_LT( stopped, grid.size( ) );
+
+        // 24 candidates over rungs of 2, 6 and 12 epochs leaves 3 that reach maxEpochs, and it is repeatable
+        const auto halving = search.successiveHalving( grid );
+        ASSERT_EQ( halving.size( ), grid.size( ) );
+        for( size_t i = 0; i < halving.size( ); ++i ) {
+            EXPECT_EQ( halving[ i ].stoppedEarly, i >= 3 );
+            EXPECT_EQ( halving[ i ].epochs, (i < 3) ? config.maxEpochs : (i < 8) ? 6u : 2u );
+        }
+
+        const auto again = search.successiveHalving( grid );
+        EXPECT_EQ( again[ 0 ].testRMS, halving[ 0 ].testRMS );
+
+        std::ostringstream table;
+        const auto         flags = table.flags( );
+        HyperParameterSearch::writeTable( table, halving );
+        EXPECT_NE( table.str( ).find( "test RMS" ), std::string::npos );
+        EXPECT_EQ( table.flags( ), flags );
+    }
+
+    TEST( MachineLearningTests, GradientTapeMatchesBackprop ) {
+        using namespace Core;
+
+        const size_t batch = 3;
+        ANNetwork    ann{ };
+        auto         inLayer  = std::make_shared<InputLayer>( 2 );
+        auto         hidLayer = std::make_shared<HiddenLayer>( 4, ActivationFunctionType::HyperbolicTangent );
+        auto         outLayer = std::make_shared<OutputLayer>( 2 );
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        ann.finalise( true, batch );
+        RandomStream stream( 0xDEA0DEA0, 0 );
+        ann.setRandomWeights( stream );
+
+        // the same network recorded on a tape, weights packed the way the network packs each connection
+        auto         alu = VectorALUFactory( );
+        GradientTape tape( batch );
+        const auto   x      = tape.input( 2 );
+        const auto   target = tape.input( 2 );
+        const auto   w0     = tape.parameter( 3 * 4 );
+        const auto   w1     = tape.parameter( 5 * 2 );
+        const auto   hidden = tape.dense( x, w0, 4, ActivationKernel::HyperbolicTangent );
+        const auto   y      = tape.dense( hidden, w1, 2, ActivationKernel::Sigmoid );
+        const auto   loss   = tape.sumSquaredError( y, target );
+        tape.finalise( );
+
+        const auto weights = ann.getWeights( );
+        alu->packPanels( 3, 4, weights.data( ), 4, false, tape.getPanelWidth( ), tape.value( w0 ) );
+        alu->packPanels( 5, 2, weights.data( ) + 12, 2, false, tape.getPanelWidth( ), tape.value( w1 ) );
+
+        // two batches through both, gradients accumulate the same way
+        std::vector<real> results( batch * 2 ), expected( batch * 2 );
+        for( int pass = 0; pass < 2; ++pass ) {
+            std::vector<real> inputs( batch * 2 ), perfect( batch * 2 );
+            stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+            stream.fillUniform( perfect.size( ), real( 0 ), real( 1 ), perfect.data( ) );
+
+            ann.evaluate( batch, inputs.data( ), expected.data( ) );
+            ann.computeGradients( batch, perfect.data( ) );
+
+            tape.setRows( x, batch, inputs.data( ) );
+            tape.setRows( target, batch, perfect.data( ) );
+            tape.forward( batch );
+            tape.backward( loss );
+            tape.getRows( y, batch, results.data( ) );
+
+            real sse = 0;
+            for( size_t i = 0; i < results.size( ); ++i ) {
+                EXPECT_NEAR( results[ i ], expected[ i ], 1e-5 );
+                sse += real( 0.5 ) * (expected[ i ] - perfect[ i ]) * (expected[ i ] - perfect[ i ]);
+            }
+            EXPECT_NEAR( tape.value( loss )[ 0 ], sse, 1e-5 );
+        }
+
+        std::vector<real> got( weights.size( ) );
+        alu->unpackPanels( 3, 4, tape.gradient( w0 ), tape.getPanelWidth( ), got.data( ), 4 );
+        alu->unpackPanels( 5, 2, tape.gradient( w1 ), tape.getPanelWidth( ), got.data( ) + 12, 2 );
+        const auto want = ann.getGradients( );
+        ASSERT_EQ( got.size( ), want.size( ) );
+        for( size_t i = 0; i < got.size( ); ++i ) {
+            EXPECT_NEAR( got[ i ], want[ i ], 1e-5 ) << i;
+        }
+
+        tape.zeroGradients( );
+        EXPECT_EQ( tape.gradient( w0 )[ 0 ], real( 0 ) );
+    }
+
+    TEST( MachineLearningTests, GradientTapeElementwiseOps ) {
+        using namespace Core;
+
+        // loss = 1/2 | sigmoid( p * q ) + p - q - t |^2 checked against central differences
+        GradientTape tape{ };
+        const auto   p    = tape.parameter( 3 );
+        const auto   q    = tape.parameter( 3 );
+        const auto   t    = tape.parameter( 3 );
+        const auto   z    = tape.sub( tape.add( tape.activate( tape.mul( p, q ), ActivationKernel::Sigmoid ), p ), q );
+        const auto   loss = tape.sumSquaredError( z, t );
+        tape.finalise( );
+        EXPECT_EQ( tape.getOpCount( ), 5u );
+
+        const real init[3][3] = { { 0.5f, -1.0f, 2.0f }, { 1.5f, 0.25f, -0.75f }, { 0.1f, 0.2f, 0.3f } };
+        for( int i = 0; i < 3; ++i ) {
+            tape.value( p )[ i ] = init[ 0 ][ i ];
+            tape.value( q )[ i ] = init[ 1 ][ i ];
+            tape.value( t )[ i ] = init[ 2 ][ i ];
+        }
+        tape.forward( );
+        tape.backward( loss );
+
+        const real h = real( 1e-2 );
+        for( const auto v : { p, q, t } ) {
+            for( int i = 0; i < 3; ++i ) {
+                const real orig = tape.value( v )[ i ];
+                tape.value( v )[ i ] = orig + h;
+                tape.forward( );
+                const real up = tape.value( loss )[ 0 ];
+                tape.value( v )[ i ] = orig - h;
+                tape.forward( );
+                const real down = tape.value( loss )[ 0 ];
+                tape.value( v )[ i ] = orig;
+                EXPECT_NEAR( tape.gradient( v )[ i ], (up - down) / (2 * h), 2e-3 );
+            }
+        }
+    }
+
+    TEST( MachineLearningTests, ConvolutionMatchesDirect ) {
+        using namespace Core;
+
+        // 1D, 9 positions of 2 channels, kernel 3 wide to 3 channels with stride 2 -> 4 positions
+        const Convolution conv1( LayerView( { 9, 2 } ), LayerView( { 3, 3 } ), 2 );
+        EXPECT_EQ( conv1.getOutputView( ).sizeOfDimension( 0 ), 4u );
+        EXPECT_EQ( conv1.getOutputView( ).sizeOfDimension( 1 ), 3u );
+        EXPECT_EQ( conv1.getWeightCount( ), 7u * 3u );
+
+        // 2D, 5 x 4 x 2 input, 2 x 3 kernel to 2 channels, stride 1 -> 4 x 2 x 2
+        const Convolution conv2( LayerView( { 5, 4, 2 } ), LayerView( { 2, 3, 2 } ) );
+        EXPECT_EQ( conv2.getOutputSize( ), 16u );
+
+        const size_t batch = 2;
+        auto         alu   = VectorALUFactory( );
+        RandomStream stream( 39, 0 );
+
+        for( const Convolution *conv : { &conv1, &conv2 } ) {
+            GradientTape tape( batch );
+            const auto   x      = tape.input( conv->getInputSize( ) );
+            const auto   target = tape.input( conv->getOutputSize( ) );
+            const auto   w      = tape.parameter( conv->getWeightCount( ) );
+            const auto   y      = tape.convolution( x, w, *conv, ActivationKernel::HyperbolicTangent );
+            const auto   loss   = tape.sumSquaredError( y, target );
+            tape.finalise( );
+
+            const size_t      k = conv->getPatchSize( ) + 1, channels = conv->getOutputChannels( );
+            std::vector<real> weights( conv->getWeightCount( ) ), inputs( batch * conv->getInputSize( ) ),
+                              perfect( batch * conv->getOutputSize( ) );
+            stream.fillUniform( weights.size( ), real( -0.5 ), real( 0.5 ), weights.data( ) );
+            stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+            stream.fillUniform( perfect.size( ), real( -1 ), real( 1 ), perfect.data( ) );
+            alu->packPanels( k, channels, weights.data( ), channels, false, tape.getPanelWidth( ), tape.value( w ) );
+            tape.setRows( x, batch, inputs.data( ) );
+            tape.setRows( target, batch, perfect.data( ) );
+            tape.forward( batch );
+            tape.backward( loss );
+
+            // direct convolution over the views
+            const auto        &in  = conv->getInputView( );
+            const auto        &out = conv->getOutputView( );
+            const bool        is2D = in.numberOfDimensions( ) == 3;
+            const size_t      stride = is2D ? 1 : 2, kh = is2D ? 2 : 3, kw = is2D ? 3 : 1;
+            const size_t      inW = is2D ? in.sizeOfDimension( 1 ) : 1, outW = is2D ? out.sizeOfDimension( 1 ) : 1;
+            const size_t      inC = conv->getInputChannels( );
+            std::vector<real> results( batch * conv->getOutputSize( ) );
+            tape.getRows( y, batch, results.data( ) );
+            for( size_t b = 0; b < batch; ++b ) {
+                for( size_t oy = 0; oy < out.sizeOfDimension( 0 ); ++oy ) {
+                    for( size_t ox = 0; ox < outW; ++ox ) {
+                        for( size_t c = 0; c < channels; ++c ) {
+                            real   sum = weights[ ((k - 1) * channels) + c ];
+                            size_t j   = 0;
+                            for( size_t ky = 0; ky < kh; ++ky ) {
+                                for( size_t kx = 0; kx < kw; ++kx ) {
+                                    for( size_t ic = 0; ic < inC; ++ic, ++j ) {
+                                        const size_t at = ((((oy * stride) + ky) * inW) + (ox * stride) + kx) * inC;
+                                        sum += inputs[ (b * conv->getInputSize( )) + at + ic ] *
+                                               weights[ (j * channels) + c ];
+                                    }
+                                }
+                            }
+                            const size_t o = (b * conv->getOutputSize( )) + (((oy * outW) + ox) * channels) + c;
+                            EXPECT_NEAR( results[ o ], std::tanh( sum ), 1e-5 );
+                        }
+                    }
+                }
+            }
+
+            // shared weight gradients against central differences
+            std::vector<real> grads( weights.size( ) );
+            alu->unpackPanels( k, channels, tape.gradient( w ), tape.getPanelWidth( ), grads.data( ), channels );
+            const real h = real( 1e-2 );
+            for( size_t i = 0; i < weights.size( ); i += 5 ) {
+                std::vector<real> probe = weights;
+                probe[ i ] = weights[ i ] + h;
+                alu->packPanels( k, channels, probe.data( ), channels, false, tape.getPanelWidth( ), tape.value( w ) );
+                tape.forward( batch );
+                const real up = tape.value( loss )[ 0 ];
+                probe[ i ] = weights[ i ] - h;
+                alu->packPanels( k, channels, probe.data( ), channels, false, tape.getPanelWidth( ), tape.value( w ) );
+                tape.forward( batch );
+                const real down = tape.value( loss )[ 0 ];
+                EXPECT_NEAR( grads[ i ], (up - down) / (2 * h), 5e-3 * std::max( real( 1 ), std::fabs( grads[ i ] ) ) );
+            }
+        }
+
+        // stacked, so the first layers gradient has to come back through the second layers col2im
+        const Convolution first( LayerView( { 9, 2 } ), LayerView( { 3, 3 } ) );
+        const Convolution second( first.getOutputView( ), LayerView( { 2, 1 } ), 2 );
+        GradientTape      tape{ };
+        const auto        x      = tape.input( first.getInputSize( ) );
+        const auto        target = tape.input( second.getOutputSize( ) );
+        const auto        w0     = tape.parameter( first.getWeightCount( ) );
+        const auto        w1     = tape.parameter( second.getWeightCount( ) );
+        const auto        y      = tape.convolution( tape.convolution( x, w0, first, ActivationKernel::Sigmoid ), w1,
+                                                     second );
+        const auto        loss   = tape.sumSquaredError( y, target );
+        tape.finalise( );
+
+        stream.fillUniform( first.getInputSize( ), real( -1 ), real( 1 ), tape.value( x ) );
+        stream.fillUniform( second.getOutputSize( ), real( -1 ), real( 1 ), tape.value( target ) );
+        stream.fillUniform( first.getWeightCount( ), real( -1 ), real( 1 ), tape.value( w0 ) );
+        stream.fillUniform( second.getWeightCount( ), real( -1 ), real( 1 ), tape.value( w1 ) );
+        tape.forward( );
+        tape.backward( loss );
+
+        // any element is fine for a central difference, the packing only moves them around
+        const real h = real( 1e-2 );
+        for( size_t i = 0; i < first.getWeightCount( ); i += 3 ) {
+            const real orig = tape.value( w0 )[ i ];
+            tape.value( w0 )[ i ] = orig + h;
+            tape.forward( );
+            const real up = tape.value( loss )[ 0 ];
+            tape.value( w0 )[ i ] = orig - h;
+            tape.forward( );
+            const real down = tape.value( loss )[ 0 ];
+            tape.value( w0 )[ i ] = orig;
+            EXPECT_NEAR( tape.gradient( w0 )[ i ], (up - down) / (2 * h), 2e-3 );
+        }
+    }
+
+    TEST( MachineLearningTests, ClassicalApproximators ) {
+        using namespace Core;
+
+        const ScalarFunction sine = []( const real x ) { return std::sin( x ); };
+        const real           pi   = real( M_PI );
+
+        auto cheb = ChebyshevApproximator::fit( sine, -pi, pi, real( 1e-5 ) );
+        ASSERT_TRUE( cheb );
+        EXPECT_LE( cheb->maxError( sine, -pi, pi, 10000 ), real( 1e-5 ) );
+        EXPECT_LT( cheb->getParameterCount( ), 24u );
+        // odd function, the even coefficients vanish
+        EXPECT_NEAR( cheb->getCoefficients( )[ 0 ], 0, 1e-6 );
+        EXPECT_NEAR( cheb->getCoefficients( )[ 2 ], 0, 1e-6 );
+
+        auto spline = SplineApproximator::fit( sine, -pi, pi, real( 1e-4 ) );
+        ASSERT_TRUE( spline );
+        EXPECT_LE( spline->maxError( sine, -pi, pi, 10000 ), real( 1e-4 ) );
+        const real outside[ 3 ] = { std::numeric_limits<real>::quiet_NaN( ), -10 * pi, 10 * pi };
+        real       clamped[ 3 ];
+        spline->evaluate( 3, outside, clamped );
+        EXPECT_TRUE( std::isnan( clamped[ 0 ] ) );
+        EXPECT_TRUE( std::isfinite( clamped[ 1 ] ) && std::isfinite( clamped[ 2 ] ) );
+
+        // a kink defeats the series at this tolerance but the spline only needs more knots
+        const ScalarFunction kink = []( const real x ) { return std::fabs( x ); };
+        EXPECT_FALSE( ChebyshevApproximator::fit( kink, real( -1 ), real( 1 ), real( 1e-6 ), 256 ) );
+        EXPECT_TRUE( SplineApproximator::fit( kink, real( -1 ), real( 1 ), real( 1e-3 ) ) );
+
+        // a network fits behind the same interface, batches beyond the session size are sliced
+        ANNetwork ann{ };
+        auto      inLayer  = std::make_shared<InputLayer>( 1 );
+        auto      hidLayer = std::make_shared<HiddenLayer>( 4 );
+        auto      outLayer = std::make_shared<OutputLayer>( 1 );
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        ann.finalise( false, 1 );
+        RandomStream stream( 40, 0 );
+        ann.setRandomWeights( stream );
+
+        NetworkApproximator net( ann.createModel( ), 8 );
+        std::vector<Approximator *> approximators = { cheb.get( ), spline.get( ), &net };
+        std::vector<real>           xs( 100 ), ys( 100 );
+        stream.fillUniform( xs.size( ), -pi, pi, xs.data( ) );
+        for( auto &&approx : approximators ) {
+            approx->evaluate( xs.size( ), xs.data( ), ys.data( ) );
+            for( size_t i = 0; i < xs.size( ); ++i ) {
+                real single;
+                approx->evaluate( &xs[ i ], &single );
+                EXPECT_EQ( single, ys[ i ] );
+                if( approx != &net ) {
+                    EXPECT_NEAR( ys[ i ], std::sin( xs[ i ] ), 1e-4 );
+                } else {
+                    real expected;
+                    ann.evaluate( &xs[ i ], &expected );
+                    EXPECT_NEAR( ys[ i ], expected, 1e-6 );
+                }
+            }
+        }
+    }
+
+    TEST( MachineLearningTests, PiecewiseLinearDistillation ) {
+        using namespace Core;
+
+        const auto build = []( ANNetwork &ann, const ActivationFunctionType hidden ) {
+            auto inLayer  = std::make_shared<InputLayer>( 1 );
+            auto hid0     = std::make_shared<HiddenLayer>( 8, hidden );
+            auto hid1     = std::make_shared<HiddenLayer>( 6, hidden );
+            auto outLayer = std::make_shared<OutputLayer>( 1 );
+            ann.addLayer( inLayer );
+            ann.addLayer( hid0 );
+            ann.addLayer( hid1 );
+            ann.addLayer( outLayer );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, hid0 ) );
+            ann.connectLayers( std::make_shared<Connections>( hid0, hid1 ) );
+            ann.connectLayers( std::make_shared<Connections>( hid1, outLayer ) );
+            ann.finalise( false, 1 );
+            RandomStream stream( 41, 0 );
+            std::vector<real> weights( ann.getTotalWeightCount( ) );
+            stream.fillUniform( weights.size( ), real( -1 ), real( 1 ), weights.data( ) );
+            ann.setWeights( weights );
+        };
+
+        ANNetwork relu{ };
+        build( relu, ActivationFunctionType::ReLU );
+        NetworkApproximator net( relu.createModel( ), 64 );
+
+        // exact, apart from float rounding, and well short of a breakpoint per unit per layer
+        auto pwl = PiecewiseLinearApproximator::fromModel( *relu.createModel( ), real( -4 ), real( 4 ) );
+        ASSERT_TRUE( pwl );
+        EXPECT_LE( pwl->maxError( net, real( -4 ), real( 4 ), 20001 ), real( 1e-5 ) );
+        EXPECT_GE( pwl->getSegmentCount( ), 2u );
+        EXPECT_LE( pwl->getSegmentCount( ), 1u + 8u + (8u + 1u) * 6u );
+        const auto breaks = pwl->getBreakpoints( );
+        EXPECT_TRUE( std::is_sorted( breaks.begin( ), breaks.end( ) ) );
+
+        // beyond the range the end pieces carry on, as the network does
+        EXPECT_LE( pwl->maxError( net, real( -6 ), real( -4 ), 101 ), real( 1e-5 ) );
+
+        ANNetwork smooth{ };
+        build( smooth, ActivationFunctionType::HyperbolicTangent );
+        EXPECT_FALSE( PiecewiseLinearApproximator::fromModel( *smooth.createModel( ), real( -4 ), real( 4 ) ) );
+
+        NetworkApproximator smoothNet( smooth.createModel( ), 64 );
+        auto                lut = LookupTableApproximator::tabulate( smoothNet, real( -4 ), real( 4 ), real( 1e-4 ) );
+        ASSERT_TRUE( lut );
+        EXPECT_LE( lut->maxError( smoothNet, real( -4 ), real( 4 ), 20001 ), real( 1e-4 ) );
+        EXPECT_LE( lut->getIntervalCount( ), 4096u );
+
+        // clamped outside the table
+        real edge, beyond;
+        const real x4 = real( 4 ), x9 = real( 9 );
+        lut->evaluate( &x4, &edge );
+        lut->evaluate( &x9, &beyond );
+        EXPECT_EQ( edge, beyond );
+    }
+
+    TEST( MachineLearningTests, LBFGSTrainer ) {
+        using namespace Core;
+
+        // 0.5 + 0.4 sin( 3x ) over [ -1, 1 ], well inside the sigmoid output
+        const size_t      sampleCount = 64;
+        std::vector<real> xs( sampleCount ), ys( sampleCount );
+        for( size_t i = 0; i < sampleCount; ++i ) {
+            xs[ i ] = real( -1 ) + (real( 2 ) * real( i ) / real( sampleCount - 1 ));
+            ys[ i ] = real( 0.5 ) + (real( 0.4 ) * std::sin( real( 3 ) * xs[ i ] ));
+        }
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t i = 0; i < sampleCount; ++i ) { set.emplace_back( &xs[ i ], &ys[ i ] ); }
+
+        auto build = []( ANNetwork &ann ) {
+            auto inLayer  = std::make_shared<InputLayer>( 1 );
+            auto hidLayer = std::make_shared<HiddenLayer>( 8, ActivationFunctionType::HyperbolicTangent );
+            auto outLayer = std::make_shared<OutputLayer>( 1 );
+            ann.addLayer( inLayer );
+            ann.addLayer( hidLayer );
+            ann.addLayer( outLayer );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+            ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+            ann.finalise( true, 16 );
+            RandomStream stream( 0x1BF65, 0 );
+            ann.setRandomWeights( stream );
+        };
+
+        // the same start, the same budget of passes over the set
+        ANNetwork sgd{ };
+        build( sgd );
+        const real start = sgd.testError( set );
+        real       sgdError = start;
+        for( int epoch = 0; epoch < 100; ++epoch ) { sgdError = sgd.trainEpoch( set ); }
+
+        ANNetwork quasi{ };
+        build( quasi );
+        LBFGSTrainer::Config config;
+        config.maxIterations = 60;
+        LBFGSTrainer trainer( quasi, config );
+        const auto   result = trainer.train( set );
+
+        EXPECT_LE( result.evaluations, 100u );
+        EXPECT_GT( result.iterations, 0u );
+        EXPECT_GT( trainer.getHistoryCount( ), 0u );
+        EXPECT_LT( result.rms, start * real( 0.1 ) );
+        EXPECT_LT( result.rms, sgdError * real( 0.5 ) );
+
+        // the network is left at the reported point with no gradients pending
+        EXPECT_NEAR( quasi.testError( set ), result.rms, 1e-5 );
+        for( auto g : quasi.getGradients( ) ) { EXPECT_EQ( g, real( 0 ) ); }
+
+        // more iterations carry on from there and never go uphill
+        const auto more = trainer.train( set );
+        EXPECT_LE( more.loss, result.loss );
+    }
+
+    TEST( MachineLearningTests, FreezeForInference ) {
+        using namespace Core;
+
+        ANNetwork ann{ };
+        auto      inLayer  = std::make_shared<InputLayer>( 2 );
+        auto      hidLayer = std::make_shared<HiddenLayer>( 12, ActivationFunctionType::HyperbolicTangent );
+        auto      outLayer = std::make_shared<OutputLayer>( 1 );
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        ann.setOptimizer( std::make_shared<AdamOptimizer>( ) );
+        ann.finalise( true, 4 );
+        RandomStream stream( 43, 0 );
+        ann.setRandomWeights( stream );
+
+        std::vector<real> inputs( 8 ), perfect( 4 );
+        stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+        stream.fillUniform( perfect.size( ), real( 0 ), real( 1 ), perfect.data( ) );
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t i = 0; i < 4; ++i ) { set.emplace_back( &inputs[ 2 * i ], &perfect[ i ] ); }
+        ann.trainEpoch( set );
+
+        const size_t weightBytes = ann.getTotalWeightCount( ) * sizeof( real );
+        const size_t rowBytes    = ann.getTotalNeuronCount( ) * 4 * sizeof( real );
+        const auto   training    = ann.getMemoryUsage( );
+        EXPECT_EQ( training.weights, weightBytes );
+        EXPECT_EQ( training.activations, rowBytes );
+        EXPECT_EQ( training.preActivations, rowBytes );
+        EXPECT_EQ( training.deltas, rowBytes );
+        EXPECT_EQ( training.gradients, weightBytes );
+        EXPECT_EQ( training.backpropWeights, weightBytes );
+        EXPECT_EQ( training.optimizerState, 2 * weightBytes );
+
+        std::vector<real> before( 4 ), after( 4 );
+        ann.evaluate( 4, inputs.data( ), before.data( ) );
+        const auto weights = ann.getWeights( );
+
+        EXPECT_FALSE( ann.isFrozen( ) );
+        ann.freezeForInference( );
+        EXPECT_TRUE( ann.isFrozen( ) );
+
+        // only what evaluate reads is left
+        const auto frozen = ann.getMemoryUsage( );
+        EXPECT_EQ( frozen.weights, weightBytes );
+        EXPECT_EQ( frozen.activations, rowBytes );
+        EXPECT_EQ( frozen.total( ), weightBytes + rowBytes );
+        EXPECT_LT( frozen.total( ) * 3, training.total( ) );
+
+        ann.evaluate( 4, inputs.data( ), after.data( ) );
+        EXPECT_EQ( before, after );
+        EXPECT_EQ( ann.getWeights( ), weights );
+
+        auto model = ann.createModel( );
+        EXPECT_GE( model->getMemoryBytes( ), weightBytes );
+        InferenceSession session( model, 4 );
+        EXPECT_EQ( session.getMemoryBytes( ), rowBytes );
+        session.evaluate( 4, inputs.data( ), after.data( ) );
+        for( size_t i = 0; i < 4; ++i ) { EXPECT_NEAR( after[ i ], before[ i ], 1e-6 ); }
+    }
+
+    TEST( MachineLearningTests, NeuronPruning ) {
+        using namespace Core;
+
+        ANNetwork ann{ };
+        auto      inLayer  = std::make_shared<InputLayer>( 2 );
+        auto      hidLayer = std::make_shared<HiddenLayer>( 8, ActivationFunctionType::HyperbolicTangent );
+        auto      hid2     = std::make_shared<HiddenLayer>( 4, ActivationFunctionType::ReLU, real( -0.1 ),
+                                                              real( -0.05 ) );
+        auto      outLayer = std::make_shared<OutputLayer>( 1 );
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( hid2 );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, hid2 ) );
+        ann.connectLayers( std::make_shared<Connections>( hid2, outLayer ) );
+        ann.finalise( true, 8 );
+
+        // odd first layer neurons ignore the inputs so are constant, the middle two of the second feed nothing
+        RandomStream      stream( 44, 0 );
+        std::vector<real> weights( ann.getTotalWeightCount( ) );
+        stream.fillUniform( weights.size( ), real( -1 ), real( 1 ), weights.data( ) );
+        for( size_t j = 1; j < 8; j += 2 ) { weights[ j ] = weights[ 8 + j ] = real( 0 ); }
+        const size_t last = (3 * 8) + (9 * 4);
+        weights[ last + 1 ] = weights[ last + 2 ] = real( 0 );
+        ann.setWeights( weights );
+
+        std::vector<real> inputs( 2 * 50 ), targets( 50 );
+        stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+        stream.fillUniform( targets.size( ), real( 0.2 ), real( 0.8 ), targets.data( ) );
+        std::vector<ANNetwork::MatchingPair> calibration;
+        for( size_t i = 0; i < 50; ++i ) { calibration.emplace_back( &inputs[ 2 * i ], &targets[ i ] ); }
+
+        const auto scores = NeuronPruning::scoreNeurons( ann, calibration );
+        ASSERT_EQ( scores.size( ), 2u );
+        ASSERT_EQ( scores[ 0 ].size( ), 8u );
+        ASSERT_EQ( scores[ 1 ].size( ), 4u );
+        for( size_t j = 0; j < 8; ++j ) {
+            if( j & 1 ) { EXPECT_NEAR( scores[ 0 ][ j ], real( 0 ), 1e-3 ); } else { EXPECT_GT( scores[ 0 ][ j ], 0 ); }
+        }
+        EXPECT_EQ( scores[ 1 ][ 1 ], real( 0 ) );
+        EXPECT_EQ( scores[ 1 ][ 2 ], real( 0 ) );
+
+        // removing exactly those, with the constants folded into the biases, changes nothing
+        NeuronPruning::Config config;
+        config.keepFraction = real( 0.5 );
+        auto pruned = NeuronPruning::prune( ann, calibration, config );
+        ASSERT_TRUE( pruned );
+        EXPECT_EQ( pruned->getLayerCount( ), 4u );
+        EXPECT_EQ( pruned->getTotalWeightCount( ), (3u * 4u) + (5u * 2u) + (3u * 1u) );
+        const auto &prunedFunc = (*std::next( pruned->cbegin( ), 2 ))->getActivationFunc( );
+        EXPECT_EQ( prunedFunc.getParam0( ), real( -0.1 ) );
+        EXPECT_EQ( prunedFunc.getParam1( ), real( -0.05 ) );
+
+        std::vector<real> expected( 50 ), got( 50 );
+        ann.evaluate( 8, inputs.data( ), expected.data( ) );
+        pruned->evaluate( 8, inputs.data( ), got.data( ) );
+        for( size_t i = 0; i < 8; ++i ) { EXPECT_NEAR( got[ i ], expected[ i ], 1e-5 ); }
+        EXPECT_NEAR( pruned->testError( calibration ), ann.testError( calibration ), 1e-5 );
+
+        // the fine tune pass trains the smaller network on the calibration set
+        config.fineTuneEpochs = 20;
+        auto tuned = NeuronPruning::prune( ann, calibration, config );
+        EXPECT_LT( tuned->testError( calibration ), pruned->testError( calibration ) );
+    }
+
+    TEST( MachineLearningTests, DatasetEvaluator ) {
+        using namespace Core;
+
+        ANNetwork ann{ };
+        auto      inLayer  = std::make_shared<InputLayer>( 3 );
+        auto      hidLayer = std::make_shared<HiddenLayer>( 10, ActivationFunctionType::HyperbolicTangent );
+        auto      outLayer = std::make_shared<OutputLayer>( 2 );
+        ann.addLayer( inLayer );
+        ann.addLayer( hidLayer );
+        ann.addLayer( outLayer );
+        ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer ) );
+        ann.connectLayers( std::make_shared<Connections>( hidLayer, outLayer ) );
+        ann.finalise( false, 1 );
+        RandomStream stream( 45, 0 );
+        ann.setRandomWeights( stream );
+
+        // an odd size so the last batch and chunk are partial
+        const size_t      count = 1237;
+        std::vector<real> inputs( count * 3 ), perfect( count * 2 );
+        stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+        stream.fillUniform( perfect.size( ), real( 0 ), real( 1 ), perfect.data( ) );
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t i = 0; i < count; ++i ) { set.emplace_back( &inputs[ 3 * i ], &perfect[ 2 * i ] ); }
+
+        double sse = 0, sae = 0, worst = 0;
+        real   out[2];
+        for( size_t i = 0; i < count; ++i ) {
+            ann.evaluate( set[ i ].first, out );
+            for( size_t o = 0; o < 2; ++o ) {
+                const double e = std::fabs( double( out[ o ] ) - perfect[ (2 * i) + o ] );
+                sse += e * e;
+                sae += e;
+                worst = std::max( worst, e );
+            }
+        }
+
+        DatasetEvaluator::Config config;
+        config.threadCount = 1;
+        config.batchSize   = 16;
+        DatasetEvaluator serial( config );
+        config.threadCount = 4;
+        DatasetEvaluator parallel( config );
+
+        const auto model = ann.createModel( );
+        const auto a     = serial.evaluate( *model, set );
+        const auto b     = parallel.evaluate( *model, set );
+
+        EXPECT_EQ( a.sampleCount, count );
+        EXPECT_EQ( a.valueCount, count * 2 );
+        EXPECT_NEAR( a.rms, std::sqrt( sse / double( count * 2 ) ), 1e-5 );
+        EXPECT_NEAR( a.mae, sae / double( count * 2 ), 1e-5 );
+        EXPECT_NEAR( a.maxAbs, worst, 1e-6 );
+
+        // fixed chunks combined in order, the thread count changes nothing
+        EXPECT_EQ( a.rms, b.rms );
+        EXPECT_EQ( a.mae, b.mae );
+        EXPECT_EQ( a.maxAbs, b.maxAbs );
+        EXPECT_EQ( a.histogram, b.histogram );
+
+        ASSERT_EQ( a.histogram.size( ), config.histogramBins );
+        ASSERT_EQ( a.histogramEdges.size( ), config.histogramBins - 1 );
+        EXPECT_NEAR( a.histogramEdges.front( ), config.histogramMin, 1e-9 );
+        EXPECT_NEAR( a.histogramEdges.back( ), config.histogramMax, 1e-5 );
+        EXPECT_TRUE( std::is_sorted( a.histogramEdges.begin( ), a.histogramEdges.end( ) ) );
+        size_t total = 0;
+        for( auto &&c : a.histogram ) { total += c; }
+        EXPECT_EQ( total, a.valueCount );
+        EXPECT_EQ( a.histogram.back( ), 0u ); // sigmoid outputs against [ 0, 1 ) targets never miss by 1
+        EXPECT_EQ( a.nonFinite, 0u );
+
+        // non finite targets are counted, land in the last bin and show in the max whatever order they come in
+        perfect[ 2 * 5 ]         = std::numeric_limits<real>::infinity( );
+        perfect[ (2 * 700) + 1 ] = std::numeric_limits<real>::quiet_NaN( );
+        const auto c = serial.evaluate( *model, set );
+        EXPECT_EQ( c.nonFinite, 2u );
+        EXPECT_EQ( c.histogram.back( ), 2u );
+        EXPECT_TRUE( std::isnan( c.maxAbs ) );
+        perfect[ (2 * 700) + 1 ] = real( 0.5 );
+        EXPECT_EQ( parallel.evaluate( *model, set ).maxAbs, std::numeric_limits<real>::infinity( ) );
+    }
+
+    TEST( MachineLearningTests, AdaptiveSampler ) {
+        using namespace Core;
+
+        AdaptiveSampler::Config config;
+        config.cellsPerDimension = 10;
+        config.uniformFraction   = real( 0.1 );
+        AdaptiveSampler sampler( { real( -1 ) }, { real( 1 ) }, config );
+        EXPECT_EQ( sampler.getCellCount( ), 10u );
+
+        // nothing recorded yet, so the draws are uniform
+        std::vector<real> xs( 1000 );
+        sampler.sample( xs.size( ), xs.data( ) );
+        for( auto &&p : sampler.getCellProbabilities( ) ) { EXPECT_NEAR( p, real( 0.1 ), 1e-6 ); }
+
+        // residuals from a Sobol validation pass, big in [ 0.4, 0.6 ) and small elsewhere
+        std::vector<real> validation( 256 ), errors( 256 );
+        sampler.sampleSobol( validation.size( ), validation.data( ) );
+        for( size_t i = 0; i < validation.size( ); ++i ) {
+            EXPECT_GE( validation[ i ], real( -1 ) );
+            EXPECT_LT( validation[ i ], real( 1 ) );
+            const bool bad = validation[ i ] >= real( 0.4 ) && validation[ i ] < real( 0.6 );
+            errors[ i ] = bad ? real( 1 ) : real( 0.01 );
+        }
+        sampler.recordResiduals( validation.size( ), validation.data( ), errors.data( ) );
+        EXPECT_NEAR( sampler.getErrorMap( )[ 7 ], real( 1 ), 1e-5 );
+        EXPECT_NEAR( sampler.getErrorMap( )[ 0 ], real( 0.01 ), 1e-5 );
+
+        // 90% by error, 1 / ( 1 + 9 * 0.01 ) of that in the bad cell, plus its uniform tenth of the rest
+        const real expected      = (real( 0.9 ) / real( 1.09 )) + real( 0.01 );
+        const auto probabilities = sampler.getCellProbabilities( );
+        EXPECT_NEAR( probabilities[ 7 ], expected, 1e-5 );
+        EXPECT_NEAR( probabilities[ 0 ], (real( 0.9 ) * real( 0.01 ) / real( 1.09 )) + real( 0.01 ), 1e-5 );
+
+        sampler.sample( xs.size( ), xs.data( ) );
+        size_t inside = 0;
+        for( auto &&x : xs ) {
+            EXPECT_GE( x, real( -1 ) );
+            EXPECT_LE( x, real( 1 ) );
+            inside += (x >= real( 0.4 ) && x < real( 0.6 )) ? 1 : 0;
+        }
+        // quasi random draws track the distribution closely
+        EXPECT_NEAR( real( inside ) / real( xs.size( ) ), expected, 0.01 );
+
+        // newer residuals blend with the old estimate
+        const real x = real( 0.5 ), small = real( 0.2 );
+        sampler.recordResiduals( 1, &x, &small );
+        EXPECT_NEAR( sampler.getErrorMap( )[ 7 ], real( 0.6 ), 1e-5 );
+
+        // two dimensions, cells are first dimension fastest
+        config.cellsPerDimension = 4;
+        AdaptiveSampler plane( { real( 0 ), real( 0 ) }, { real( 1 ), real( 2 ) }, config );
+        const real corner[2] = { real( 0.9 ), real( 0.1 ) }, one = real( 1 );
+        plane.recordResiduals( 1, corner, &one );
+        EXPECT_EQ( plane.getErrorMap( )[ 3 ], real( 1 ) );
+    }
+
+    TEST( MachineLearningTests, DataParallelTrainer ) {
+        using namespace Core;
+
+        const size_t      sampleCount = 100, ranks = 3, batchSize = 8, epochs = 3;
+        std::vector<real> xs( sampleCount ), ys( sampleCount );
+        for( size_t i = 0; i < sampleCount; ++i ) {
+            xs[ i ] = real( -1 ) + (real( 2 ) * real( i ) / real( sampleCount - 1 ));
+            ys[ i ] = real( 0.5 ) + (real( 0.4 ) * std::sin( real( 3 ) * xs[ i ] ));
+        }
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t i = 0; i < sampleCount; ++i ) { set.emplace_back( &xs[ i ], &ys[ i ] ); }
+
+        auto build = []( ANNetwork &ann, const size_t maxBatchSize, const uint64_t seed ) {
+            auto inLayer   = std::make_shared<InputLayer>( 1 );
+            auto hidLayer0 = std::make_shared<HiddenLayer>( 8, ActivationFunctionType::HyperbolicTangent );
+            auto hidLayer1 = std::make_shared<HiddenLayer>( 8, ActivationFunctionType::HyperbolicTangent );
+            auto outLayer  = std::make_shared<OutputLayer>( 1 );
+            ann.addLayer( inLayer );
+            ann.addLayer( hidLayer0 );
+            ann.addLayer( hidLayer1 );
+            ann.addLayer( outLayer );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, hidLayer0 ) );
+            ann.connectLayers( std::make_shared<Connections>( hidLayer0, hidLayer1 ) );
+            ann.connectLayers( std::make_shared<Connections>( hidLayer1, outLayer ) );
+            ann.finalise( true, maxBatchSize );
+            RandomStream stream( seed, 0 );
+            ann.setRandomWeights( stream );
+        };
+
+        // one process with batches as big as every ranks together
+        ANNetwork single{ };
+        build( single, batchSize * ranks, 0xDA7A );
+        for( size_t e = 0; e < epochs; ++e ) { single.trainEpoch( set ); }
+        const auto expected = single.getWeights( );
+
+        for( const bool overlap : { true, false } ) {
+            const std::string name = "funcapprox-dp-" + std::to_string( ::getpid( ) ) + (overlap ? "-o" : "-s");
+            EXPECT_TRUE( runRanks( ranks, [ & ]( const size_t rank ) {
+                SharedMemoryTransport::Config transportConfig;
+                transportConfig.rank = rank;
+                transportConfig.size = ranks;
+                transportConfig.name = name;
+                SharedMemoryTransport transport( transportConfig );
+                if( !transport.open( ) ) { return 1; }
+
+                // different starting weights until rank 0s are broadcast
+                ANNetwork replica{ };
+                build( replica, batchSize, 0xDA7A + rank );
+
+                DataParallelTrainer::Config config;
+                config.bucketBytes = 1; // a bucket per connection
+                config.overlap     = overlap;
+                DataParallelTrainer trainer( replica, transport, config );
+                if( trainer.getBucketCount( ) != 3 || !trainer.broadcastWeights( ) ) { return 2; }
+
+                const auto shard = DataParallelTrainer::shard( set, rank, ranks, batchSize );
+                for( size_t e = 0; e < epochs; ++e ) {
+                    const auto result = trainer.trainEpoch( shard );
+                    if( !result.ok || result.samples != sampleCount || result.steps != 5 ) { return 3; }
+                }
+
+                // every replica bit identical, and the same as the big batch run up to summation order
+                const auto        weights = replica.getWeights( );
+                const size_t      bytes   = weights.size( ) * sizeof( real );
+                std::vector<real> previous( weights.size( ) );
+                if( !transport.exchange( weights.data( ), bytes, previous.data( ), bytes ) ) { return 4; }
+                if( previous != weights ) { return 5; }
+                for( size_t i = 0; i < weights.size( ); ++i ) {
+                    if( std::fabs( weights[ i ] - expected[ i ] ) > real( 1e-4 ) ) { return 6; }
+                }
+                return 0;
+            } ) ) << overlap;
+        }
+    }
+
+    TEST( MachineLearningTests, DAGTopology ) {
+        using namespace Core;
+
+        // two branches off the input merge (with a skip from the input too) into a trunk, plus a second head
+        // reading a branch directly
+        const size_t batch = 4, inCount = 2, outCount = 3;
+        auto build = [ & ]( ANNetwork &ann ) {
+            auto inLayer   = std::make_shared<InputLayer>( inCount );
+            auto branch0   = std::make_shared<HiddenLayer>( 6, ActivationFunctionType::HyperbolicTangent );
+            auto branch1   = std::make_shared<HiddenLayer>( 5, ActivationFunctionType::Sigmoid );
+            auto trunk     = std::make_shared<HiddenLayer>( 4, ActivationFunctionType::HyperbolicTangent );
+            auto outLayer0 = std::make_shared<OutputLayer>( 1 );
+            auto outLayer1 = std::make_shared<OutputLayer>( 2 );
+            ann.addLayer( inLayer );
+            ann.addLayer( branch0 );
+            ann.addLayer( branch1 );
+            ann.addLayer( trunk );
+            ann.addLayer( outLayer0 );
+            ann.addLayer( outLayer1 );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, branch0 ) );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, branch1 ) );
+            ann.connectLayers( std::make_shared<Connections>( branch0, trunk ) );
+            ann.connectLayers( std::make_shared<Connections>( branch1, trunk ) );
+            ann.connectLayers( std::make_shared<Connections>( inLayer, trunk ) );
+            ann.connectLayers( std::make_shared<Connections>( trunk, outLayer0 ) );
+            ann.connectLayers( std::make_shared<Connections>( branch0, outLayer1 ) );
+            ann.finalise( true, batch );
+
+            RandomStream      stream( 0xDA6, 0 );
+            std::vector<real> weights( ann.getTotalWeightCount( ) );
+            stream.fillUniform( weights.size( ), real( -1 ), real( 1 ), weights.data( ) );
+            ann.setWeights( weights );
+        };
+
+        ANNetwork ann{ };
+        build( ann );
+        EXPECT_EQ( ann.getInputCount( ), inCount );
+        EXPECT_EQ( ann.getOutputCount( ), outCount );
+
+        RandomStream      stream( 0xDA7, 0 );
+        std::vector<real> inputs( batch * inCount ), perfect( batch * outCount ), results( batch * outCount );
+        stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+        stream.fillUniform( perfect.size( ), real( 0 ), real( 1 ), perfect.data( ) );
+
+        ann.evaluate( batch, inputs.data( ), results.data( ) );
+        ann.computeGradients( batch, perfect.data( ) );
+        const auto gradients = ann.getGradients( );
+
+        // central differences of E = 1/2 sum ( result - perfect )^2 over the batch
+        const auto error = [ & ]( const std::vector<real> &weights ) {
+            ann.setWeights( weights );
+            std::vector<real> out( batch * outCount );
+            ann.evaluate( batch, inputs.data( ), out.data( ) );
+            double e = 0.0;
+            for( size_t i = 0; i < out.size( ); ++i ) {
+                const double d = double( out[ i ] ) - double( perfect[ i ] );
+                e += 0.5 * d * d;
+            }
+            return e;
+        };
+        const auto weights = ann.getWeights( );
+        const real h       = real( 1e-2 );
+        for( size_t i = 0; i < weights.size( ); ++i ) {
+            auto plus = weights, minus = weights;
+            plus[ i ] += h;
+            minus[ i ] -= h;
+            EXPECT_NEAR( (error( plus ) - error( minus )) / (2.0 * h), gradients[ i ], 2e-3 ) << i;
+        }
+        ann.setWeights( weights );
+
+        // the model runs the same schedule as a step list, and survives a save and load
+        const auto model = ann.createModel( );
+        EXPECT_FALSE( model->isChain( ) );
+        std::vector<real> modelResults( batch * outCount );
+        {
+            InferenceSession session( model, batch );
+            session.evaluate( batch, inputs.data( ), modelResults.data( ) );
+            for( size_t i = 0; i < results.size( ); ++i ) { EXPECT_FLOAT_EQ( modelResults[ i ], results[ i ] ) << i; }
+        }
+        std::stringstream file;
+        ASSERT_TRUE( model->save( file ) );
+        const auto loaded = Model::load( file );
+        ASSERT_NE( loaded, nullptr );
+        ASSERT_EQ( loaded->getSteps( ).size( ), model->getSteps( ).size( ) );
+
+        // sizes the payload doesn't back are refused before anything is allocated from them
+        const auto        bytes = file.str( );
+        std::stringstream truncated( bytes.substr( 0, bytes.size( ) - sizeof( real ) ) );
+        EXPECT_EQ( Model::load( truncated ), nullptr );
+        auto           oversized    = bytes;
+        const uint64_t weightCount  = std::numeric_limits<uint64_t>::max( ) / 2;
+        const size_t   weightOffset = 12 + (5 * sizeof( uint64_t )); // magic, version, real size then the counts
+        std::memcpy( &oversized[ weightOffset ], &weightCount, sizeof( weightCount ) );
+        std::stringstream oversizedFile( oversized );
+        EXPECT_EQ( Model::load( oversizedFile ), nullptr );
+        {
+            InferenceSession  session( loaded, batch );
+            std::vector<real> loadedResults( batch * outCount );
+            session.evaluate( batch, inputs.data( ), loadedResults.data( ) );
+            EXPECT_EQ( loadedResults, modelResults );
+        }
+
+        // independent branches on a pool give exactly what the calling thread does
+        ANNetwork pooled{ };
+        build( pooled );
+        pooled.setThreadPool( std::make_shared<ThreadPool>( 3 ) );
+        std::vector<real> pooledResults( batch * outCount );
+        pooled.evaluate( batch, inputs.data( ), pooledResults.data( ) );
+        pooled.computeGradients( batch, perfect.data( ) );
+        EXPECT_EQ( pooledResults, results );
+        EXPECT_EQ( pooled.getGradients( ), gradients );
+
+        // and it trains, both heads at once
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t b = 0; b < batch; ++b ) {
+            set.emplace_back( inputs.data( ) + (b * inCount), perfect.data( ) + (b * outCount) );
+        }
+        const real before = pooled.testError( set );
+        for( int e = 0; e < 50; ++e ) { pooled.trainEpoch( set ); }
+        EXPECT_LT( pooled.testError( set ), before );
+    }
+
+    TEST( MachineLearningTests, PipelineTrainer ) {
+        using namespace Core;
+
+        const size_t      sampleCount = 100, microBatchSize = 4, microBatchCount = 3, epochs = 3;
+        std::vector<real> xs( sampleCount ), ys( sampleCount );
+        for( size_t i = 0; i < sampleCount; ++i ) {
+            xs[ i ] = real( -1 ) + (real( 2 ) * real( i ) / real( sampleCount - 1 ));
+            ys[ i ] = real( 0.5 ) + (real( 0.4 ) * std::sin( real( 3 ) * xs[ i ] ));
+        }
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t i = 0; i < sampleCount; ++i ) { set.emplace_back( &xs[ i ], &ys[ i ] ); }
+
+        auto build = []( ANNetwork &ann, const size_t maxBatchSize, const bool transposed ) {
+            auto inLayer = std::make_shared<InputLayer>( 1 );
+            ann.addLayer( inLayer );
+            Layer::shared_ptr previous = inLayer;
+            for( size_t width : { 8, 12, 6 } ) {
+                auto hidLayer = std::make_shared<HiddenLayer>( width, ActivationFunctionType::HyperbolicTangent );
+                ann.addLayer( hidLayer );
+                ann.connectLayers( std::make_shared<Connections>( previous, hidLayer ) );
+                previous = hidLayer;
+            }
+            auto outLayer = std::make_shared<OutputLayer>( 1 );
+            ann.addLayer( outLayer );
+            ann.connectLayers( std::make_shared<Connections>( previous, outLayer ) );
+            ann.setTransposedBackpropWeights( transposed );
+            ann.finalise( true, maxBatchSize );
+            RandomStream stream( 0x919E, 0 );
+            ann.setRandomWeights( stream );
+        };
+
+        // one thread with batches as big as a whole step
+        ANNetwork single{ };
+        build( single, microBatchSize * microBatchCount, true );
+        real singleRms = 0;
+        for( size_t e = 0; e < epochs; ++e ) { singleRms = single.trainEpoch( set ); }
+        const auto expected = single.getWeights( );
+
+        for( const size_t stageCount : { 1, 2, 4 } ) {
+            for( const bool transposed : { true, false } ) {
+                ANNetwork ann{ };
+                build( ann, microBatchSize, transposed );
+
+                PipelineTrainer::Config config;
+                config.stageCount      = stageCount;
+                config.microBatchCount = microBatchCount;
+                PipelineTrainer trainer( ann, config );
+                ASSERT_EQ( trainer.getStageCount( ), stageCount );
+                size_t connections = 0;
+                for( size_t s = 0; s < stageCount; ++s ) {
+                    EXPECT_GT( trainer.getStageConnectionCount( s ), 0u );
+                    EXPECT_GT( trainer.getStageMemoryBytes( s ), 0u );
+                    connections += trainer.getStageConnectionCount( s );
+                }
+                EXPECT_EQ( connections, 4u );
+
+                // the last step is a single short micro batch
+                PipelineTrainer::Result result;
+                for( size_t e = 0; e < epochs; ++e ) { result = trainer.trainEpoch( set ); }
+                EXPECT_EQ( result.steps, 9u );
+                EXPECT_EQ( result.samples, sampleCount );
+                EXPECT_NEAR( result.rms, singleRms, 1e-4 );
+
+                const auto weights = ann.getWeights( );
+                for( size_t i = 0; i < weights.size( ); ++i ) {
+                    EXPECT_NEAR( weights[ i ], expected[ i ], 1e-4 ) << stageCount << " " << i;
+                }
+            }
+        }
+    }
+
+    TEST( MachineLearningTests, GradientCheckpointing ) {
+        using namespace Core;
+
+        const size_t batch = 8, width = 16, depth = 12;
+        auto build = [ & ]( ANNetwork &ann, const size_t budget ) {
+            auto inLayer = std::make_shared<InputLayer>( 2 );
+            ann.addLayer( inLayer );
+            Layer::shared_ptr previous = inLayer;
+            for( size_t d = 0; d < depth; ++d ) {
+                auto hidLayer = std::make_shared<HiddenLayer>( width, ActivationFunctionType::HyperbolicTangent );
+                ann.addLayer( hidLayer );
+                ann.connectLayers( std::make_shared<Connections>( previous, hidLayer ) );
+                previous = hidLayer;
+            }
+            auto outLayer = std::make_shared<OutputLayer>( 2 );
+            ann.addLayer( outLayer );
+            ann.connectLayers( std::make_shared<Connections>( previous, outLayer ) );
+            ann.setActivationMemoryBudget( budget );
+            ann.finalise( true, batch );
+
+            RandomStream      stream( 0xC4EC, 0 );
+            std::vector<real> weights( ann.getTotalWeightCount( ) );
+            stream.fillUniform( weights.size( ), real( -0.5 ), real( 0.5 ), weights.data( ) );
+            ann.setWeights( weights );
+        };
+        const auto activationBytes = []( const ANNetwork &ann ) {
+            const auto usage = ann.getMemoryUsage( );
+            return usage.activations + usage.preActivations + usage.deltas;
+        };
+
+        RandomStream      stream( 0xC4ED, 0 );
+        std::vector<real> inputs( batch * 4 * 2 ), perfect( batch * 4 * 2 );
+        stream.fillUniform( inputs.size( ), real( -1 ), real( 1 ), inputs.data( ) );
+        stream.fillUniform( perfect.size( ), real( -0.5 ), real( 0.5 ), perfect.data( ) );
+        std::vector<ANNetwork::MatchingPair> set;
+        for( size_t i = 0; i < batch * 4; ++i ) { set.emplace_back( &inputs[ i * 2 ], &perfect[ i * 2 ] ); }
+
+        ANNetwork full{ };
+        build( full, 0 );
+        const size_t fullBytes = activationBytes( full );
+        EXPECT_EQ( full.getCheckpointLayers( ).size( ), depth + 2 );
+
+        std::vector<real> expected( batch * 2 );
+        full.evaluate( batch, inputs.data( ), expected.data( ) );
+        full.computeGradients( batch, perfect.data( ) );
+        const auto expectedGradients = full.getGradients( );
+        for( int e = 0; e < 3; ++e ) { full.trainEpoch( set ); }
+
+        // a roomy budget keeps everything, a tight one checkpoints and one nothing can meet keeps the least it can
+        size_t previousBytes = fullBytes + 1;
+        for( const size_t budget : { fullBytes * 2, fullBytes * 3 / 5, size_t( 1 ) } ) {
+            ANNetwork ann{ };
+            build( ann, budget );
+            const size_t bytes = activationBytes( ann );
+            EXPECT_LT( bytes, previousBytes );
+            if( budget >= fullBytes ) {
+                EXPECT_EQ( bytes, fullBytes );
+            } else if( budget > 1 ) {
+                EXPECT_LE( bytes, budget );
+                EXPECT_LT( ann.getCheckpointLayers( ).size( ), depth + 2 );
+            }
+            previousBytes = bytes;
+
+            // recomputing runs exactly the same kernels so nothing changes, not even rounding
+            std::vector<real> results( batch * 2 );
+            ann.evaluate( batch, inputs.data( ), results.data( ) );
+            ann.computeGradients( batch, perfect.data( ) );
+            EXPECT_EQ( results, expected );
+            EXPECT_EQ( ann.getGradients( ), expectedGradients );
+            ann.setWeights( ann.getWeights( ) ); // drops nothing, the update below starts from the same state
+            for( int e = 0; e < 3; ++e ) { ann.trainEpoch( set ); }
+            EXPECT_EQ( ann.getWeights( ), full.getWeights( ) ) << budget;
+        }
+    }
+}